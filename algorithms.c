@@ -1,4 +1,5 @@
 #include "algorithms.h"
+#include "ant_logic.h"
 #include "config.h"
 #include "utils.h"
 #include "world.h"
@@ -75,48 +76,40 @@ Ant* binary_search_ant_by_id(Ant** sorted_ants, int count, int target_id) {
     return NULL; // Ant not found
 }
 
-Ant* linear_search_ant_by_id(Ant* head, int target_id) {
-    if (head == NULL) return NULL;
+int linear_search_ant_by_id(const Colony* colony, int target_id) {
+    if (colony == NULL) return -1;
     
-    Ant* current = head;
-    while (current != NULL) {
-        if (current->id == target_id) {
-            return current;
+    const int* ids = colony->ants.ids;
+    for (int slot = 0; slot < colony->ants.count; slot++) {
+        if (ids[slot] == target_id) {
+            return slot;
         }
-        current = current->next;
     }
     
-    return NULL; // Ant not found
+    return -1; // Ant not found
 }
 
-// Linked list utilities
-Ant** list_to_array(Ant* head, int* count) {
-    if (head == NULL || count == NULL) return NULL;
-    
-    // Count ants in list
-    *count = 0;
-    Ant* current = head;
-    while (current != NULL) {
-        (*count)++;
-        current = current->next;
-    }
+// Ant pool utilities
+// The array is one block: count pointers, then the count ants they point
+// at, so free_ant_array releases both
+Ant** colony_ants_to_array(const Colony* colony, int* count) {
+    if (colony == NULL || count == NULL) return NULL;
     
+    *count = colony->ants.count;
     if (*count == 0) return NULL;
     
-    // Allocate array of ant pointers
-    Ant** array = (Ant**)safe_malloc(*count * sizeof(Ant*));
+    // Allocate the pointers and the ant copies together
+    Ant** array = (Ant**)safe_malloc(*count * (sizeof(Ant*) + sizeof(Ant)));
     if (array == NULL) {
         *count = 0;
         return NULL;
     }
     
-    // Fill array with ant pointers
-    current = head;
-    int index = 0;
-    while (current != NULL && index < *count) {
-        array[index] = current;
-        current = current->next;
-        index++;
+    // Fill array with copies of the pool's ants, in slot order
+    Ant* ants = (Ant*)(array + *count);
+    for (int slot = 0; slot < *count; slot++) {
+        load_ant(colony, slot, &ants[slot]);
+        array[slot] = &ants[slot];
     }
     
     return array;
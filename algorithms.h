@@ -10,10 +10,10 @@ void sort_ants_by_efficiency(Ant** ants, int count);
 
 // Searching algorithms
 Ant* binary_search_ant_by_id(Ant** sorted_ants, int count, int target_id);
-Ant* linear_search_ant_by_id(Ant* head, int target_id);
+int linear_search_ant_by_id(const Colony* colony, int target_id);  // Slot in the pool, -1 if none
 
-// Linked list utilities
-Ant** list_to_array(Ant* head, int* count);
+// Ant pool utilities
+Ant** colony_ants_to_array(const Colony* colony, int* count);  // Copies, sortable by pointer
 void free_ant_array(Ant** array);
 
 // Pathfinding algorithms
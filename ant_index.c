@@ -0,0 +1,301 @@
+#include "ant_index.h"
+#include "ant_logic.h"
+#include "config.h"
+#include "utils.h"
+#include "world.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CELL_KEY_BITS (2 * CHUNK_SHIFT)
+
+// Index key of a cell: directory index, then row-major cell in the chunk
+static uint32_t cell_key(const World* world, int x, int y) {
+    uint32_t chunk = (uint32_t)(CHUNK_COORD(y) * world->chunks_x + CHUNK_COORD(x));
+    uint32_t cell = (uint32_t)(((y & CHUNK_MASK) << CHUNK_SHIFT) | (x & CHUNK_MASK));
+    return (chunk << CELL_KEY_BITS) | cell;
+}
+
+// Grows the entry buffers to hold count ants. Returns 1 on success.
+static int reserve_ant_index(AntIndex* index, int count) {
+    if (count <= index->capacity) return 1;
+    
+    int capacity = index->capacity ? index->capacity : 1024;
+    while (capacity < count) capacity *= 2;
+    
+    AntRef* ants = (AntRef*)safe_realloc(index->ants, capacity * sizeof(AntRef));
+    if (ants == NULL) return 0;
+    index->ants = ants;
+    AntRef* scratch_ants = (AntRef*)safe_realloc(index->scratch_ants, capacity * sizeof(AntRef));
+    if (scratch_ants == NULL) return 0;
+    index->scratch_ants = scratch_ants;
+    uint32_t* keys = (uint32_t*)safe_realloc(index->keys, capacity * sizeof(uint32_t));
+    if (keys == NULL) return 0;
+    index->keys = keys;
+    uint32_t* scratch_keys = (uint32_t*)safe_realloc(index->scratch_keys, capacity * sizeof(uint32_t));
+    if (scratch_keys == NULL) return 0;
+    index->scratch_keys = scratch_keys;
+    
+    index->capacity = capacity;
+    return 1;
+}
+
+// Index maintenance
+// Collects every live ant and sorts them by cell key with two stable
+// counting passes: by cell inside the chunk, then by chunk. The second
+// pass's prefix sums are the chunk offsets.
+void build_ant_index(World* world) {
+    if (world == NULL) return;
+    
+    AntIndex* index = &world->ant_index;
+    int directory = world->chunks_x * world->chunks_y;
+    if (index->chunk_start == NULL) {
+        index->chunk_start = (int*)safe_calloc(directory + 1, sizeof(int));
+        index->colony_totals = (int*)safe_calloc(world->colony_count, sizeof(int));
+        if (index->chunk_start == NULL || index->colony_totals == NULL) {
+            free_ant_index(index);
+            return;
+        }
+    }
+    
+    // The pools hold every ant, dead ones included until the next cleanup
+    int bound = 0;
+    for (int c = 0; c < world->colony_count; c++) {
+        bound += world->colonies[c].ants.count;
+    }
+    if (!reserve_ant_index(index, bound)) {
+        index->count = 0;
+        return;
+    }
+    
+    // Gather keys in colony order, each pool's arrays read front to back
+    int n = 0;
+    for (int c = 0; c < world->colony_count; c++) {
+        const AntPool* pool = &world->colonies[c].ants;
+        int first = n;
+        for (int slot = 0; slot < pool->count; slot++) {
+            if (pool->states[slot] & ANT_STATE_DEAD) continue;
+            index->scratch_ants[n].colony = c;
+            index->scratch_ants[n].slot = slot;
+            index->scratch_keys[n] = cell_key(world, pool->positions[slot].x, pool->positions[slot].y);
+            n++;
+        }
+        index->colony_totals[c] = n - first;
+    }
+    
+    // Pass 1: by cell inside the chunk, scratch -> entries
+    static int cell_start[CHUNK_CELLS];
+    memset(cell_start, 0, sizeof(cell_start));
+    for (int i = 0; i < n; i++) {
+        cell_start[index->scratch_keys[i] & (CHUNK_CELLS - 1)]++;
+    }
+    int offset = 0;
+    for (int cell = 0; cell < CHUNK_CELLS; cell++) {
+        int count = cell_start[cell];
+        cell_start[cell] = offset;
+        offset += count;
+    }
+    for (int i = 0; i < n; i++) {
+        int slot = cell_start[index->scratch_keys[i] & (CHUNK_CELLS - 1)]++;
+        index->ants[slot] = index->scratch_ants[i];
+        index->keys[slot] = index->scratch_keys[i];
+    }
+    
+    // Pass 2: by chunk, entries -> scratch, then swap the buffers
+    int* chunk_start = index->chunk_start;
+    memset(chunk_start, 0, (directory + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        chunk_start[(index->keys[i] >> CELL_KEY_BITS) + 1]++;
+    }
+    for (int chunk = 0; chunk < directory; chunk++) {
+        chunk_start[chunk + 1] += chunk_start[chunk];
+    }
+    for (int i = 0; i < n; i++) {
+        int slot = chunk_start[index->keys[i] >> CELL_KEY_BITS]++;
+        index->scratch_ants[slot] = index->ants[i];
+        index->scratch_keys[slot] = index->keys[i];
+    }
+    // The scatter advanced each start to the next chunk's start
+    for (int chunk = directory; chunk > 0; chunk--) {
+        chunk_start[chunk] = chunk_start[chunk - 1];
+    }
+    chunk_start[0] = 0;
+    
+    AntRef* ants = index->ants;
+    index->ants = index->scratch_ants;
+    index->scratch_ants = ants;
+    uint32_t* keys = index->keys;
+    index->keys = index->scratch_keys;
+    index->scratch_keys = keys;
+    
+    index->count = n;
+    index->step = world->current_step;
+}
+
+void free_ant_index(AntIndex* index) {
+    if (index == NULL) return;
+    
+    safe_free(index->ants);
+    safe_free(index->keys);
+    safe_free(index->scratch_ants);
+    safe_free(index->scratch_keys);
+    safe_free(index->chunk_start);
+    safe_free(index->colony_totals);
+    memset(index, 0, sizeof(AntIndex));
+    index->step = -1;
+}
+
+// First entry in [begin, end) whose key is not below key
+static int lower_bound_key(const AntIndex* index, int begin, int end, uint32_t key) {
+    while (begin < end) {
+        int mid = begin + (end - begin) / 2;
+        if (index->keys[mid] < key) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+// Range of entries keyed between cells (x0, y) and (x1, y) of one chunk row
+static int row_range(const World* world, int x0, int x1, int y, int* end) {
+    const AntIndex* index = &world->ant_index;
+    int chunk = CHUNK_COORD(y) * world->chunks_x + CHUNK_COORD(x0);
+    int begin = lower_bound_key(index, index->chunk_start[chunk], index->chunk_start[chunk + 1],
+                                cell_key(world, x0, y));
+    *end = lower_bound_key(index, begin, index->chunk_start[chunk + 1], cell_key(world, x1, y) + 1);
+    return begin;
+}
+
+// Index queries
+static const Position* ant_position(const World* world, AntRef ant) {
+    return &world->colonies[ant.colony].ants.positions[ant.slot];
+}
+
+// Returns the number of ants on (x, y) and points first at the first of
+// them; the rest follow contiguously, in colony order
+int get_ants_at(const World* world, int x, int y, const AntRef** first) {
+    if (world == NULL || world->ant_index.count == 0 || !is_valid_position(world, x, y)) return 0;
+    
+    int end;
+    int begin = row_range(world, x, x, y, &end);
+    if (first != NULL) *first = world->ant_index.ants + begin;
+    return end - begin;
+}
+
+// Fills counts[colony_count] with the ants of each colony on (x, y) and
+// returns their total
+int count_colony_ants_at(const World* world, int x, int y, int* counts) {
+    if (world == NULL || counts == NULL) return 0;
+    
+    memset(counts, 0, world->colony_count * sizeof(int));
+    const AntRef* ants;
+    int total = get_ants_at(world, x, y, &ants);
+    for (int i = 0; i < total; i++) {
+        counts[ants[i].colony]++;
+    }
+    return total;
+}
+
+// Collects up to max_results ants within radius cells of (x, y). Each row
+// of each overlapping chunk is one binary-searched run of entries. Returns
+// the number of ants in range, which may exceed max_results.
+int find_ants_in_radius(const World* world, int x, int y, int radius, AntRef* out, int max_results) {
+    if (world == NULL || radius < 0 || world->ant_index.count == 0) return 0;
+    
+    if (x + radius < 0 || x - radius >= world->width || y + radius < 0 || y - radius >= world->height) {
+        return 0;
+    }
+    
+    const AntIndex* index = &world->ant_index;
+    long long radius_sq = (long long)radius * radius;
+    int min_x = clamp_int(x - radius, 0, world->width - 1);
+    int max_x = clamp_int(x + radius, 0, world->width - 1);
+    int min_y = clamp_int(y - radius, 0, world->height - 1);
+    int max_y = clamp_int(y + radius, 0, world->height - 1);
+    int found = 0;
+    
+    for (int row = min_y; row <= max_y; row++) {
+        long long ddy = row - y;
+        for (int cx = CHUNK_COORD(min_x); cx <= CHUNK_COORD(max_x); cx++) {
+            int chunk = CHUNK_COORD(row) * world->chunks_x + cx;
+            if (index->chunk_start[chunk] == index->chunk_start[chunk + 1]) continue;
+            
+            int x0 = cx * CHUNK_SIZE > min_x ? cx * CHUNK_SIZE : min_x;
+            int x1 = cx * CHUNK_SIZE + CHUNK_SIZE - 1 < max_x ? cx * CHUNK_SIZE + CHUNK_SIZE - 1 : max_x;
+            int end;
+            for (int i = row_range(world, x0, x1, row, &end); i < end; i++) {
+                long long ddx = ant_position(world, index->ants[i])->x - x;
+                if (ddx * ddx + ddy * ddy > radius_sq) continue;
+                if (out != NULL && found < max_results) out[found] = index->ants[i];
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+// Squared distance from (x, y) to the nearest cell of chunk (cx, cy)
+static long long chunk_distance_sq(int x, int y, int cx, int cy) {
+    int left = cx * CHUNK_SIZE;
+    int top = cy * CHUNK_SIZE;
+    long long gap_x = (x < left) ? left - x : (x >= left + CHUNK_SIZE ? x - (left + CHUNK_SIZE - 1) : 0);
+    long long gap_y = (y < top) ? top - y : (y >= top + CHUNK_SIZE ? y - (top + CHUNK_SIZE - 1) : 0);
+    return gap_x * gap_x + gap_y * gap_y;
+}
+
+static long long ant_distance_sq(const World* world, AntRef ant, int x, int y) {
+    const Position* pos = ant_position(world, ant);
+    long long ddx = pos->x - x;
+    long long ddy = pos->y - y;
+    return ddx * ddx + ddy * ddy;
+}
+
+// Fills out with the k ants closest to (x, y), nearest first. Chunks are searched in rings around the start, stopping
+// once the k-th best beats anything an unsearched ring can hold. Returns
+// the number found, less than k only when fewer ants exist.
+int find_nearest_ants(const World* world, int x, int y, int k, AntRef* out) {
+    if (world == NULL || out == NULL || k <= 0 || world->ant_index.count == 0) return 0;
+    
+    const AntIndex* index = &world->ant_index;
+    int start_cx = CHUNK_COORD(clamp_int(x, 0, world->width - 1));
+    int start_cy = CHUNK_COORD(clamp_int(y, 0, world->height - 1));
+    int max_ring = world->chunks_x > world->chunks_y ? world->chunks_x : world->chunks_y;
+    int found = 0;
+    long long worst_sq = 0;  // Distance of out[found - 1] once found == k
+    
+    for (int ring = 0; ring <= max_ring; ring++) {
+        // Every cell of ring r is at least (r - 1) chunks away
+        if (ring > 0 && found == k) {
+            long long reach = (long long)(ring - 1) * CHUNK_SIZE + 1;
+            if (reach * reach > worst_sq) break;
+        }
+        
+        for (int cy = start_cy - ring; cy <= start_cy + ring; cy++) {
+            // Interior rows only have the two side chunks
+            int step = (cy == start_cy - ring || cy == start_cy + ring) ? 1 : 2 * ring;
+            for (int cx = start_cx - ring; cx <= start_cx + ring; cx += step) {
+                if (cx < 0 || cx >= world->chunks_x || cy < 0 || cy >= world->chunks_y) continue;
+                int chunk = cy * world->chunks_x + cx;
+                if (index->chunk_start[chunk] == index->chunk_start[chunk + 1]) continue;
+                if (found == k && chunk_distance_sq(x, y, cx, cy) >= worst_sq) continue;
+                
+                for (int i = index->chunk_start[chunk]; i < index->chunk_start[chunk + 1]; i++) {
+                    AntRef ant = index->ants[i];
+                    long long dist_sq = ant_distance_sq(world, ant, x, y);
+                    if (found == k && dist_sq >= worst_sq) continue;
+                    
+                    // Insertion into the sorted result list
+                    int slot = (found < k) ? found++ : k - 1;
+                    while (slot > 0 && ant_distance_sq(world, out[slot - 1], x, y) > dist_sq) {
+                        out[slot] = out[slot - 1];
+                        slot--;
+                    }
+                    out[slot] = ant;
+                    if (found == k) worst_sq = ant_distance_sq(world, out[k - 1], x, y);
+                }
+            }
+        }
+    }
+    return found;
+}
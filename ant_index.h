@@ -0,0 +1,18 @@
+#ifndef ANT_INDEX_H
+#define ANT_INDEX_H
+
+#include "data_structures.h"
+
+// Index maintenance
+void build_ant_index(World* world);
+void free_ant_index(AntIndex* index);
+
+// Index queries. They describe the ants as of the last build_ant_index call;
+// distances are straight-line and do not wrap in a toroidal world. Ants
+// come back as AntRefs into the colony pools (load_ant reads one in full).
+int get_ants_at(const World* world, int x, int y, const AntRef** first);
+int count_colony_ants_at(const World* world, int x, int y, int* counts);
+int find_ants_in_radius(const World* world, int x, int y, int radius, AntRef* out, int max_results);
+int find_nearest_ants(const World* world, int x, int y, int k, AntRef* out);
+
+#endif // ANT_INDEX_H
@@ -11,68 +11,201 @@
 const int dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
 const int dy[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
 
-// Ant creation and management
-Ant* create_ant(int id, int colony_id, Position pos) {
-    Ant* ant = (Ant*)safe_malloc(sizeof(Ant));
-    if (ant == NULL) {
-        return NULL;
+// Set-bit lookup for walk masks: walk_count[m] directions are open in mask
+// m and walk_direction[m][k] is the k-th of them
+static uint8_t walk_count[256];
+static uint8_t walk_direction[256][8];
+static int walk_tables_ready = 0;
+
+static void init_walk_tables(void) {
+    for (int mask = 0; mask < 256; mask++) {
+        int count = 0;
+        for (int dir = 0; dir < 8; dir++) {
+            if (mask & (1 << dir)) {
+                walk_direction[mask][count++] = (uint8_t)dir;
+            }
+        }
+        walk_count[mask] = (uint8_t)count;
     }
+    walk_tables_ready = 1;
+}
+
+// Ant creation and management
+void init_ant(Ant* ant, int id, int colony_id, Position pos) {
+    if (ant == NULL) return;
     
     // Initialize ant properties
+    memset(ant, 0, sizeof(Ant));
     ant->id = id;
     ant->pos = pos;
     ant->last_pos = pos;
     ant->state = ANT_STATE_SEARCHING;  // Start searching for food
     ant->colony_id = colony_id;
     ant->energy = ANT_INITIAL_ENERGY;
-    ant->food_carrying = 0;
-    ant->steps_taken = 0;
-    ant->food_delivered = 0;
     ant->preferred_direction = -1;  // No preferred direction initially
-    ant->next = NULL;
-    ant->path_history = NULL;
     
-    print_info("Ant %d created for colony %d at (%d, %d)", id, colony_id, pos.x, pos.y);
-    return ant;
+    LOG_ANT_INFO("Ant %d created for colony %d at (%d, %d)", id, colony_id, pos.x, pos.y);
 }
 
-void destroy_ant(Ant* ant) {
-    if (ant == NULL) return;
-    
-    // Clear path history
-    clear_path_history(ant);
-    
-    // Free the ant
-    safe_free(ant);
+// Grows the pool's arrays to hold count ants. Returns 1 on success; on
+// failure the arrays already grown are kept and the capacity is unchanged.
+static int reserve_ant_pool(AntPool* pool, int count) {
+    if (count <= pool->capacity) return 1;
+    
+    int capacity = pool->capacity ? pool->capacity : 64;
+    while (capacity < count) capacity *= 2;
+    
+#define GROW_ANT_ARRAY(field) do { \
+        void* grown = safe_realloc(pool->field, capacity * sizeof(*pool->field)); \
+        if (grown == NULL) return 0; \
+        pool->field = grown; \
+    } while (0)
+    GROW_ANT_ARRAY(ids);
+    GROW_ANT_ARRAY(positions);
+    GROW_ANT_ARRAY(last_positions);
+    GROW_ANT_ARRAY(states);
+    GROW_ANT_ARRAY(energy);
+    GROW_ANT_ARRAY(food_carrying);
+    GROW_ANT_ARRAY(steps_taken);
+    GROW_ANT_ARRAY(food_delivered);
+    GROW_ANT_ARRAY(preferred_directions);
+    GROW_ANT_ARRAY(path_histories);
+#undef GROW_ANT_ARRAY
+    
+    pool->capacity = capacity;
+    return 1;
 }
 
-void add_ant_to_colony(Colony* colony, Ant* ant) {
-    if (colony == NULL || ant == NULL) return;
+static void free_path_nodes(PathNode* node) {
+    while (node != NULL) {
+        PathNode* next = node->next;
+        safe_free(node);
+        node = next;
+    }
+}
+
+// Frees the ant in slot and moves the last ant into it
+static void release_ant_slot(AntPool* pool, int slot) {
+    free_path_nodes(pool->path_histories[slot]);
+    
+    int last = --pool->count;
+    if (slot == last) return;
+    pool->ids[slot] = pool->ids[last];
+    pool->positions[slot] = pool->positions[last];
+    pool->last_positions[slot] = pool->last_positions[last];
+    pool->states[slot] = pool->states[last];
+    pool->energy[slot] = pool->energy[last];
+    pool->food_carrying[slot] = pool->food_carrying[last];
+    pool->steps_taken[slot] = pool->steps_taken[last];
+    pool->food_delivered[slot] = pool->food_delivered[last];
+    pool->preferred_directions[slot] = pool->preferred_directions[last];
+    pool->path_histories[slot] = pool->path_histories[last];
+}
+
+void load_ant(const Colony* colony, int slot, Ant* ant) {
+    const AntPool* pool = &colony->ants;
+    ant->id = pool->ids[slot];
+    ant->pos = pool->positions[slot];
+    ant->last_pos = pool->last_positions[slot];
+    ant->state = pool->states[slot];
+    ant->colony_id = colony->id;
+    ant->energy = pool->energy[slot];
+    ant->food_carrying = pool->food_carrying[slot];
+    ant->steps_taken = pool->steps_taken[slot];
+    ant->food_delivered = pool->food_delivered[slot];
+    ant->food_collected = 0;
+    ant->pheromone_strength = 0.0f;
+    ant->exploration_rate = 0.0f;
+    ant->preferred_direction = pool->preferred_directions[slot];
+    ant->path_history = pool->path_histories[slot];
+}
+
+void store_ant(Colony* colony, int slot, const Ant* ant) {
+    AntPool* pool = &colony->ants;
+    pool->ids[slot] = ant->id;
+    pool->positions[slot] = ant->pos;
+    pool->last_positions[slot] = ant->last_pos;
+    pool->states[slot] = ant->state;
+    pool->energy[slot] = ant->energy;
+    pool->food_carrying[slot] = ant->food_carrying;
+    pool->steps_taken[slot] = ant->steps_taken;
+    pool->food_delivered[slot] = ant->food_delivered;
+    pool->preferred_directions[slot] = (int8_t)ant->preferred_direction;
+    pool->path_histories[slot] = ant->path_history;
+}
+
+int add_ant_to_colony(Colony* colony, const Ant* ant) {
+    if (colony == NULL || ant == NULL) return -1;
+    if (!reserve_ant_pool(&colony->ants, colony->ants.count + 1)) return -1;
     
-    // Add to front of linked list
-    ant->next = colony->ants_head;
-    colony->ants_head = ant;
+    // Append to the pool
+    int slot = colony->ants.count++;
+    store_ant(colony, slot, ant);
     
     colony->total_ants++;
-    colony->active_ants++;
+    if (!(ant->state & ANT_STATE_DEAD)) {
+        colony->active_ants++;
+        if (ant->food_carrying > 0) colony->carrying_ants++;
+    }
     
-    print_info("Ant %d added to colony %d", ant->id, colony->id);
+    LOG_ANT_INFO("Ant %d added to colony %d", ant->id, colony->id);
+    return slot;
 }
 
-void remove_ant_from_colony(Colony* colony, Ant* ant) {
-    if (colony == NULL || ant == NULL) return;
+void remove_ant_from_colony(Colony* colony, int slot) {
+    if (colony == NULL || slot < 0 || slot >= colony->ants.count) return;
     
-    // Find and remove from linked list
-    Ant** current = &colony->ants_head;
-    while (*current != NULL && *current != ant) {
-        current = &(*current)->next;
+    AntPool* pool = &colony->ants;
+    LOG_ANT_INFO("Ant %d removed from colony %d", pool->ids[slot], colony->id);
+    colony->total_ants--;
+    if (!(pool->states[slot] & ANT_STATE_DEAD)) {
+        colony->active_ants--;
+        if (pool->food_carrying[slot] > 0) colony->carrying_ants--;
     }
+    release_ant_slot(pool, slot);
+}
+
+void clear_ant_pool(AntPool* pool) {
+    if (pool == NULL) return;
     
-    if (*current != NULL) {
-        *current = ant->next;
-        colony->active_ants--;
-        print_info("Ant %d removed from colony %d", ant->id, colony->id);
+    for (int slot = 0; slot < pool->count; slot++) {
+        free_path_nodes(pool->path_histories[slot]);
+    }
+    pool->count = 0;
+}
+
+void free_ant_pool(AntPool* pool) {
+    if (pool == NULL) return;
+    
+    clear_ant_pool(pool);
+    safe_free(pool->ids);
+    safe_free(pool->positions);
+    safe_free(pool->last_positions);
+    safe_free(pool->states);
+    safe_free(pool->energy);
+    safe_free(pool->food_carrying);
+    safe_free(pool->steps_taken);
+    safe_free(pool->food_delivered);
+    safe_free(pool->preferred_directions);
+    safe_free(pool->path_histories);
+    memset(pool, 0, sizeof(AntPool));
+}
+
+size_t get_ant_pool_memory_usage(const AntPool* pool) {
+    if (pool == NULL) return 0;
+    
+    // Every array holds capacity slots, used or not
+    size_t slot_bytes = sizeof(*pool->ids) + sizeof(*pool->positions) + sizeof(*pool->last_positions) +
+                        sizeof(*pool->states) + sizeof(*pool->energy) + sizeof(*pool->food_carrying) +
+                        sizeof(*pool->steps_taken) + sizeof(*pool->food_delivered) +
+                        sizeof(*pool->preferred_directions) + sizeof(*pool->path_histories);
+    size_t bytes = (size_t)pool->capacity * slot_bytes;
+    for (int slot = 0; slot < pool->count; slot++) {
+        for (const PathNode* node = pool->path_histories[slot]; node != NULL; node = node->next) {
+            bytes += sizeof(PathNode);
+        }
     }
+    return bytes;
 }
 
 // Ant movement
@@ -84,46 +217,63 @@ void move_ant(Ant* ant, World* world, int direction) {
     // Store last position
     ant->last_pos = ant->pos;
     
-    // Calculate new position
+    // Calculate new position (wrapping around in a toroidal world)
     int new_x = ant->pos.x + dx[direction];
     int new_y = ant->pos.y + dy[direction];
+    wrap_position(world, &new_x, &new_y);
     
-    // Check if new position is valid and walkable
-    if (is_valid_position(world, new_x, new_y) && is_walkable(world, new_x, new_y)) {
+    // Check if new position is walkable
+    Chunk* chunk = touch_chunk(world, ant->pos.x, ant->pos.y);
+    int local = CHUNK_LOCAL(ant->pos.x, ant->pos.y);
+    if (chunk != NULL && (chunk->walk_mask[local] & (1 << direction))) {
         ant->pos.x = new_x;
         ant->pos.y = new_y;
         ant->steps_taken++;
         
+        // Distance and territory for the colony statistics
+        Colony* colony = &world->colonies[ant->colony_id];
+        if (dx[direction] != 0 && dy[direction] != 0) {
+            colony->diagonal_moves++;
+        } else {
+            colony->straight_moves++;
+        }
+        Chunk* target = touch_chunk(world, new_x, new_y);
+        if (target != NULL) {
+            int16_t* owner = &target->territory[CHUNK_LOCAL(new_x, new_y)];
+            if (*owner != ant->colony_id) {
+                if (*owner >= 0) world->colonies[*owner].territory_size--;
+                colony->territory_size++;
+                *owner = (int16_t)ant->colony_id;
+            }
+        }
+        
         // Add to path history
-        add_path_node(ant, ant->pos, 0.0f);
+        if (world->record_paths) {
+            add_path_node(ant, ant->pos, 0.0f);
+        }
         
         LOG_ANT_INFO("Ant %d moved to (%d, %d)", ant->id, new_x, new_y);
     } else {
-        print_warning("Ant %d cannot move to (%d, %d)", new_x, new_y);
+        LOG_ANT_INFO("Ant %d cannot move to (%d, %d)", ant->id, new_x, new_y);
     }
 }
 
 void move_randomly(Ant* ant, World* world) {
     if (ant == NULL || world == NULL) return;
     
-    // Try random directions until we find a valid one
-    int attempts = 0;
-    const int max_attempts = 10;
+    Chunk* chunk = touch_chunk(world, ant->pos.x, ant->pos.y);
+    if (chunk == NULL) return;
+    if (!walk_tables_ready) init_walk_tables();
     
-    while (attempts < max_attempts) {
-        int direction = random_int(0, 7);
-        int new_x = ant->pos.x + dx[direction];
-        int new_y = ant->pos.y + dy[direction];
-        
-        if (is_valid_position(world, new_x, new_y) && is_walkable(world, new_x, new_y)) {
-            move_ant(ant, world, direction);
-            return;
-        }
-        attempts++;
+    // Pick uniformly among the walkable directions
+    uint8_t mask = chunk->walk_mask[CHUNK_LOCAL(ant->pos.x, ant->pos.y)];
+    if (mask == 0) {
+        LOG_ANT_INFO("Ant %d could not find valid random direction", ant->id);
+        return;
     }
     
-    // If no valid direction found, don't move
-    LOG_ANT_INFO("Ant %d could not find valid random direction", ant->id);
+    int direction = walk_direction[mask][random_int(0, walk_count[mask] - 1)];
+    move_ant(ant, world, direction);
 }
 
 void follow_pheromone_gradient(Ant* ant, World* world, int pheromone_type) {
@@ -132,18 +282,49 @@ void follow_pheromone_gradient(Ant* ant, World* world, int pheromone_type) {
     float max_pheromone = 0.0f;
     int best_direction = -1;
     
-    // Check all 8 neighboring cells
-    for (int dir = 0; dir < 8; dir++) {
-        int new_x = ant->pos.x + dx[dir];
-        int new_y = ant->pos.y + dy[dir];
-        
-        if (is_valid_position(world, new_x, new_y) && is_walkable(world, new_x, new_y)) {
-            float pheromone = get_pheromone_intensity(world, new_x, new_y, pheromone_type);
-            if (pheromone > max_pheromone) {
-                max_pheromone = pheromone;
+    Chunk* chunk = touch_chunk(world, ant->pos.x, ant->pos.y);
+    if (chunk == NULL) return;
+    int local = CHUNK_LOCAL(ant->pos.x, ant->pos.y);
+    
+    // The ant follows its colony's trail; without a channel here there is
+    // none to follow
+    PheromoneChannel* channel = get_pheromone_channel(chunk, PHEROMONE_CHANNEL_COLONY(world, ant->colony_id));
+    const PheromoneValue* plane = NULL;
+    if (channel != NULL && pheromone_type == PHEROMONE_TYPE_FOOD) plane = channel->pheromone_food;
+    else if (channel != NULL && pheromone_type == PHEROMONE_TYPE_HOME) plane = channel->pheromone_home;
+    
+    uint8_t mask = chunk->walk_mask[local];
+    int strongest = PHEROMONE_GRADIENT_NONE;
+    
+    if (get_pheromone_sense_radius() > 1) {
+        // Wide sensing: the walkable direction whose sector holds the most
+        float sectors[8];
+        get_pheromone_sectors(world, ant->pos.x, ant->pos.y, ant->colony_id, pheromone_type, sectors);
+        for (int dir = 0; dir < 8; dir++) {
+            if ((mask & (1 << dir)) && sectors[dir] > max_pheromone) {
+                max_pheromone = sectors[dir];
                 best_direction = dir;
             }
         }
+    } else if (plane != NULL) {
+        // The strongest neighbour is the answer whenever it is walkable
+        strongest = get_pheromone_gradient(world, channel, pheromone_type, local);
+    }
+    
+    if (strongest >= 0 && strongest != PHEROMONE_GRADIENT_NONE && (mask & (1 << strongest))) {
+        best_direction = strongest;
+        max_pheromone = PHEROMONE_LEVEL(world, channel, plane, local + neighbor_offset[strongest]);
+    } else if (strongest != PHEROMONE_GRADIENT_NONE) {
+        // Check all walkable neighboring cells
+        for (int dir = 0; dir < 8; dir++) {
+            if (mask & (1 << dir)) {
+                float pheromone = PHEROMONE_LEVEL(world, channel, plane, local + neighbor_offset[dir]);
+                if (pheromone > max_pheromone) {
+                    max_pheromone = pheromone;
+                    best_direction = dir;
+                }
+            }
+        }
     }
     
     // Move to best direction if pheromone found
@@ -166,23 +347,30 @@ void update_ant(World* world, Ant* ant) {
     
     // Check if ant died
     if (ant->energy <= 0) {
+        Colony* colony = &world->colonies[ant->colony_id];
+        colony->active_ants--;
+        if (ant->food_carrying > 0) colony->carrying_ants--;
         set_ant_state(ant, ANT_STATE_DEAD);
-        print_info("Ant %d died from exhaustion", ant->id);
+        LOG_ANT_INFO("Ant %d died from exhaustion", ant->id);
         return;
     }
     
-    // Get current cell
-    Cell* current_cell = get_cell(world, ant->pos.x, ant->pos.y);
+    // Terrain and nest colony of the current cell, read from the packed bits
+    // (get_cell would also total the pheromone of every colony)
+    int on_grid = is_valid_position(world, ant->pos.x, ant->pos.y);
+    const Chunk* here = get_chunk(world, ant->pos.x, ant->pos.y);
+    uint16_t here_bits = (here != NULL) ? here->cell_bits[CHUNK_LOCAL(ant->pos.x, ant->pos.y)]
+                                        : CELL_PACK(TERRAIN_EMPTY, -1);
     
     // Handle current state
     if (ant->state & ANT_STATE_SEARCHING) {
         // Check for food at current position FIRST
-        if (current_cell && current_cell->terrain == TERRAIN_FOOD && 
-            current_cell->food_amount > 0 && ant->food_carrying == 0) {
+        if (on_grid && ant->food_carrying == 0 &&
+            take_food(world, ant->pos.x, ant->pos.y)) {
             
-            // Pick up food
+            // Pick up food (take_food clears the cell once depleted)
             ant->food_carrying = 1;
-            current_cell->food_amount--;
+            world->colonies[ant->colony_id].carrying_ants++;
             
             // Change state to returning
             clear_ant_state(ant, ANT_STATE_SEARCHING);
@@ -211,11 +399,6 @@ void update_ant(World* world, Ant* ant) {
             LOG_ANT_INFO("Ant %d picked up food at (%d, %d)", 
                          ant->id, ant->last_pos.x, ant->last_pos.y);
             
-            // If food depleted, clear the cell
-            if (current_cell->food_amount <= 0) {
-                current_cell->terrain = TERRAIN_EMPTY;
-            }
-            
             // DON'T MOVE THIS TURN - just deposit pheromone
             deposit_pheromone(world, ant);
             return;  // Exit early
@@ -233,12 +416,13 @@ void update_ant(World* world, Ant* ant) {
         
     } else if (ant->state & ANT_STATE_RETURNING) {
         // Check if at nest
-        if (current_cell && current_cell->terrain == TERRAIN_NEST && 
-            current_cell->colony_id == ant->colony_id && ant->food_carrying > 0) {
+        if (on_grid && CELL_TERRAIN(here_bits) == TERRAIN_NEST && 
+            CELL_COLONY(here_bits) == ant->colony_id && ant->food_carrying > 0) {
             
             // Deliver food
             Colony* colony = &world->colonies[ant->colony_id];
             colony->food_collected++;
+            colony->carrying_ants--;
             ant->food_delivered++;
             ant->food_carrying = 0;
             
@@ -308,13 +492,10 @@ void decide_direction(Ant* ant, World* world) {
 void handle_food_interaction(Ant* ant, World* world) {
     if (ant == NULL || world == NULL) return;
     
-    Cell* cell = get_cell(world, ant->pos.x, ant->pos.y);
-    if (cell == NULL) return;
-    
-    if (cell->terrain == TERRAIN_FOOD && cell->food_amount > 0 && ant->food_carrying == 0) {
-        // Pick up food
+    if (ant->food_carrying == 0 && take_food(world, ant->pos.x, ant->pos.y)) {
+        // Pick up food (take_food clears the cell once depleted)
         ant->food_carrying = 1;
-        cell->food_amount--;
+        world->colonies[ant->colony_id].carrying_ants++;
         
         // Change state to returning
         clear_ant_state(ant, ANT_STATE_SEARCHING);
@@ -324,24 +505,21 @@ void handle_food_interaction(Ant* ant, World* world) {
         ant->energy += ANT_ENERGY_FROM_FOOD;
         
         print_info("Ant %d picked up food at (%d, %d)", ant->id, ant->pos.x, ant->pos.y);
-        
-        // If food is depleted, clear the cell
-        if (cell->food_amount <= 0) {
-            cell->terrain = TERRAIN_EMPTY;
-        }
     }
 }
 
 void handle_nest_return(Ant* ant, World* world) {
     if (ant == NULL || world == NULL) return;
     
-    Cell* cell = get_cell(world, ant->pos.x, ant->pos.y);
-    if (cell == NULL) return;
+    Chunk* chunk = get_chunk(world, ant->pos.x, ant->pos.y);
+    if (chunk == NULL) return;
+    uint16_t bits = chunk->cell_bits[CHUNK_LOCAL(ant->pos.x, ant->pos.y)];
     
-    if (cell->terrain == TERRAIN_NEST && cell->colony_id == ant->colony_id && ant->food_carrying > 0) {
+    if (CELL_TERRAIN(bits) == TERRAIN_NEST && CELL_COLONY(bits) == ant->colony_id && ant->food_carrying > 0) {
         // Deliver food to nest
         Colony* colony = &world->colonies[ant->colony_id];
         colony->food_collected += ant->food_carrying;
+        colony->carrying_ants--;
         ant->food_delivered += ant->food_carrying;
         ant->food_carrying = 0;
         
@@ -383,38 +561,31 @@ void spawn_ant(World* world, int colony_id) {
     Colony* colony = &world->colonies[colony_id];
     
     // Check if we can spawn more ants
-    if (colony->total_ants >= MAX_ANTS_PER_COLONY) {
+    if (colony->total_ants >= world->max_ants_per_colony) {
         print_warning("Colony %d at maximum ant capacity", colony_id);
         return;
     }
     
     // Create ant at nest position
-    Ant* ant = create_ant(colony->total_ants + 1, colony_id, colony->nest_pos);
-    if (ant != NULL) {
-        add_ant_to_colony(colony, ant);
-    }
+    Ant ant;
+    init_ant(&ant, colony->total_ants + 1, colony_id, colony->nest_pos);
+    add_ant_to_colony(colony, &ant);
 }
 
 void cleanup_dead_ants(Colony* colony) {
     if (colony == NULL) return;
     
-    Ant** current = &colony->ants_head;
+    AntPool* pool = &colony->ants;
     int removed_count = 0;
     
-    while (*current != NULL) {
-        if ((*current)->state & ANT_STATE_DEAD) {
-            Ant* dead = *current;
-            *current = (*current)->next;
+    // From the back, so the ant moved into a freed slot was already checked
+    for (int slot = pool->count - 1; slot >= 0; slot--) {
+        if (pool->states[slot] & ANT_STATE_DEAD) {
+            release_ant_slot(pool, slot);
             
-            // Update colony statistics
+            // Update colony statistics (active_ants dropped at death)
             colony->total_ants--;
-            colony->active_ants--;
-            
-            // Destroy the dead ant
-            destroy_ant(dead);
             removed_count++;
-        } else {
-            current = &(*current)->next;
         }
     }
     
@@ -428,16 +599,22 @@ void update_all_ants(World* world) {
     
     for (int i = 0; i < world->colony_count; i++) {
         Colony* colony = &world->colonies[i];
-        Ant* current = colony->ants_head;
+        AntPool* pool = &colony->ants;
         
-        while (current != NULL) {
-            Ant* next = current->next;  // Store next before updating
+        // Ants die in place, so the slots stay put until the cleanup below
+        for (int slot = 0; slot < pool->count; slot++) {
+            if (pool->states[slot] & ANT_STATE_DEAD) continue;
             
-            if (!(current->state & ANT_STATE_DEAD)) {
-                update_ant(world, current);
-            }
+            Ant ant;
+            load_ant(colony, slot, &ant);
+            update_ant(world, &ant);
+            store_ant(colony, slot, &ant);
             
-            current = next;
+            // Keep the chunk under a live ant allocated
+            Chunk* chunk = touch_chunk(world, ant.pos.x, ant.pos.y);
+            if (chunk != NULL) {
+                chunk->last_ant_step = world->current_step;
+            }
         }
         
         // Clean up dead ants after updating all
@@ -461,11 +638,6 @@ void add_path_node(Ant* ant, Position pos, float pheromone) {
 void clear_path_history(Ant* ant) {
     if (ant == NULL) return;
     
-    PathNode* current = ant->path_history;
-    while (current != NULL) {
-        PathNode* next = current->next;
-        safe_free(current);
-        current = next;
-    }
+    free_path_nodes(ant->path_history);
     ant->path_history = NULL;
 }
@@ -2,12 +2,20 @@
 #define ANT_LOGIC_H
 
 #include "data_structures.h"
+#include <stddef.h>
 
 // Ant creation and management
-Ant* create_ant(int id, int colony_id, Position pos);
-void destroy_ant(Ant* ant);
-void add_ant_to_colony(Colony* colony, Ant* ant);
-void remove_ant_from_colony(Colony* colony, Ant* ant);
+void init_ant(Ant* ant, int id, int colony_id, Position pos);
+int add_ant_to_colony(Colony* colony, const Ant* ant);  // Returns the new slot, -1 if out of memory
+void remove_ant_from_colony(Colony* colony, int slot);  // The last ant moves into slot
+
+// Ant pool. An Ant is a copy of one slot: load it, work on it, store it
+// back. The pool owns the path history, so only stored ants keep theirs.
+void load_ant(const Colony* colony, int slot, Ant* ant);
+void store_ant(Colony* colony, int slot, const Ant* ant);
+void clear_ant_pool(AntPool* pool);  // Drops every ant, keeps the arrays
+void free_ant_pool(AntPool* pool);
+size_t get_ant_pool_memory_usage(const AntPool* pool);  // Arrays at capacity plus path history
 
 // Ant movement
 void move_ant(Ant* ant, World* world, int direction);
@@ -0,0 +1,438 @@
+#include "benchmark.h"
+#include "config.h"
+#include "world.h"
+#include "simulation.h"
+#include "pheromones.h"
+#include "pheromone_kernels.h"
+#include "profiler.h"
+#include "utils.h"
+#include "worker_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Pheromone channels allocated over all chunks
+static int count_pheromone_channels(const World* world) {
+    int count = 0;
+    for (int c = 0; c < world->chunk_count; c++) {
+        count += world->chunk_list[c]->channel_count;
+    }
+    return count;
+}
+
+// Sparse layout: one small food patch at a random bearing from each nest,
+// so only the chunks the colonies actually reach get allocated
+static void place_sparse_food(World* world) {
+    for (int i = 0; i < world->colony_count; i++) {
+        Position nest = world->colonies[i].nest_pos;
+        int fx = nest.x + random_int(-BENCHMARK_SPARSE_FOOD_DISTANCE, BENCHMARK_SPARSE_FOOD_DISTANCE);
+        int fy = nest.y + random_int(-BENCHMARK_SPARSE_FOOD_DISTANCE, BENCHMARK_SPARSE_FOOD_DISTANCE);
+        
+        for (int dy = -BENCHMARK_SPARSE_FOOD_RADIUS; dy <= BENCHMARK_SPARSE_FOOD_RADIUS; dy++) {
+            for (int dx = -BENCHMARK_SPARSE_FOOD_RADIUS; dx <= BENCHMARK_SPARSE_FOOD_RADIUS; dx++) {
+                int x = fx + dx;
+                int y = fy + dy;
+                if (is_valid_position(world, x, y) && get_terrain(world, x, y) == TERRAIN_EMPTY) {
+                    place_food(world, x, y, random_int(20, 100));
+                }
+            }
+        }
+    }
+}
+
+// Diffusion-heavy layout: both pheromones on every cell, so every chunk is
+// allocated and active from the first tick
+static void place_pheromone_everywhere(World* world) {
+    for (int y = 0; y < world->height; y++) {
+        for (int x = 0; x < world->width; x++) {
+            deposit_pheromone_at_position(world, x, y, 0, PHEROMONE_TYPE_FOOD, BENCHMARK_DIFFUSION_PHEROMONE);
+            deposit_pheromone_at_position(world, x, y, 0, PHEROMONE_TYPE_HOME, BENCHMARK_DIFFUSION_PHEROMONE);
+        }
+    }
+}
+
+static const char* scenario_name(int scenario) {
+    switch (scenario) {
+        case BENCHMARK_SCENARIO_SPARSE: return "sparse";
+        case BENCHMARK_SCENARIO_DIFFUSION: return "diffusion";
+        case BENCHMARK_SCENARIO_COLONIES: return "colonies";
+        default: return "random";
+    }
+}
+
+static int scenario_colonies(int scenario) {
+    return (scenario == BENCHMARK_SCENARIO_COLONIES) ? BENCHMARK_MANY_COLONIES : BENCHMARK_COLONIES;
+}
+
+// Builds the benchmark world: evenly spaced nests, terrain and food for the
+// scenario, and ant_count ants split across the colonies. The colonies
+// scenario is the sparse one with many colonies, each on its own trails.
+static World* create_benchmark_world(int width, int height, int ant_count, int scenario) {
+    int colonies = scenario_colonies(scenario);
+    World* world = create_world(width, height, colonies);
+    if (world == NULL) return NULL;
+    
+    world->private_trails = (scenario == BENCHMARK_SCENARIO_COLONIES);
+    place_colonies_evenly(world);
+    if (scenario == BENCHMARK_SCENARIO_SPARSE || scenario == BENCHMARK_SCENARIO_COLONIES) {
+        place_sparse_food(world);
+    } else {
+        initialize_world_random(world);
+        if (scenario == BENCHMARK_SCENARIO_DIFFUSION) {
+            place_pheromone_everywhere(world);
+        }
+    }
+    
+    int per_colony = ant_count / colonies;
+    int remainder = ant_count % colonies;
+    if (world->max_ants_per_colony < per_colony + remainder) {
+        world->max_ants_per_colony = per_colony + remainder;
+    }
+    
+    for (int i = 0; i < colonies; i++) {
+        int count = per_colony + (i == 0 ? remainder : 0);
+        for (int j = 0; j < count; j++) {
+            spawn_ant(world, i);
+        }
+    }
+    
+    return world;
+}
+
+int run_benchmark(int width, int height, int ant_count, int ticks, int scenario) {
+    if (width <= 0 || height <= 0 || ant_count < 0 || ticks <= 0) {
+        print_error("Invalid benchmark parameters");
+        return 1;
+    }
+    
+    // Fixed seed so runs are comparable
+    init_random();
+    srand(BENCHMARK_SEED);
+    
+    uint64_t setup_start = get_time_us();
+    World* world = create_benchmark_world(width, height, ant_count, scenario);
+    if (world == NULL) {
+        print_error("Failed to create benchmark world");
+        return 1;
+    }
+    uint64_t setup_us = get_time_us() - setup_start;
+    
+    profiler_reset();
+    profiler_set_enabled(1);
+    
+    uint64_t start = get_time_us();
+    for (int t = 0; t < ticks; t++) {
+        simulation_step(world);
+        
+        // Same end-of-run check as the interactive loop
+        profiler_begin(PROFILE_FOOD_CHECK);
+        volatile long long remaining = count_remaining_food(world);
+        (void)remaining;
+        profiler_end(PROFILE_FOOD_CHECK);
+    }
+    uint64_t elapsed_us = get_time_us() - start;
+    profiler_set_enabled(0);
+    
+    double seconds = elapsed_us / 1000000.0;
+    double ticks_per_sec = (seconds > 0.0) ? ticks / seconds : 0.0;
+    
+    printf("\nBENCHMARK RESULTS\n");
+    printf("World: %dx%d (%s)  Colonies: %d%s  Ants: %d  Ticks: %d\n",
+           width, height, scenario_name(scenario), world->colony_count,
+           world->private_trails ? " (private trails)" : "", ant_count, ticks);
+    printf("Chunks: %d of %d allocated (%dx%d tiles)  Pheromone channels: %d  Pheromone kernel: %s  Threads: %d\n",
+           world->chunk_count, world->chunks_x * world->chunks_y, CHUNK_SIZE, CHUNK_SIZE,
+           count_pheromone_channels(world), get_pheromone_kernels()->name, get_worker_threads());
+    printf("Setup: %.2f s  Run: %.2f s  Memory: %.1f MB\n",
+           setup_us / 1000000.0, seconds, get_world_memory_usage(world) / (1024.0 * 1024.0));
+    printf("Throughput: %.2f ticks/s  %.0f ant-updates/s\n",
+           ticks_per_sec, ticks_per_sec * ant_count);
+    printf("\n");
+    profiler_print_report(ticks);
+    
+    int result = 0;
+    if (scenario == BENCHMARK_SCENARIO_RANDOM &&
+        width == BENCHMARK_DEFAULT_WIDTH && height == BENCHMARK_DEFAULT_HEIGHT &&
+        ant_count == BENCHMARK_DEFAULT_ANTS) {
+        if (ticks_per_sec < BENCHMARK_TARGET_TICKS_PER_SEC) {
+            printf("\nBELOW TARGET: %.2f ticks/s (target %.2f)\n", ticks_per_sec, BENCHMARK_TARGET_TICKS_PER_SEC);
+            result = 1;
+        } else {
+            printf("\nTarget met: %.2f ticks/s (target %.2f)\n", ticks_per_sec, BENCHMARK_TARGET_TICKS_PER_SEC);
+        }
+    }
+    
+    destroy_world(world);
+    return result;
+}
+
+// Sum of every pheromone level in directory and colony order, to compare
+// runs
+static double pheromone_checksum(const World* world) {
+    double sum = 0.0;
+    for (int cy = 0; cy < world->chunks_y; cy++) {
+        for (int cx = 0; cx < world->chunks_x; cx++) {
+            const Chunk* chunk = get_chunk_at(world, cx, cy);
+            if (chunk == NULL) continue;
+            for (int k = 0; k < chunk->channel_count; k++) {
+                const PheromoneChannel* channel = chunk->channels[k];
+                for (int ly = 0; ly < chunk->rows; ly++) {
+                    int row = CHUNK_PAD_INDEX(0, ly);
+                    for (int i = row; i < row + chunk->cols; i++) {
+                        sum += PHEROMONE_LEVEL(world, channel, channel->pheromone_food, i);
+                        sum += PHEROMONE_LEVEL(world, channel, channel->pheromone_home, i);
+                    }
+                }
+            }
+        }
+    }
+    return sum;
+}
+
+int run_thread_scaling_benchmark(int width, int height, int ant_count, int ticks) {
+    if (width <= 0 || height <= 0 || ant_count < 0 || ticks <= 0) {
+        print_error("Invalid benchmark parameters");
+        return 1;
+    }
+    
+    int configured = get_worker_threads();
+    int max_threads = get_processor_count();
+    double base_ms = 0.0;
+    double base_checksum = 0.0;
+    int result = 0;
+    
+    printf("\nTHREAD SCALING\n");
+    printf("World: %dx%d (%s)  Colonies: %d  Ants: %d  Ticks: %d  Processors: %d\n",
+           width, height, scenario_name(BENCHMARK_SCENARIO_DIFFUSION),
+           BENCHMARK_COLONIES, ant_count, ticks, max_threads);
+    printf("%8s %12s %14s %9s %22s\n", "Threads", "Ticks/s", "Pheromone ms", "Speedup", "Pheromone checksum");
+    
+    // 1, 2, 4, ... and the processor count
+    for (int threads = 1; threads <= max_threads;
+         threads = (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2) {
+        set_worker_threads(threads);
+        init_random();
+        srand(BENCHMARK_SEED);
+        World* world = create_benchmark_world(width, height, ant_count, BENCHMARK_SCENARIO_DIFFUSION);
+        if (world == NULL) {
+            print_error("Failed to create benchmark world");
+            result = 1;
+            break;
+        }
+        
+        profiler_reset();
+        profiler_set_enabled(1);
+        uint64_t start = get_time_us();
+        for (int t = 0; t < ticks; t++) {
+            simulation_step(world);
+        }
+        uint64_t elapsed_us = get_time_us() - start;
+        profiler_set_enabled(0);
+        
+        double ticks_per_sec = (elapsed_us > 0) ? ticks / (elapsed_us / 1000000.0) : 0.0;
+        double pheromone_ms = profiler_get_total_us(PROFILE_PHEROMONES) / 1000.0 / ticks;
+        double checksum = pheromone_checksum(world);
+        if (threads == 1) {
+            base_ms = pheromone_ms;
+            base_checksum = checksum;
+        }
+        
+        // The thread count must not change the result
+        int same = (checksum == base_checksum);
+        printf("%8d %12.2f %14.3f %8.2fx %22.6f%s\n", threads, ticks_per_sec, pheromone_ms,
+               (pheromone_ms > 0.0) ? base_ms / pheromone_ms : 0.0, checksum, same ? "" : "  MISMATCH");
+        if (!same) result = 1;
+        
+        destroy_world(world);
+        if (threads == max_threads) break;
+    }
+    
+    set_worker_threads(configured);
+    return result;
+}
+
+int run_blocking_benchmark(int width, int height, int ant_count, int ticks) {
+    if (width <= 0 || height <= 0 || ant_count < 0 || ticks <= 0) {
+        print_error("Invalid benchmark parameters");
+        return 1;
+    }
+    
+    int configured = get_pheromone_block_ticks();
+    double base_ms = 0.0;
+    double base_checksum = 0.0;
+    int result = 0;
+    
+    printf("\nBLOCKED PHEROMONE UPDATE\n");
+    printf("World: %dx%d (%s)  Colonies: %d  Ants: %d  Ticks: %d  Threads: %d\n",
+           width, height, scenario_name(BENCHMARK_SCENARIO_DIFFUSION),
+           BENCHMARK_COLONIES, ant_count, ticks, get_worker_threads());
+    printf("%6s %12s %14s %9s %15s %22s\n", "Block", "Ticks/s", "Pheromone ms", "Speedup",
+           "Plane MB/tick", "Pheromone checksum");
+    
+    for (int block = 1; block <= PHEROMONE_BLOCK_MAX_TICKS; block *= 2) {
+        if (set_pheromone_block_ticks(block) != block) break;  // Lazy builds have no blocking
+        init_random();
+        srand(BENCHMARK_SEED);
+        World* world = create_benchmark_world(width, height, ant_count, BENCHMARK_SCENARIO_DIFFUSION);
+        if (world == NULL) {
+            print_error("Failed to create benchmark world");
+            result = 1;
+            break;
+        }
+        
+        profiler_reset();
+        profiler_set_enabled(1);
+        long long traffic = get_pheromone_traffic();
+        uint64_t start = get_time_us();
+        for (int t = 0; t < ticks; t++) {
+            simulation_step(world);
+        }
+        // Ticks a partial block still owes count towards the run
+        profiler_begin(PROFILE_PHEROMONES);
+        flush_pheromone_block(world);
+        profiler_end(PROFILE_PHEROMONES);
+        uint64_t elapsed_us = get_time_us() - start;
+        profiler_set_enabled(0);
+        traffic = get_pheromone_traffic() - traffic;
+        
+        double ticks_per_sec = (elapsed_us > 0) ? ticks / (elapsed_us / 1000000.0) : 0.0;
+        double pheromone_ms = profiler_get_total_us(PROFILE_PHEROMONES) / 1000.0 / ticks;
+        double checksum = pheromone_checksum(world);
+        if (block == 1) {
+            base_ms = pheromone_ms;
+            base_checksum = checksum;
+        }
+        
+        // Ants follow older trails while a block runs, so only runs without
+        // them must match; fixed-point planes are rounded once per block
+        int same = (checksum == base_checksum);
+        int must_match = (ant_count == 0 && !PHEROMONE_FIXED_POINT);
+        printf("%6d %12.2f %14.3f %8.2fx %15.1f %22.6f%s\n", block, ticks_per_sec, pheromone_ms,
+               (pheromone_ms > 0.0) ? base_ms / pheromone_ms : 0.0,
+               traffic / (1024.0 * 1024.0) / ticks, checksum, (same || !must_match) ? "" : "  MISMATCH");
+        if (!same && must_match) result = 1;
+        
+        destroy_world(world);
+    }
+    
+    set_pheromone_block_ticks(configured);
+    return result;
+}
+
+// World with a square of pheromone at PHEROMONE_MAX in its centre
+static World* create_spread_world(int width, int height) {
+    World* world = create_world(width, height, 1);
+    if (world == NULL) return NULL;
+    
+    int r = BENCHMARK_IMPLICIT_PATCH_RADIUS;
+    for (int y = height / 2 - r; y <= height / 2 + r; y++) {
+        for (int x = width / 2 - r; x <= width / 2 + r; x++) {
+            deposit_pheromone_at_position(world, x, y, 0, PHEROMONE_TYPE_FOOD, PHEROMONE_MAX);
+        }
+    }
+    return world;
+}
+
+// Mean squared distance of the food pheromone from the world's centre,
+// weighted by level; sets *mass to the total level
+static double pheromone_spread(const World* world, double* mass) {
+    double total = 0.0;
+    double moment = 0.0;
+    for (int c = 0; c < world->chunk_count; c++) {
+        const Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            const PheromoneChannel* channel = chunk->channels[k];
+            for (int ly = 0; ly < chunk->rows; ly++) {
+                double dy = chunk->cy * CHUNK_SIZE + ly - world->height / 2;
+                for (int lx = 0; lx < chunk->cols; lx++) {
+                    float level = PHEROMONE_LEVEL(world, channel, channel->pheromone_food, CHUNK_PAD_INDEX(lx, ly));
+                    if (level == 0.0f) continue;
+                    double dx = chunk->cx * CHUNK_SIZE + lx - world->width / 2;
+                    total += level;
+                    moment += level * (dx * dx + dy * dy);
+                }
+            }
+        }
+    }
+    *mass = total;
+    return (total > 0.0) ? moment / total : 0.0;
+}
+
+int run_implicit_benchmark(int width, int height, int dt, int updates) {
+    if (width <= 0 || height <= 0 || dt <= 0 || updates <= 0) {
+        print_error("Invalid benchmark parameters");
+        return 1;
+    }
+    
+    int configured_block = get_pheromone_block_ticks();
+    int configured_dt = get_pheromone_implicit_dt();
+    if (set_pheromone_implicit_dt(dt) == 0) {
+        print_error("This build has no pheromone diffusion");
+        return 1;
+    }
+    dt = get_pheromone_implicit_dt();
+    
+    printf("\nIMPLICIT PHEROMONE DIFFUSION\n");
+    printf("World: %dx%d  Patch: %dx%d at %.0f  Threads: %d\n", width, height,
+           2 * BENCHMARK_IMPLICIT_PATCH_RADIUS + 1, 2 * BENCHMARK_IMPLICIT_PATCH_RADIUS + 1,
+           (double)PHEROMONE_MAX, get_worker_threads());
+    
+    World* world = create_spread_world(width, height);
+    if (world == NULL) {
+        print_error("Failed to create benchmark world");
+        set_pheromone_implicit_dt(configured_dt);
+        set_pheromone_block_ticks(configured_block);
+        return 1;
+    }
+    double start_mass;
+    double start_spread = pheromone_spread(world, &start_mass);
+    uint64_t start = get_time_us();
+    for (int u = 0; u < updates; u++) {
+        diffuse_pheromones(world);
+    }
+    double implicit_ms = (get_time_us() - start) / 1000.0;
+    double implicit_mass;
+    double target = pheromone_spread(world, &implicit_mass);
+    destroy_world(world);
+    
+    // Explicit ticks until the pheromone has spread as far, timing only the
+    // ticks themselves
+    set_pheromone_implicit_dt(0);
+    world = create_spread_world(width, height);
+    int result = 0;
+    if (world == NULL) {
+        print_error("Failed to create benchmark world");
+        result = 1;
+    } else {
+        int limit = 4 * updates * dt;
+        int ticks = 0;
+        double spread = start_spread;
+        double explicit_mass = start_mass;
+        uint64_t explicit_us = 0;
+        while (spread < target && ticks < limit) {
+            start = get_time_us();
+            diffuse_pheromones(world);
+            explicit_us += get_time_us() - start;
+            ticks++;
+            spread = pheromone_spread(world, &explicit_mass);
+        }
+        double explicit_ms = explicit_us / 1000.0;
+        
+        printf("%-10s %8s %12s %14s %12s\n", "Solver", "Calls", "Time ms", "Spread cells2", "Mass kept");
+        printf("%-10s %8d %12.3f %14.2f %11.1f%%\n", "Implicit", updates, implicit_ms, target,
+               (start_mass > 0.0) ? 100.0 * implicit_mass / start_mass : 0.0);
+        printf("%-10s %8d %12.3f %14.2f %11.1f%%\n", "Explicit", ticks, explicit_ms, spread,
+               (start_mass > 0.0) ? 100.0 * explicit_mass / start_mass : 0.0);
+        if (spread < target) {
+            printf("Explicit diffusion did not reach the spread in %d ticks\n", limit);
+        } else {
+            printf("Ticks to equivalent spread: %d (%.1f per implicit update of dt %d)\n",
+                   ticks, (double)ticks / updates, dt);
+        }
+        printf("Speedup: %.2fx\n", (implicit_ms > 0.0) ? explicit_ms / implicit_ms : 0.0);
+        destroy_world(world);
+    }
+    
+    set_pheromone_implicit_dt(configured_dt);
+    set_pheromone_block_ticks(configured_block);
+    return result;
+}
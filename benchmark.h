@@ -0,0 +1,38 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// World layouts the benchmark can build
+#define BENCHMARK_SCENARIO_RANDOM 0   // Obstacles and food scattered over the whole map
+#define BENCHMARK_SCENARIO_SPARSE 1   // Nests and nearby food patches only
+#define BENCHMARK_SCENARIO_DIFFUSION 2 // Random map with pheromone on every cell
+#define BENCHMARK_SCENARIO_COLONIES 3 // Sparse layout, many colonies with private trails
+
+// Headless throughput benchmark (--benchmark). Builds a world for the given
+// scenario, runs the given number of ticks and prints ticks/second plus a
+// per-section profile. Returns 0, or 1 when the reference configuration
+// falls below BENCHMARK_TARGET_TICKS_PER_SEC so regressions are visible to
+// scripts.
+int run_benchmark(int width, int height, int ant_count, int ticks, int scenario);
+
+// Thread scaling benchmark (--benchmark-threads). Runs the diffusion
+// scenario with 1, 2, 4, ... worker threads up to the processor count and
+// prints throughput, pheromone update time and speedup for each. Returns 1
+// if any thread count gives a different pheromone checksum.
+int run_thread_scaling_benchmark(int width, int height, int ant_count, int ticks);
+
+// Blocked update benchmark (--benchmark-blocking). Runs the diffusion
+// scenario with the pheromone update blocked over 1, 2, 4, ... ticks up to
+// PHEROMONE_BLOCK_MAX_TICKS and prints throughput, pheromone update time
+// and the plane bytes read and written per tick for each. Without ants the
+// planes must come out the same, so in float builds it returns 1 if any
+// block size gives a different pheromone checksum.
+int run_blocking_benchmark(int width, int height, int ant_count, int ticks);
+
+// Implicit diffusion benchmark (--benchmark-implicit). Spreads a square of
+// pheromone with the given number of implicit updates of dt ticks each,
+// then runs explicit diffusion on a fresh world until the pheromone has
+// spread as far, and prints the explicit ticks that took and the time of
+// both. Returns 1 if the mode is not available.
+int run_implicit_benchmark(int width, int height, int dt, int updates);
+
+#endif // BENCHMARK_H
@@ -7,15 +7,36 @@
 // World parameters
 #define DEFAULT_WORLD_WIDTH 60
 #define DEFAULT_WORLD_HEIGHT 30
-#define MAX_WORLD_SIZE 100
+#define MAX_WORLD_SIZE 16384        // Hard limit per side (large-world mode)
+#define MAX_RENDER_WORLD_SIZE 100   // Worlds above this run in large-world mode
+
+// Sparse world chunks
+// Chunks are the grid's storage tiles; the edge can be chosen at build time
+// (e.g. /DCHUNK_SHIFT=5 for 32x32). Food source indices are 16-bit, which
+// caps the padded chunk at 128x128.
+#ifndef CHUNK_SHIFT
+#define CHUNK_SHIFT 6                       // 64x64 cells per chunk
+#endif
+#if CHUNK_SHIFT < 3 || CHUNK_SHIFT > 7
+#error "CHUNK_SHIFT must be between 3 and 7"
+#endif
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+#define CHUNK_MASK (CHUNK_SIZE - 1)
+#define CHUNK_CELLS (CHUNK_SIZE * CHUNK_SIZE)
+#define CHUNK_RELEASE_DELAY 16              // Empty sweeps before a chunk is freed
 
 // Ant parameters
 #define INITIAL_ANTS_PER_COLONY 20
 #define MAX_ANTS_PER_COLONY 50
+#define LARGE_WORLD_MAX_ANTS_PER_COLONY 1000000
 #define ANT_INITIAL_ENERGY 1000
 #define ANT_ENERGY_PER_STEP 1
 #define ANT_ENERGY_FROM_FOOD 500
 
+// Colony parameters
+#define MAX_COLONIES 1024                   // Colonies a new simulation can ask for
+#define COLONY_MIN_SPACING 8                // Cells between evenly placed nests
+
 // Pheromone parameters
 #define PHEROMONE_INITIAL 0.0f
 #define PHEROMONE_MAX 1000.0f
@@ -24,6 +45,29 @@
 #define PHEROMONE_EVAPORATION_RATE 0.02f
 #define PHEROMONE_DIFFUSION_RATE 0.01f
 #define PHEROMONE_DISPLAY_THRESHOLD 1.0f  // Show pheromones even at low levels
+#define PHEROMONE_SHARED -1               // Channel colony while colonies share trails
+#define PHEROMONE_HISTOGRAM_BINS 16       // Equal bins over 0..PHEROMONE_MAX in the field statistics
+
+// Evaporation-only pheromone, chosen at build time (/DPHEROMONE_LAZY_EVAPORATION=1).
+// Pheromone does not diffuse; each cell keeps the step it was last written
+// and its level is evaporated in closed form when read, so there is no
+// per-tick sweep.
+#ifndef PHEROMONE_LAZY_EVAPORATION
+#define PHEROMONE_LAZY_EVAPORATION 0
+#endif
+
+// 16-bit fixed-point pheromone planes, chosen at build time
+// (/DPHEROMONE_FIXED_POINT=1). Levels are stored in units of
+// 1/PHEROMONE_FIXED_SCALE, which halves the memory every pheromone pass
+// streams through; the update rounds stochastically so that levels too
+// small to lose a whole unit per tick still evaporate at the right rate.
+#ifndef PHEROMONE_FIXED_POINT
+#define PHEROMONE_FIXED_POINT 0
+#endif
+#define PHEROMONE_FIXED_SCALE 64.0f  // PHEROMONE_MAX * 64 still fits in 16 bits
+#if PHEROMONE_FIXED_POINT && PHEROMONE_LAZY_EVAPORATION
+#error "PHEROMONE_FIXED_POINT and PHEROMONE_LAZY_EVAPORATION cannot be combined"
+#endif
 #define DIRECTION_COUNT 8
 
 // Buffer sizes
@@ -36,6 +80,7 @@
 #define MAX_OBSTACLES_PERCENTAGE 25  // Maximum 25% of world can be obstacles
 #define MIN_OBSTACLES_COUNT 3        // Minimum obstacles for interesting gameplay
 #define QUICKSORT_RECURSION_LIMIT 100  // Switch to iterative above this
+#define FOOD_SOURCE_AREA 10000       // One batch of random food per this many cells
 
 // Unicode support detection (now handled at runtime in visualization.c)
 
@@ -90,6 +135,44 @@
 #define RENDER_DELAY_MS 150  // Reduced from 200ms to 150ms for better viewing
 #define MAX_SIMULATION_STEPS 10000
 
+// Worker threads for the pheromone update (--threads)
+#define DEFAULT_WORKER_THREADS 0      // 0 = one per processor
+#define MAX_WORKER_THREADS 64
+#define PHEROMONE_CHANNELS_PER_BAND 4 // Fewer active channels than this per band run on fewer threads
+
+// Blocked pheromone update (--pheromone-block): ticks advanced per pass
+#define PHEROMONE_BLOCK_MAX_TICKS 8   // At most CHUNK_SIZE
+
+// Implicit pheromone diffusion (--pheromone-implicit): ticks of spread per
+// update. Pheromone must not spread more than CHUNK_SIZE cells in one.
+#define PHEROMONE_IMPLICIT_MAX_DT 1000
+
+// Gradient field: a channel's strongest-neighbour field is built once it is
+// read more than (cells in its pheromone box >> this) times between updates
+#define PHEROMONE_GRADIENT_BUILD_SHIFT 4
+
+// Wide pheromone sensing (--sense-radius): ants weigh the pheromone in 8
+// sectors of the square this many cells around them; 1 = the 8 neighbours
+#define PHEROMONE_SENSE_RADIUS_DEFAULT 1
+#define PHEROMONE_SENSE_RADIUS_MAX 20  // Below CHUNK_SIZE
+
+// Benchmark parameters (--benchmark)
+#define BENCHMARK_DEFAULT_WIDTH 4096
+#define BENCHMARK_DEFAULT_HEIGHT 4096
+#define BENCHMARK_DEFAULT_ANTS 100000
+#define BENCHMARK_DEFAULT_TICKS 20
+#define BENCHMARK_COLONIES 4
+#define BENCHMARK_SEED 12345
+#define BENCHMARK_TARGET_TICKS_PER_SEC 5.0f  // Reference 4096x4096 / 100k ants run
+#define BENCHMARK_SPARSE_FOOD_DISTANCE 200   // Food patch offset from each nest (sparse scenario)
+#define BENCHMARK_SPARSE_FOOD_RADIUS 3
+#define BENCHMARK_DIFFUSION_PHEROMONE 50.0f  // Initial level on every cell (diffusion scenario)
+#define BENCHMARK_MANY_COLONIES 256          // Colonies with private trails (colonies scenario)
+#define BENCHMARK_IMPLICIT_SIZE 1024         // World side (implicit diffusion benchmark)
+#define BENCHMARK_IMPLICIT_DT 200            // Ticks of spread per implicit update
+#define BENCHMARK_IMPLICIT_UPDATES 5
+#define BENCHMARK_IMPLICIT_PATCH_RADIUS 4    // Square of PHEROMONE_MAX the spread starts from
+
 // Debug mode control - DISABLE by default for smooth rendering
 #define ENABLE_SIMULATION_LOGGING 0  // Set to 1 for debug, 0 for production
 
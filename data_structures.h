@@ -2,11 +2,13 @@
 #define DATA_STRUCTURES_H
 
 #include <stdint.h>
+#include "config.h"
 
 // Forward declarations
 typedef struct Ant Ant;
 typedef struct Colony Colony;
 typedef struct World World;
+typedef struct Chunk Chunk;
 
 // Position struct for coordinates
 typedef struct {
@@ -23,7 +25,7 @@ typedef enum {
     TERRAIN_WATER
 } TerrainType;
 
-// Cell struct for world grid
+// Snapshot of one grid cell, assembled from the World planes by get_cell()
 typedef struct {
     TerrainType terrain;
     float pheromone_food;
@@ -34,6 +36,141 @@ typedef struct {
     int has_food;    // Boolean flag for food presence
 } Cell;
 
+// One stored pheromone level, see PHEROMONE_PACK in world.h
+#if PHEROMONE_FIXED_POINT
+typedef uint16_t PheromoneValue;
+#else
+typedef float PheromoneValue;
+#endif
+
+// One entry of a pheromone summed-area table: exact sums of the stored
+// 16-bit values in fixed-point builds, double sums of levels otherwise
+#if PHEROMONE_FIXED_POINT
+typedef uint32_t PheromoneSum;
+#else
+typedef double PheromoneSum;
+#endif
+
+// Local bounds (inclusive, halo ring included, so -1..CHUNK_SIZE) of the
+// cells of a chunk's pheromone planes that may be non-zero. Empty while
+// x0 > x1; cells outside are known to be zero.
+typedef struct PheromoneBox {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+} PheromoneBox;
+
+// One ant deposit held back until the blocked pheromone update applies it
+// at the tick it was made
+typedef struct PheromoneDeposit {
+    uint8_t x;               // Local position of the cell
+    uint8_t y;
+    uint8_t type;            // PHEROMONE_TYPE_FOOD or PHEROMONE_TYPE_HOME
+    uint8_t step;            // Tick of the block, 1-based
+    float amount;
+} PheromoneDeposit;
+
+// A channel's held-back deposits in the order they were made
+typedef struct PheromoneDepositList {
+    PheromoneDeposit* deposits;
+    int count;
+    int capacity;
+    int step_end[PHEROMONE_BLOCK_MAX_TICKS + 1];  // Count after each tick's last deposit, 0 if none
+} PheromoneDepositList;
+
+// A chunk's walkable cells, for the walkable-only pheromone diffusion
+// (pheromones.c): the runs of each row that hold walkable cells, and every
+// cell's weights for its own level and its neighbours' sum. Built from the
+// walk masks and rebuilt once they change.
+typedef struct WalkableCells {
+    unsigned int walk_version;   // Chunk walk_version it was built from
+    uint16_t run_start[CHUNK_SIZE + 1];  // Row ly's runs: [run_start[ly], run_start[ly + 1])
+    uint16_t* runs;          // Run k covers columns runs[2k] to runs[2k + 1] - 1
+    float* keep;             // Padded plane: 1 - rate, 1 with no walkable neighbour, 0 for walls
+    float* share;            // Padded plane: rate / walkable neighbour count, 0 with none
+} WalkableCells;
+
+// The pheromone of one colony over one chunk, or of every colony while they
+// share trails. A channel is allocated the first time its colony's
+// pheromone reaches the chunk (halo included) and freed once it is all zero
+// again, so pheromone memory and update cost follow the occupied area times
+// the colonies present there. Planes are padded like the chunk's.
+typedef struct PheromoneChannel {
+    Chunk* chunk;            // Chunk the channel belongs to
+    int colony;              // Owning colony, PHEROMONE_SHARED if shared
+    void* block;             // Backing allocation (header and front planes)
+    
+    PheromoneValue* pheromone_food;
+    PheromoneValue* pheromone_home;
+    PheromoneValue* back_food;  // Planes the pheromone update writes into; swapped
+    PheromoneValue* back_home;  // with the two above each tick
+    void* back_block;        // Backing allocation of the back planes, NULL
+                             // until the channel is first updated
+    int* pheromone_step;     // Step each cell's pheromone was last written,
+                             // PHEROMONE_LAZY_EVAPORATION builds only
+    
+    int pheromone_active;    // Some cell or halo cell may hold non-zero pheromone
+    int halo_stale;          // Halo must be refreshed after this pheromone update
+    int last_pheromone_step; // Latest pheromone_step of any cell, lazy builds only
+    PheromoneBox pheromone_box; // Cells of the front planes that may be non-zero
+    PheromoneBox back_box;   // Same for the back planes, as of their last tick in front
+    
+    uint8_t* gradient;       // Strongest neighbour of each cell, food plane then
+                             // home (pheromones.c), NULL until first built
+    unsigned int gradient_generation[2];  // pheromone_generation the two below
+    int gradient_reads[2];   // count for: lookups of each type, -1 once its field is built
+    
+    PheromoneSum* sum_table; // Summed-area tables of the box below, food then
+                             // home (pheromones.c), NULL until first built
+    PheromoneBox sum_box;    // In-world cells the tables cover
+    unsigned int sum_generation;  // World pheromone_sum_generation when built
+    
+    PheromoneDepositList deposits[2];  // Held back for the blocked update:
+                             // [0] within PHEROMONE_BLOCK_MAX_TICKS of the
+                             // chunk's edge, where other tiles reach; [1] inside
+} PheromoneChannel;
+
+// One CHUNK_SIZE x CHUNK_SIZE tile of the world grid. Chunks are allocated
+// the first time terrain, pheromone or an ant touches them and released once
+// they decay back to empty; a missing chunk reads as empty terrain with zero
+// pheromone. Planes are row-major inside the chunk, indexed with CHUNK_LOCAL,
+// and padded with a one-cell halo ring that mirrors the neighbouring cells
+// (wall and zero pheromone past the world edge), so a cell's 8 neighbours
+// are always fixed offsets away.
+struct Chunk {
+    int cx;                  // Chunk coordinates in the directory
+    int cy;
+    int cols;                // In-world extent, less than CHUNK_SIZE on the
+    int rows;                // far edges of a world that is not a multiple
+    int list_index;          // Position in World.chunk_list
+    void* block;             // Backing allocation (header and planes)
+    
+    uint16_t* cell_bits;     // Terrain and nest colony packed, see CELL_PACK
+    uint16_t* food_amount;
+    uint8_t* walk_mask;      // Bit d set when direction d (dx/dy order) is walkable
+    unsigned int walk_version; // Bumped whenever a walk mask changes
+    WalkableCells* walkable; // Walkable cells as of some walk_version, NULL
+                             // until the walkable-only diffusion first needs them
+    int16_t* territory;      // Colony whose ant last entered the cell, -1 if none
+    
+    // Pheromone channels sorted by colony. Every colony whose pheromone
+    // this chunk's halo mirrors has one, so a missing channel reads as zero.
+    PheromoneChannel** channels;
+    int channel_count;
+    int channel_capacity;
+    
+    // Food registry bucket: the chunk's food cells as plane indices
+    uint16_t* food_sources;
+    int food_source_count;
+    int food_source_capacity;
+    long long food_total;    // Food left in this chunk
+    
+    int content_cells;       // Cells whose terrain is not TERRAIN_EMPTY
+    int last_ant_step;       // Last step an ant stood in this chunk
+    int idle_sweeps;         // Consecutive release checks that found it empty
+};
+
 // Path node for tracking ant movement history
 typedef struct PathNode {
     Position pos;  // Keep only this one
@@ -41,7 +178,8 @@ typedef struct PathNode {
     struct PathNode* next;
 } PathNode;
 
-// Ant struct with linked list support
+// One ant, as a working copy of a slot of its colony's AntPool (load_ant and
+// store_ant); the pool holds the ants themselves
 typedef struct Ant {
     int id;
     Position pos;  // Primary position field - KEEP THIS ONE
@@ -56,10 +194,33 @@ typedef struct Ant {
     float pheromone_strength;
     float exploration_rate;
     int preferred_direction;  // Direction ant should move next (-1 for no preference)
-    struct Ant* next;  // Linked list pointer
     PathNode* path_history;
 } Ant;
 
+// A colony's ants as parallel arrays, one slot per ant in 0..count-1, so
+// sweeps over a field read it linearly. Dead ants are removed by moving the
+// last ant into their slot; slots stay put until the next removal.
+typedef struct AntPool {
+    int count;
+    int capacity;
+    int* ids;
+    Position* positions;
+    Position* last_positions;
+    uint8_t* states;
+    float* energy;
+    int* food_carrying;
+    int* steps_taken;
+    int* food_delivered;
+    int8_t* preferred_directions;
+    PathNode** path_histories;  // Only filled while the world records paths
+} AntPool;
+
+// An ant in the pools, valid until dead ants are next removed
+typedef struct AntRef {
+    int colony;
+    int slot;
+} AntRef;
+
 // Colony struct
 typedef struct Colony {
     int id;
@@ -67,7 +228,7 @@ typedef struct Colony {
     int food_collected;
     int total_ants;
     int active_ants;
-    Ant* ants_head;  // Primary ant list - KEEP THIS
+    AntPool ants;  // Primary ant storage - KEEP THIS
     int ant_count;  // Current ant count
     float efficiency_score;
     int color;  // For visualization
@@ -76,19 +237,84 @@ typedef struct Colony {
     float pheromone_strength;  // Colony pheromone strength
     float exploration_rate;  // Colony exploration rate
     int territory_size;  // Territory size in cells
+    
+    // Event counters, kept by spawn, death, pickup, delivery and moves so the
+    // per-tick statistics step never walks the ant list
+    int carrying_ants;  // Ants on their way home with food
+    long long straight_moves;  // Moves behind total_distance_traveled
+    long long diagonal_moves;
 } Colony;
 
+// Ants sorted by the cell they stand on, rebuilt once per tick by a counting
+// sort. Keys are the chunk's directory index followed by the cell's
+// row-major position inside the chunk, so a chunk's ants are contiguous and
+// ordered by cell; ants sharing a cell keep colony order.
+typedef struct {
+    int step;                // current_step the index was built at, -1 if never
+    int count;               // Live ants indexed
+    int capacity;
+    AntRef* ants;            // Sorted by key
+    uint32_t* keys;
+    AntRef* scratch_ants;    // Sort buffers
+    uint32_t* scratch_keys;
+    int* chunk_start;        // Directory-sized + 1: first entry of each chunk
+    int* colony_totals;      // Live ants per colony
+} AntIndex;
+
+// Aggregates of one pheromone type over the in-world cells of every channel
+typedef struct {
+    float max;
+    double sum;
+    long long nonzero_cells;  // Channel cells holding any
+    long long histogram[PHEROMONE_HISTOGRAM_BINS];  // Non-zero cells by level, in equal bins up to PHEROMONE_MAX
+} PheromoneFieldStats;
+
+// Statistics of the whole pheromone field, reduced in one pass over it
+typedef struct {
+    PheromoneFieldStats types[2];  // By PHEROMONE_TYPE_*
+    long long cells;               // Channel cells that could hold pheromone: world cells per trail
+    unsigned int generation;       // pheromone_generation reduced, 0 if never
+    int step;                      // current_step reduced
+} PheromoneStats;
+
 // World struct containing the entire simulation
 typedef struct World {
     int width;
     int height;
-    Cell** grid;  // Dynamic 2D array
+    
+    // Sparse grid: a directory of chunks, only the touched ones allocated.
+    // Sweeps walk chunk_list, so their cost follows the active area.
+    int chunks_x;
+    int chunks_y;
+    Chunk** chunks;          // chunks_x * chunks_y directory, NULL = untouched
+    Chunk** chunk_list;      // Allocated chunks in no particular order
+    int chunk_count;
+    
+    // Food registry totals, kept current by every terrain write and pickup;
+    // the per-chunk source lists double as its spatial index
+    long long food_remaining;
+    int food_source_count;
+    
+    AntIndex ant_index;
+    int pheromone_block_ticks;  // Ticks the blocked pheromone update still owes
+    unsigned int pheromone_generation;  // Bumped whenever the planes change; older gradient fields are stale
+    unsigned int pheromone_sum_generation;  // pheromone_generation of the last sum table build, 0 if none
+    PheromoneStats pheromone_stats;  // Published once per tick for the stats panel and CSV export
+    
     Colony* colonies;
     int colony_count;
     int current_step;
     int is_running;
     int paused;
     int render_delay_ms;
+    
+    // Large-world mode: set when either side exceeds MAX_RENDER_WORLD_SIZE
+    int large_world;
+    int max_ants_per_colony;  // Spawn cap, raised in large-world mode
+    int record_paths;         // Keep per-ant PathNode history (off for large worlds)
+    
+    int toroidal;             // Edges wrap around instead of acting as walls
+    int private_trails;       // Each colony lays and follows only its own pheromone
 } World;
 
 #endif // DATA_STRUCTURES_H
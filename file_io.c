@@ -1,12 +1,320 @@
 #include "file_io.h"
 #include "utils.h"
 #include "world.h"
+#include "pheromones.h"
 #include "ant_logic.h"
+#include "ant_index.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+// Chunk planes are padded with a halo in memory; on disk each plane is the
+// bare CHUNK_SIZE x CHUNK_SIZE block. buffer holds CHUNK_CELLS floats.
+static int write_chunk_plane(FILE* file, const void* plane, size_t field_size, unsigned char* buffer) {
+    for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+        memcpy(buffer + (size_t)ly * CHUNK_SIZE * field_size,
+               (const unsigned char*)plane + (size_t)CHUNK_PAD_INDEX(0, ly) * field_size,
+               CHUNK_SIZE * field_size);
+    }
+    return fwrite(buffer, field_size, CHUNK_CELLS, file) == CHUNK_CELLS;
+}
+
+static int read_chunk_plane(FILE* file, void* plane, size_t field_size, unsigned char* buffer) {
+    if (fread(buffer, field_size, CHUNK_CELLS, file) != CHUNK_CELLS) return 0;
+    
+    for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+        memcpy((unsigned char*)plane + (size_t)CHUNK_PAD_INDEX(0, ly) * field_size,
+               buffer + (size_t)ly * CHUNK_SIZE * field_size,
+               CHUNK_SIZE * field_size);
+    }
+    return 1;
+}
+
+// Chunk records: the chunk edge length and record count, then per chunk
+// its coordinates, its packed cell words, 16-bit food amounts and territory
+// claims, and its pheromone channels as a count followed by each channel's colony
+// (PHEROMONE_SHARED for the shared trail) and both pheromone planes
+static int write_chunks(const World* world, FILE* file) {
+    int chunk_size = CHUNK_SIZE;
+    if (fwrite(&chunk_size, sizeof(int), 1, file) != 1 ||
+        fwrite(&world->chunk_count, sizeof(int), 1, file) != 1) {
+        return 0;
+    }
+    
+    unsigned char* buffer = (unsigned char*)safe_malloc(CHUNK_CELLS * sizeof(float));
+    if (buffer == NULL) return 0;
+
+#if PHEROMONE_LAZY_EVAPORATION || PHEROMONE_FIXED_POINT
+    // The planes hold levels as last written or in fixed point; saves hold
+    // the current levels as floats
+    float* levels = (float*)safe_malloc(2 * CHUNK_PADDED_CELLS * sizeof(float));
+    if (levels == NULL) {
+        safe_free(buffer);
+        return 0;
+    }
+#endif
+    
+    int ok = 1;
+    for (int c = 0; c < world->chunk_count && ok; c++) {
+        const Chunk* chunk = world->chunk_list[c];
+        ok = fwrite(&chunk->cx, sizeof(int), 1, file) == 1 &&
+             fwrite(&chunk->cy, sizeof(int), 1, file) == 1 &&
+             write_chunk_plane(file, chunk->cell_bits, sizeof(uint16_t), buffer) &&
+             write_chunk_plane(file, chunk->food_amount, sizeof(uint16_t), buffer) &&
+             write_chunk_plane(file, chunk->territory, sizeof(int16_t), buffer) &&
+             fwrite(&chunk->channel_count, sizeof(int), 1, file) == 1;
+        
+        for (int k = 0; k < chunk->channel_count && ok; k++) {
+            const PheromoneChannel* channel = chunk->channels[k];
+#if PHEROMONE_LAZY_EVAPORATION || PHEROMONE_FIXED_POINT
+            copy_pheromone_levels(world, channel, levels, levels + CHUNK_PADDED_CELLS);
+            const float* food = levels;
+            const float* home = levels + CHUNK_PADDED_CELLS;
+#else
+            const float* food = channel->pheromone_food;
+            const float* home = channel->pheromone_home;
+#endif
+            ok = fwrite(&channel->colony, sizeof(int), 1, file) == 1 &&
+                 write_chunk_plane(file, food, sizeof(float), buffer) &&
+                 write_chunk_plane(file, home, sizeof(float), buffer);
+        }
+    }
+
+#if PHEROMONE_LAZY_EVAPORATION || PHEROMONE_FIXED_POINT
+    safe_free(levels);
+#endif
+    safe_free(buffer);
+    return ok;
+}
+
+// Whether a saved channel colony is one the world can hold
+static int valid_channel_colony(const World* world, int colony) {
+    return colony == PHEROMONE_SHARED || (colony >= 0 && colony < world->colony_count);
+}
+
+// Whether a saved cell has a known terrain and a colony the world has
+// (-1 for none)
+static int valid_cell(const World* world, TerrainType terrain, int colony_id) {
+    return terrain >= TERRAIN_EMPTY && terrain <= TERRAIN_WATER &&
+           colony_id >= -1 && colony_id < world->colony_count;
+}
+
+// Whether a saved territory claim is by a colony the world has (-1 for
+// none)
+static int valid_claim(const World* world, int owner) {
+    return owner >= -1 && owner < world->colony_count;
+}
+
+// Checks the cells of a chunk record copied plane by plane. The slots past
+// the world edge of an edge chunk are put back to unclaimed wall, whatever
+// the file held there. Returns 0 if an in-world cell is not valid.
+static int check_chunk_cells(const World* world, Chunk* chunk) {
+    for (int ly = 0; ly < CHUNK_SIZE; ly++) {
+        for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+            int i = CHUNK_PAD_INDEX(lx, ly);
+            if (lx >= chunk->cols || ly >= chunk->rows) {
+                chunk->cell_bits[i] = CELL_PACK(TERRAIN_WALL, -1);
+                chunk->food_amount[i] = 0;
+                chunk->territory[i] = -1;
+            } else if (!valid_cell(world, CELL_TERRAIN(chunk->cell_bits[i]), CELL_COLONY(chunk->cell_bits[i])) ||
+                       !valid_claim(world, chunk->territory[i])) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Chunk records written by a build with a different CHUNK_SHIFT, which
+// cannot be copied plane by plane. Each record is read whole and stored
+// cell by cell, its channels after its cells.
+static int read_chunks_by_cell(World* world, FILE* file, int chunk_size, int chunk_count) {
+    size_t cells = (size_t)chunk_size * (size_t)chunk_size;
+    uint16_t* bits = (uint16_t*)safe_malloc(cells * sizeof(uint16_t));
+    uint16_t* amount = (uint16_t*)safe_malloc(cells * sizeof(uint16_t));
+    int16_t* territory = (int16_t*)safe_malloc(cells * sizeof(int16_t));
+    float* food = (float*)safe_malloc(cells * sizeof(float));
+    float* home = (float*)safe_malloc(cells * sizeof(float));
+    
+    int ok = bits != NULL && amount != NULL && territory != NULL && food != NULL && home != NULL;
+    for (int c = 0; c < chunk_count && ok; c++) {
+        int cx, cy;
+        int channel_count;
+        ok = fread(&cx, sizeof(int), 1, file) == 1 &&
+             fread(&cy, sizeof(int), 1, file) == 1 &&
+             fread(bits, sizeof(uint16_t), cells, file) == cells &&
+             fread(amount, sizeof(uint16_t), cells, file) == cells &&
+             fread(territory, sizeof(int16_t), cells, file) == cells &&
+             fread(&channel_count, sizeof(int), 1, file) == 1 && channel_count >= 0;
+        
+        for (size_t i = 0; i < cells && ok; i++) {
+            int x = cx * chunk_size + (int)(i % chunk_size);
+            int y = cy * chunk_size + (int)(i / chunk_size);
+            if (!is_valid_position(world, x, y)) continue;
+            
+            Cell cell;
+            cell.terrain = (TerrainType)CELL_TERRAIN(bits[i]);
+            cell.pheromone_food = 0.0f;  // The channels follow
+            cell.pheromone_home = 0.0f;
+            cell.food_amount = amount[i];
+            cell.colony_id = CELL_COLONY(bits[i]);
+            ok = valid_cell(world, cell.terrain, cell.colony_id) && valid_claim(world, territory[i]) &&
+                 set_cell(world, x, y, &cell);
+            if (ok && territory[i] >= 0) {
+                Chunk* chunk = touch_chunk(world, x, y);
+                ok = (chunk != NULL);
+                if (ok) chunk->territory[CHUNK_LOCAL(x, y)] = territory[i];
+            }
+        }
+        
+        for (int k = 0; k < channel_count && ok; k++) {
+            int channel_colony;
+            ok = fread(&channel_colony, sizeof(int), 1, file) == 1 &&
+                 valid_channel_colony(world, channel_colony) &&
+                 fread(food, sizeof(float), cells, file) == cells &&
+                 fread(home, sizeof(float), cells, file) == cells;
+            for (size_t i = 0; i < cells && ok; i++) {
+                int x = cx * chunk_size + (int)(i % chunk_size);
+                int y = cy * chunk_size + (int)(i / chunk_size);
+                if (!is_valid_position(world, x, y) || (food[i] == 0.0f && home[i] == 0.0f)) continue;
+                ok = set_cell_pheromone(world, x, y, channel_colony, food[i], home[i]);
+            }
+        }
+    }
+    
+    safe_free(bits);
+    safe_free(amount);
+    safe_free(territory);
+    safe_free(food);
+    safe_free(home);
+    return ok;
+}
+
+// Reads both pheromone planes of a record into padded level planes and
+// stores them in colony's channel of chunk. Channels saved empty are
+// recreated too, so saving again writes the same records; the next step
+// releases them as it would have. The halo slots stay zero until the halos
+// are rebuilt.
+static int read_channel_planes(World* world, FILE* file, Chunk* chunk, int colony,
+                               float* levels, unsigned char* buffer) {
+    float* food = levels;
+    float* home = levels + CHUNK_PADDED_CELLS;
+    if (!read_chunk_plane(file, food, sizeof(float), buffer) ||
+        !read_chunk_plane(file, home, sizeof(float), buffer)) {
+        return 0;
+    }
+    
+    PheromoneChannel* channel = touch_pheromone_channel(world, chunk, colony);
+    if (channel == NULL) return 0;
+    store_pheromone_levels(channel, food, home);
+    return 1;
+}
+
+static int read_chunks(World* world, FILE* file) {
+    int chunk_size;
+    int chunk_count;
+    if (fread(&chunk_size, sizeof(int), 1, file) != 1 ||
+        fread(&chunk_count, sizeof(int), 1, file) != 1 || chunk_count < 0 ||
+        chunk_size <= 0 || chunk_size > MAX_WORLD_SIZE) {
+        return 0;
+    }
+    if (chunk_size != CHUNK_SIZE) {
+        return read_chunks_by_cell(world, file, chunk_size, chunk_count);
+    }
+    if (chunk_count > world->chunks_x * world->chunks_y) {
+        return 0;
+    }
+    
+    // Float levels are read into padded planes and stored into the channels
+    unsigned char* buffer = (unsigned char*)safe_malloc(CHUNK_CELLS * sizeof(float));
+    float* levels = (float*)safe_calloc(2 * CHUNK_PADDED_CELLS, sizeof(float));
+    if (buffer == NULL || levels == NULL) {
+        safe_free(buffer);
+        safe_free(levels);
+        return 0;
+    }
+    
+    int ok = 1;
+    for (int c = 0; c < chunk_count && ok; c++) {
+        int cx, cy;
+        if (fread(&cx, sizeof(int), 1, file) != 1 ||
+            fread(&cy, sizeof(int), 1, file) != 1) {
+            ok = 0;
+            break;
+        }
+        
+        Chunk* chunk = touch_chunk_at(world, cx, cy);
+        if (chunk == NULL) {
+            ok = 0;
+            break;
+        }
+        
+        int channel_count;
+        ok = read_chunk_plane(file, chunk->cell_bits, sizeof(uint16_t), buffer) &&
+             read_chunk_plane(file, chunk->food_amount, sizeof(uint16_t), buffer) &&
+             read_chunk_plane(file, chunk->territory, sizeof(int16_t), buffer) &&
+             check_chunk_cells(world, chunk) &&
+             fread(&channel_count, sizeof(int), 1, file) == 1 && channel_count >= 0;
+        for (int k = 0; k < channel_count && ok; k++) {
+            int colony;
+            ok = fread(&colony, sizeof(int), 1, file) == 1 &&
+                 valid_channel_colony(world, colony) &&
+                 read_channel_planes(world, file, chunk, colony, levels, buffer);
+        }
+    }
+    safe_free(levels);
+    safe_free(buffer);
+    if (!ok) return 0;
+    
+    // Halos can only be rebuilt once every chunk is in place
+    for (int c = 0; c < world->chunk_count; c++) {
+        refresh_chunk_halo(world, world->chunk_list[c]);
+    }
+    for (int c = 0; c < world->chunk_count; c++) {
+        update_chunk_summary(world, world->chunk_list[c]);
+    }
+    return 1;
+}
+
+// Territory sizes from the claims read with the chunks, which have been
+// checked against the world's colonies and edges
+static void count_territory(World* world) {
+    for (int i = 0; i < world->colony_count; i++) {
+        world->colonies[i].territory_size = 0;
+    }
+    for (int c = 0; c < world->chunk_count; c++) {
+        const Chunk* chunk = world->chunk_list[c];
+        for (int ly = 0; ly < chunk->rows; ly++) {
+            int row = CHUNK_PAD_INDEX(0, ly);
+            for (int i = row; i < row + chunk->cols; i++) {
+                if (chunk->territory[i] >= 0) {
+                    world->colonies[chunk->territory[i]].territory_size++;
+                }
+            }
+        }
+    }
+}
+
+// Version 1.0 grid: five fields per cell, terrain as a full TerrainType
+static int read_legacy_grid(World* world, FILE* file) {
+    for (int y = 0; y < world->height; y++) {
+        for (int x = 0; x < world->width; x++) {
+            Cell cell;
+            if (fread(&cell.terrain, sizeof(TerrainType), 1, file) != 1 ||
+                fread(&cell.pheromone_food, sizeof(float), 1, file) != 1 ||
+                fread(&cell.pheromone_home, sizeof(float), 1, file) != 1 ||
+                fread(&cell.food_amount, sizeof(int), 1, file) != 1 ||
+                fread(&cell.colony_id, sizeof(int), 1, file) != 1 ||
+                !valid_cell(world, cell.terrain, cell.colony_id) ||
+                !set_cell(world, x, y, &cell)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
 // Save and load simulation
 int save_simulation(const World* world, const char* filename) {
     if (world == NULL || filename == NULL) {
@@ -36,7 +344,9 @@ int save_simulation(const World* world, const char* filename) {
     // Write world dimensions
     if (fwrite(&world->width, sizeof(int), 1, file) != 1 ||
         fwrite(&world->height, sizeof(int), 1, file) != 1 ||
-        fwrite(&world->colony_count, sizeof(int), 1, file) != 1) {
+        fwrite(&world->colony_count, sizeof(int), 1, file) != 1 ||
+        fwrite(&world->toroidal, sizeof(int), 1, file) != 1 ||
+        fwrite(&world->private_trails, sizeof(int), 1, file) != 1) {
         print_error("Failed to write world dimensions");
         fclose(file);
         return FILE_IO_ERROR_WRITE;
@@ -49,49 +359,42 @@ int save_simulation(const World* world, const char* filename) {
             fwrite(&colony->food_collected, sizeof(int), 1, file) != 1 ||
             fwrite(&colony->total_ants, sizeof(int), 1, file) != 1 ||
             fwrite(&colony->active_ants, sizeof(int), 1, file) != 1 ||
-            fwrite(&colony->efficiency_score, sizeof(float), 1, file) != 1) {
+            fwrite(&colony->efficiency_score, sizeof(float), 1, file) != 1 ||
+            fwrite(&colony->straight_moves, sizeof(long long), 1, file) != 1 ||
+            fwrite(&colony->diagonal_moves, sizeof(long long), 1, file) != 1) {
             print_error("Failed to write colony data");
             fclose(file);
             return FILE_IO_ERROR_WRITE;
         }
     }
     
-    // Write grid data
-    for (int y = 0; y < world->height; y++) {
-        for (int x = 0; x < world->width; x++) {
-            Cell* cell = &world->grid[y][x];
-            if (fwrite(&cell->terrain, sizeof(TerrainType), 1, file) != 1 ||
-                fwrite(&cell->pheromone_food, sizeof(float), 1, file) != 1 ||
-                fwrite(&cell->pheromone_home, sizeof(float), 1, file) != 1 ||
-                fwrite(&cell->food_amount, sizeof(int), 1, file) != 1 ||
-                fwrite(&cell->colony_id, sizeof(int), 1, file) != 1) {
-                print_error("Failed to write grid data");
-                fclose(file);
-                return FILE_IO_ERROR_WRITE;
-            }
-        }
+    // Write grid data as the allocated chunks only; untouched chunks are
+    // empty and cost nothing on disk
+    if (!write_chunks(world, file)) {
+        print_error("Failed to write grid data");
+        fclose(file);
+        return FILE_IO_ERROR_WRITE;
     }
     
     // Write ants data
     for (int i = 0; i < world->colony_count; i++) {
-        Colony* colony = &world->colonies[i];
-        Ant* current = colony->ants_head;
+        const Colony* colony = &world->colonies[i];
+        const AntPool* pool = &colony->ants;
         
-        while (current != NULL) {
-            if (fwrite(&current->id, sizeof(int), 1, file) != 1 ||
-                fwrite(&current->pos, sizeof(Position), 1, file) != 1 ||
-                fwrite(&current->last_pos, sizeof(Position), 1, file) != 1 ||
-                fwrite(&current->state, sizeof(uint8_t), 1, file) != 1 ||
-                fwrite(&current->colony_id, sizeof(int), 1, file) != 1 ||
-                fwrite(&current->energy, sizeof(float), 1, file) != 1 ||
-                fwrite(&current->food_carrying, sizeof(int), 1, file) != 1 ||
-                fwrite(&current->steps_taken, sizeof(int), 1, file) != 1 ||
-                fwrite(&current->food_delivered, sizeof(int), 1, file) != 1) {
+        for (int slot = 0; slot < pool->count; slot++) {
+            if (fwrite(&pool->ids[slot], sizeof(int), 1, file) != 1 ||
+                fwrite(&pool->positions[slot], sizeof(Position), 1, file) != 1 ||
+                fwrite(&pool->last_positions[slot], sizeof(Position), 1, file) != 1 ||
+                fwrite(&pool->states[slot], sizeof(uint8_t), 1, file) != 1 ||
+                fwrite(&colony->id, sizeof(int), 1, file) != 1 ||
+                fwrite(&pool->energy[slot], sizeof(float), 1, file) != 1 ||
+                fwrite(&pool->food_carrying[slot], sizeof(int), 1, file) != 1 ||
+                fwrite(&pool->steps_taken[slot], sizeof(int), 1, file) != 1 ||
+                fwrite(&pool->food_delivered[slot], sizeof(int), 1, file) != 1) {
                 print_error("Failed to write ant data");
                 fclose(file);
                 return FILE_IO_ERROR_WRITE;
             }
-            current = current->next;
         }
         
         // Write end marker for this colony
@@ -132,18 +435,29 @@ World* load_simulation(const char* filename) {
     }
     
     // Read version
-    char version[16];
+    char version[16] = {0};
     if (fread(version, sizeof(char), strlen(SAVE_FILE_VERSION), file) != strlen(SAVE_FILE_VERSION)) {
         print_error("Failed to read file version");
         fclose(file);
         return NULL;
     }
     
-    // Read world dimensions
+    int legacy_grid = (strcmp(version, SAVE_FILE_VERSION_LEGACY) == 0);
+    if (!legacy_grid && strcmp(version, SAVE_FILE_VERSION) != 0) {
+        print_error("Unsupported save file version %s", version);
+        fclose(file);
+        return NULL;
+    }
+    
+    // Read world dimensions (1.0 has no toroidal or private trails flag)
     int width, height, colony_count;
+    int toroidal = 0;
+    int private_trails = 0;
     if (fread(&width, sizeof(int), 1, file) != 1 ||
         fread(&height, sizeof(int), 1, file) != 1 ||
-        fread(&colony_count, sizeof(int), 1, file) != 1) {
+        fread(&colony_count, sizeof(int), 1, file) != 1 ||
+        (!legacy_grid && fread(&toroidal, sizeof(int), 1, file) != 1) ||
+        (!legacy_grid && fread(&private_trails, sizeof(int), 1, file) != 1)) {
         print_error("Failed to read world dimensions");
         fclose(file);
         return NULL;
@@ -156,15 +470,19 @@ World* load_simulation(const char* filename) {
         fclose(file);
         return NULL;
     }
+    set_world_toroidal(world, toroidal);
+    world->private_trails = private_trails ? 1 : 0;
     
-    // Read colony data
+    // Read colony data (1.0 has no move counters)
     for (int i = 0; i < colony_count; i++) {
         Colony* colony = &world->colonies[i];
         if (fread(&colony->nest_pos, sizeof(Position), 1, file) != 1 ||
             fread(&colony->food_collected, sizeof(int), 1, file) != 1 ||
             fread(&colony->total_ants, sizeof(int), 1, file) != 1 ||
             fread(&colony->active_ants, sizeof(int), 1, file) != 1 ||
-            fread(&colony->efficiency_score, sizeof(float), 1, file) != 1) {
+            fread(&colony->efficiency_score, sizeof(float), 1, file) != 1 ||
+            (!legacy_grid && fread(&colony->straight_moves, sizeof(long long), 1, file) != 1) ||
+            (!legacy_grid && fread(&colony->diagonal_moves, sizeof(long long), 1, file) != 1)) {
             print_error("Failed to read colony data");
             fclose(file);
             destroy_world(world);
@@ -173,31 +491,30 @@ World* load_simulation(const char* filename) {
         
         // Update grid to reflect colony position
         if (is_valid_position(world, colony->nest_pos.x, colony->nest_pos.y)) {
-            world->grid[colony->nest_pos.y][colony->nest_pos.x].terrain = TERRAIN_NEST;
-            world->grid[colony->nest_pos.y][colony->nest_pos.x].colony_id = i;
+            Cell nest;
+            get_cell(world, colony->nest_pos.x, colony->nest_pos.y, &nest);
+            nest.terrain = TERRAIN_NEST;
+            nest.colony_id = i;
+            set_cell(world, colony->nest_pos.x, colony->nest_pos.y, &nest);
         }
     }
     
     // Read grid data
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            Cell* cell = &world->grid[y][x];
-            if (fread(&cell->terrain, sizeof(TerrainType), 1, file) != 1 ||
-                fread(&cell->pheromone_food, sizeof(float), 1, file) != 1 ||
-                fread(&cell->pheromone_home, sizeof(float), 1, file) != 1 ||
-                fread(&cell->food_amount, sizeof(int), 1, file) != 1 ||
-                fread(&cell->colony_id, sizeof(int), 1, file) != 1) {
-                print_error("Failed to read grid data");
-                fclose(file);
-                destroy_world(world);
-                return NULL;
-            }
-        }
+    int grid_ok = legacy_grid ? read_legacy_grid(world, file) : read_chunks(world, file);
+    if (!grid_ok) {
+        print_error("Failed to read grid data");
+        fclose(file);
+        destroy_world(world);
+        return NULL;
     }
+    count_territory(world);
     
-    // Read ants data
+    // Read ants data; the colony's ant counters are rebuilt as they are added
     for (int i = 0; i < colony_count; i++) {
         Colony* colony = &world->colonies[i];
+        colony->total_ants = 0;
+        colony->active_ants = 0;
+        colony->carrying_ants = 0;
         
         while (1) {
             int ant_id;
@@ -231,21 +548,38 @@ World* load_simulation(const char* filename) {
                 return NULL;
             }
             
-            // Create and add ant
-            Ant* ant = create_ant(ant_id, colony_id, pos);
-            if (ant != NULL) {
-                ant->last_pos = last_pos;
-                ant->state = state;
-                ant->energy = energy;
-                ant->food_carrying = food_carrying;
-                ant->steps_taken = steps_taken;
-                ant->food_delivered = food_delivered;
-                add_ant_to_colony(colony, ant);
+            // Moves, deposits and the ant index all assume ants in the world
+            if (!is_valid_position(world, pos.x, pos.y) ||
+                !is_valid_position(world, last_pos.x, last_pos.y)) {
+                print_error("Ant %d is outside the world", ant_id);
+                fclose(file);
+                destroy_world(world);
+                return NULL;
+            }
+            
+            // Add the ant to the colony whose section it is in
+            Ant ant;
+            init_ant(&ant, ant_id, i, pos);
+            ant.last_pos = last_pos;
+            ant.state = state;
+            ant.energy = energy;
+            ant.food_carrying = food_carrying;
+            ant.steps_taken = steps_taken;
+            ant.food_delivered = food_delivered;
+            if (add_ant_to_colony(colony, &ant) < 0) {
+                print_error("Failed to allocate ant data");
+                fclose(file);
+                destroy_world(world);
+                return NULL;
             }
         }
     }
     
     fclose(file);
+    build_ant_index(world);
+    update_colony_statistics(world);
+    update_pheromone_stats(world);
+    discard_pheromone_deposits();  // Queued for the world this one replaces
     print_info("Simulation loaded from %s", filename);
     return world;
 }
@@ -270,20 +604,32 @@ int save_statistics(const World* world, const char* filename) {
     
     // Write CSV header if file is empty
     if (ftell(file) == 0) {
-        fprintf(file, "Timestamp,Step,Colony,Food_Collected,Total_Ants,Active_Ants,Efficiency\n");
+        fprintf(file, "Timestamp,Step,Colony,Food_Collected,Total_Ants,Active_Ants,Efficiency,"
+                      "Carrying_Ants,Distance_Traveled,Territory,"
+                      "Food_Pheromone_Max,Food_Pheromone_Sum,Food_Pheromone_Coverage,"
+                      "Home_Pheromone_Max,Home_Pheromone_Sum,Home_Pheromone_Coverage\n");
     }
     
-    // Write statistics for each colony
+    // Write statistics for each colony; the pheromone columns are the
+    // world's, repeated on every row
+    const PheromoneStats* pheromones = &world->pheromone_stats;
+    const PheromoneFieldStats* food = &pheromones->types[PHEROMONE_TYPE_FOOD];
+    const PheromoneFieldStats* home = &pheromones->types[PHEROMONE_TYPE_HOME];
     for (int i = 0; i < world->colony_count; i++) {
         Colony* colony = &world->colonies[i];
-        fprintf(file, "%s,%d,%d,%d,%d,%d,%.2f\n",
+        fprintf(file, "%s,%d,%d,%d,%d,%d,%.2f,%d,%.1f,%d,%.2f,%.1f,%.2f,%.2f,%.1f,%.2f\n",
                 timestamp,
                 world->current_step,
                 colony->id,
                 colony->food_collected,
                 colony->total_ants,
                 colony->active_ants,
-                colony->efficiency_score);
+                colony->efficiency_score,
+                colony->carrying_ants,
+                colony->total_distance_traveled,
+                colony->territory_size,
+                food->max, food->sum, get_pheromone_coverage(pheromones, PHEROMONE_TYPE_FOOD),
+                home->max, home->sum, get_pheromone_coverage(pheromones, PHEROMONE_TYPE_HOME));
     }
     
     fclose(file);
@@ -319,10 +665,9 @@ int export_map(const World* world, const char* filename) {
     // Write map
     for (int y = 0; y < world->height; y++) {
         for (int x = 0; x < world->width; x++) {
-            Cell* cell = &world->grid[y][x];
             char symbol;
             
-            switch (cell->terrain) {
+            switch (get_terrain(world, x, y)) {
                 case TERRAIN_NEST: symbol = 'N'; break;
                 case TERRAIN_FOOD: symbol = 'F'; break;
                 case TERRAIN_WALL: symbol = '#'; break;
@@ -367,26 +712,29 @@ int load_map(World* world, const char* filename) {
         int x = 0;
         for (int i = 0; line[i] != '\0' && line[i] != '\n' && line[i] != '\r' && x < world->width; i++) {
             char symbol = line[i];
+            Cell cell;
+            get_cell(world, x, y, &cell);
             
             if (symbol == 'N') {
                 // Find which colony this nest belongs to
                 for (int c = 0; c < world->colony_count; c++) {
                     if (world->colonies[c].nest_pos.x == x && world->colonies[c].nest_pos.y == y) {
-                        world->grid[y][x].terrain = TERRAIN_NEST;
-                        world->grid[y][x].colony_id = c;
+                        cell.terrain = TERRAIN_NEST;
+                        cell.colony_id = c;
                         break;
                     }
                 }
             } else if (symbol == 'F') {
-                world->grid[y][x].terrain = TERRAIN_FOOD;
-                world->grid[y][x].food_amount = 50; // Default food amount
+                cell.terrain = TERRAIN_FOOD;
+                cell.food_amount = 50; // Default food amount
             } else if (symbol == '#') {
-                world->grid[y][x].terrain = TERRAIN_WALL;
+                cell.terrain = TERRAIN_WALL;
             } else if (symbol == '~') {
-                world->grid[y][x].terrain = TERRAIN_WATER;
+                cell.terrain = TERRAIN_WATER;
             } else {
-                world->grid[y][x].terrain = TERRAIN_EMPTY;
+                cell.terrain = TERRAIN_EMPTY;
             }
+            set_cell(world, x, y, &cell);
             
             x++;
         }
@@ -17,7 +17,8 @@ int validate_save_file(const char* filename);
 int create_backup_save(const char* filename);
 
 // File format constants
-#define SAVE_FILE_VERSION "1.0"
+#define SAVE_FILE_VERSION "1.1"         // Allocated chunks, packed cells, pheromone per channel
+#define SAVE_FILE_VERSION_LEGACY "1.0"  // Grid stored cell by cell
 #define SAVE_FILE_HEADER "ACO_SIM"
 #define MAX_FILENAME_LENGTH 256
 
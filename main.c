@@ -2,6 +2,8 @@
 #include "data_structures.h"
 #include "config.h"
 #include "visualization.h"   // render_frame(), request_full_redraw()
+#include "pheromone_kernels.h"
+#include "worker_pool.h"
 #include <conio.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,6 +17,31 @@ static int g_program_running = 1;
 int main(int argc, char* argv[]) {
     initialize_program();
     
+    // --threads N, --pheromone-block K, --pheromone-implicit DT,
+    // --pheromone-walkable 0|1, --pheromone-deferred 0|1 and --sense-radius R
+    // may precede any other option
+    while (argc > 2 && (strcmp(argv[1], "--threads") == 0 || strcmp(argv[1], "--pheromone-block") == 0 ||
+                        strcmp(argv[1], "--pheromone-implicit") == 0 ||
+                        strcmp(argv[1], "--pheromone-walkable") == 0 ||
+                        strcmp(argv[1], "--pheromone-deferred") == 0 || strcmp(argv[1], "--sense-radius") == 0)) {
+        if (strcmp(argv[1], "--threads") == 0) {
+            set_worker_threads(atoi(argv[2]));
+        } else if (strcmp(argv[1], "--pheromone-block") == 0) {
+            set_pheromone_block_ticks(atoi(argv[2]));
+        } else if (strcmp(argv[1], "--pheromone-implicit") == 0) {
+            set_pheromone_implicit_dt(atoi(argv[2]));
+        } else if (strcmp(argv[1], "--pheromone-walkable") == 0) {
+            set_pheromone_walkable_only(atoi(argv[2]));
+        } else if (strcmp(argv[1], "--pheromone-deferred") == 0) {
+            set_pheromone_deferred_deposits(atoi(argv[2]));
+        } else {
+            set_pheromone_sense_radius(atoi(argv[2]));
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    
     // Handle command line arguments
     if (argc > 1) {
         if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
@@ -24,7 +51,94 @@ int main(int argc, char* argv[]) {
             printf("  --help, -h     Show this help message\n");
             printf("  --load <file>  Load simulation from file\n");
             printf("  --test         Run test scenario\n");
+            printf("  --benchmark [width height ants ticks]\n");
+            printf("                 Headless large-world benchmark (default %dx%d, %d ants, %d ticks)\n",
+                   BENCHMARK_DEFAULT_WIDTH, BENCHMARK_DEFAULT_HEIGHT,
+                   BENCHMARK_DEFAULT_ANTS, BENCHMARK_DEFAULT_TICKS);
+            printf("  --benchmark-sparse [width height ants ticks]\n");
+            printf("                 Same, on a mostly empty world (nests and nearby food only)\n");
+            printf("  --benchmark-diffusion [width height ants ticks]\n");
+            printf("                 Same, with pheromone on every cell (diffusion-heavy)\n");
+            printf("  --benchmark-colonies [width height ants ticks]\n");
+            printf("                 Sparse benchmark with %d colonies, each on its own trails\n",
+                   BENCHMARK_MANY_COLONIES);
+            printf("  --benchmark-threads [width height ants ticks]\n");
+            printf("                 Diffusion benchmark at 1, 2, 4, ... threads, with speedups\n");
+            printf("  --benchmark-blocking [width height ants ticks]\n");
+            printf("                 Diffusion benchmark at pheromone blocks of 1, 2, 4, ... ticks\n");
+            printf("  --benchmark-implicit [width height dt updates]\n");
+            printf("                 Explicit diffusion ticks to match implicit updates of dt ticks\n");
+            printf("                 (default %dx%d, dt %d, %d updates), with timings\n",
+                   BENCHMARK_IMPLICIT_SIZE, BENCHMARK_IMPLICIT_SIZE, BENCHMARK_IMPLICIT_DT,
+                   BENCHMARK_IMPLICIT_UPDATES);
+            printf("  --threads <n>  Worker threads for the pheromone update (0 = one per processor);\n");
+            printf("                 may precede any other option\n");
+            printf("  --pheromone-block <k>\n");
+            printf("                 Advance the pheromone planes k ticks at a time (1-%d, default 1);\n",
+                   PHEROMONE_BLOCK_MAX_TICKS);
+            printf("                 ants follow trails up to k-1 ticks old. May precede any other option\n");
+            printf("  --pheromone-implicit <dt>\n");
+            printf("                 Spread pheromone as far as dt ticks each tick (1-%d, default 0 = off)\n",
+                   PHEROMONE_IMPLICIT_MAX_DT);
+            printf("                 with an implicit solver that stops at walls. May precede any other option\n");
+            printf("  --pheromone-walkable <0|1>\n");
+            printf("                 Diffuse pheromone between walkable cells only (default 0), skipping\n");
+            printf("                 walls. May precede any other option\n");
+            printf("  --pheromone-deferred <0|1>\n");
+            printf("                 Buffer ant deposits and add them up per cell after the ant update\n");
+            printf("                 (default 0). May precede any other option\n");
+            printf("  --sense-radius <r>\n");
+            printf("                 Ants weigh the pheromone up to r cells away (1-%d, default %d) in 8\n",
+                   PHEROMONE_SENSE_RADIUS_MAX, PHEROMONE_SENSE_RADIUS_DEFAULT);
+            printf("                 sectors instead of the 8 neighbours. May precede any other option\n");
+            printf("  --check-kernels  Compare the vectorized pheromone kernels with the scalar one\n");
+            printf("  --check-fused    Compare the one-pass pheromone update with evaporation and\n");
+            printf("                 diffusion run separately\n");
+            printf("  --check-deposits Compare deferred deposits merged from 1 to %d bands with serial ones\n",
+                   MAX_WORKER_THREADS);
             return 0;
+        } else if (strcmp(argv[1], "--benchmark") == 0 || strcmp(argv[1], "--benchmark-sparse") == 0 ||
+                   strcmp(argv[1], "--benchmark-diffusion") == 0 || strcmp(argv[1], "--benchmark-colonies") == 0) {
+            int scenario = BENCHMARK_SCENARIO_RANDOM;
+            if (strcmp(argv[1], "--benchmark-sparse") == 0) scenario = BENCHMARK_SCENARIO_SPARSE;
+            if (strcmp(argv[1], "--benchmark-diffusion") == 0) scenario = BENCHMARK_SCENARIO_DIFFUSION;
+            if (strcmp(argv[1], "--benchmark-colonies") == 0) scenario = BENCHMARK_SCENARIO_COLONIES;
+            int width = (argc > 2) ? atoi(argv[2]) : BENCHMARK_DEFAULT_WIDTH;
+            int height = (argc > 3) ? atoi(argv[3]) : BENCHMARK_DEFAULT_HEIGHT;
+            int ants = (argc > 4) ? atoi(argv[4]) : BENCHMARK_DEFAULT_ANTS;
+            int ticks = (argc > 5) ? atoi(argv[5]) : BENCHMARK_DEFAULT_TICKS;
+            int result = run_benchmark(width, height, ants, ticks, scenario);
+            shutdown_worker_pool();
+            return result;
+        } else if (strcmp(argv[1], "--benchmark-threads") == 0 || strcmp(argv[1], "--benchmark-blocking") == 0) {
+            int width = (argc > 2) ? atoi(argv[2]) : BENCHMARK_DEFAULT_WIDTH;
+            int height = (argc > 3) ? atoi(argv[3]) : BENCHMARK_DEFAULT_HEIGHT;
+            int ants = (argc > 4) ? atoi(argv[4]) : BENCHMARK_DEFAULT_ANTS;
+            int ticks = (argc > 5) ? atoi(argv[5]) : BENCHMARK_DEFAULT_TICKS;
+            int result = (strcmp(argv[1], "--benchmark-threads") == 0)
+                             ? run_thread_scaling_benchmark(width, height, ants, ticks)
+                             : run_blocking_benchmark(width, height, ants, ticks);
+            shutdown_worker_pool();
+            return result;
+        } else if (strcmp(argv[1], "--benchmark-implicit") == 0) {
+            int width = (argc > 2) ? atoi(argv[2]) : BENCHMARK_IMPLICIT_SIZE;
+            int height = (argc > 3) ? atoi(argv[3]) : BENCHMARK_IMPLICIT_SIZE;
+            int dt = (argc > 4) ? atoi(argv[4]) : BENCHMARK_IMPLICIT_DT;
+            int updates = (argc > 5) ? atoi(argv[5]) : BENCHMARK_IMPLICIT_UPDATES;
+            int result = run_implicit_benchmark(width, height, dt, updates);
+            shutdown_worker_pool();
+            return result;
+        } else if (strcmp(argv[1], "--check-kernels") == 0) {
+            printf("Pheromone kernel in use: %s\n", get_pheromone_kernels()->name);
+            return check_pheromone_kernels() ? 1 : 0;
+        } else if (strcmp(argv[1], "--check-deposits") == 0) {
+            int result = check_deferred_deposits() ? 1 : 0;
+            shutdown_worker_pool();
+            return result;
+        } else if (strcmp(argv[1], "--check-fused") == 0) {
+            int result = check_fused_pheromone_update() ? 1 : 0;
+            shutdown_worker_pool();
+            return result;
         } else if (strcmp(argv[1], "--load") == 0 && argc > 2) {
             g_world = load_simulation(argv[2]);
             if (g_world == NULL) {
@@ -81,12 +195,7 @@ void run_simulation(World* world) {
         
         if (!world->paused) {
             // Update simulation
-            update_all_ants(world);
-            evaporate_pheromones(world);
-            diffuse_pheromones(world);
-            update_colony_statistics(world);
-            
-            world->current_step++;
+            simulation_step(world);
             
             // Check for simulation end conditions
             if (world->current_step >= MAX_SIMULATION_STEPS) {
@@ -96,14 +205,9 @@ void run_simulation(World* world) {
             }
             
             // Check if all food is collected
-            int total_food = 0;
-            for (int y = 0; y < world->height; y++) {
-                for (int x = 0; x < world->width; x++) {
-                    if (world->grid[y][x].terrain == TERRAIN_FOOD) {
-                        total_food += world->grid[y][x].food_amount;
-                    }
-                }
-            }
+            profiler_begin(PROFILE_FOOD_CHECK);
+            long long total_food = count_remaining_food(world);
+            profiler_end(PROFILE_FOOD_CHECK);
             
             if (total_food == 0) {
                 print_info("All food collected! Simulation complete.");
@@ -146,6 +250,7 @@ void handle_user_input(World* world) {
             {
                 char filename[256];
                 snprintf(filename, sizeof(filename), "data/saves/simulation_%d.sav", world->current_step);
+                flush_pheromone_block(world);  // Saves hold the planes as of now
                 if (save_simulation(world, filename) == FILE_IO_SUCCESS) {
                     print_info("Simulation saved to %s", filename);
                 }
@@ -298,7 +403,7 @@ void create_new_simulation(void) {
     
     int width, height, colonies;
     
-    printf("Enter world width (10-100): ");
+    printf("Enter world width (10-%d, above %d runs in large-world mode): ", MAX_WORLD_SIZE, MAX_RENDER_WORLD_SIZE);
     if (scanf("%d", &width) != 1) {
         print_error("Invalid width input");
         while (getchar() != '\n'); // Clear input buffer
@@ -306,7 +411,7 @@ void create_new_simulation(void) {
     }
     width = clamp_int(width, 10, MAX_WORLD_SIZE);
     
-    printf("Enter world height (10-100): ");
+    printf("Enter world height (10-%d): ", MAX_WORLD_SIZE);
     if (scanf("%d", &height) != 1) {
         print_error("Invalid height input");
         while (getchar() != '\n'); // Clear input buffer
@@ -314,13 +419,28 @@ void create_new_simulation(void) {
     }
     height = clamp_int(height, 10, MAX_WORLD_SIZE);
     
-    printf("Enter number of colonies (1-5): ");
+    // As many colonies as fit evenly spaced, and never fewer than 5
+    int max_colonies = get_colony_capacity(width, height);
+    if (max_colonies < 5) max_colonies = 5;
+    printf("Enter number of colonies (1-%d): ", max_colonies);
     if (scanf("%d", &colonies) != 1) {
         print_error("Invalid colonies input");
         while (getchar() != '\n'); // Clear input buffer
         return;
     }
-    colonies = clamp_int(colonies, 1, 5);
+    colonies = clamp_int(colonies, 1, max_colonies);
+    
+    char wrap = 'n';
+    printf("Wrap around world edges (toroidal world)? (y/n): ");
+    if (scanf(" %c", &wrap) != 1) {
+        wrap = 'n';
+    }
+    
+    char private_trails = 'n';
+    printf("Private trails (each colony follows only its own pheromone)? (y/n): ");
+    if (scanf(" %c", &private_trails) != 1) {
+        private_trails = 'n';
+    }
     
     // Clear input buffer after all scanf calls
     while (getchar() != '\n');
@@ -328,12 +448,11 @@ void create_new_simulation(void) {
     // Create world
     g_world = create_world(width, height, colonies);
     if (g_world != NULL) {
+        set_world_toroidal(g_world, wrap == 'y' || wrap == 'Y');
+        g_world->private_trails = (private_trails == 'y' || private_trails == 'Y');
+        
         // Place colonies
-        for (int i = 0; i < colonies; i++) {
-            int x = (width / (colonies + 1)) * (i + 1);
-            int y = height / 2;
-            place_colony(g_world, i, x, y);
-        }
+        place_colonies_evenly(g_world);
         
         // Initialize world
         initialize_world_random(g_world);
@@ -499,20 +618,19 @@ void reset_simulation(World* world) {
         for (int i = 0; i < world->colony_count; i++) {
             world->colonies[i].food_collected = 0;
             world->colonies[i].efficiency_score = 0.0f;
+            world->colonies[i].straight_moves = 0;
+            world->colonies[i].diagonal_moves = 0;
+            world->colonies[i].total_distance_traveled = 0.0f;
         }
+        clear_territory(world);
         
         // Clear all ants
         for (int i = 0; i < world->colony_count; i++) {
             Colony* colony = &world->colonies[i];
-            Ant* current = colony->ants_head;
-            while (current != NULL) {
-                Ant* next = current->next;
-                destroy_ant(current);
-                current = next;
-            }
-            colony->ants_head = NULL;
+            clear_ant_pool(&colony->ants);
             colony->total_ants = 0;
             colony->active_ants = 0;
+            colony->carrying_ants = 0;
         }
         
         // Spawn new ants
@@ -552,6 +670,8 @@ void cleanup_program(void) {
         g_world = NULL;
     }
     
+    shutdown_worker_pool();
+    
     // Cleanup console
     cleanup_console();
     
@@ -11,6 +11,9 @@
 #include "file_io.h"
 #include "algorithms.h"
 #include "utils.h"
+#include "profiler.h"
+#include "simulation.h"
+#include "benchmark.h"
 
 // Main program functions
 int main(int argc, char* argv[]);
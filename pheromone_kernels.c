@@ -0,0 +1,749 @@
+#include "pheromone_kernels.h"
+#include "config.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHEROMONE_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KERNEL_TARGET(isa)
+#else
+#include <cpuid.h>
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+// Every kernel must round exactly as the scalar one, so a multiply and an
+// add are never fused into one FMA (GCC fuses across statements by default,
+// clang within one). MSVC only fuses with /fp:fast or /fp:contract.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#define EVAPORATION_FACTOR (1.0f - PHEROMONE_EVAPORATION_RATE)
+#define DIFFUSION_KEEP (1.0f - PHEROMONE_DIFFUSION_RATE)
+
+// Scalar kernels, also the tails of the vector ones
+static inline float evaporated(float level) {
+    level *= EVAPORATION_FACTOR;
+    return (level < PHEROMONE_MIN_THRESHOLD) ? 0.0f : level;
+}
+
+float evaporated_pheromone(float level) {
+    return evaporated(level);
+}
+
+static void evaporate_row_scalar(const float* src, float* dst, int count) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = evaporated(src[i]);
+    }
+}
+
+static int diffuse_row_scalar(const float* above, const float* mid, const float* below,
+                              float* dst, int count) {
+    int active = 0;
+    for (int x = 0; x < count; x++) {
+        float neighbor_contribution =
+            above[x - 1] + above[x] + above[x + 1] +
+            mid[x - 1] + mid[x + 1] +
+            below[x - 1] + below[x] + below[x + 1];
+        dst[x] = mid[x] * DIFFUSION_KEEP + (neighbor_contribution * PHEROMONE_DIFFUSION_RATE) / 8;
+        active |= (dst[x] != 0.0f);
+    }
+    return active;
+}
+
+static int diffuse_weighted_row_scalar(const float* above, const float* mid, const float* below,
+                                       const float* keep, const float* share, float* dst, int count) {
+    int active = 0;
+    for (int x = 0; x < count; x++) {
+        float neighbor_contribution =
+            above[x - 1] + above[x] + above[x + 1] +
+            mid[x - 1] + mid[x + 1] +
+            below[x - 1] + below[x] + below[x + 1];
+        dst[x] = mid[x] * keep[x] + neighbor_contribution * share[x];
+        active |= (dst[x] != 0.0f);
+    }
+    return active;
+}
+
+// Fixed-point rows. Levels are at most PHEROMONE_MAX, so value + dither
+// stays below 65536 and truncation rounds down. The dither table holds the
+// 16 offsets (k + 0.5) / 16 in a scattered order, twice, so any 16
+// consecutive entries are all of them.
+#define FIXED_MAX_VALUE ((int)(PHEROMONE_MAX * PHEROMONE_FIXED_SCALE))
+#define FIXED_UNIT (1.0f / PHEROMONE_FIXED_SCALE)
+
+static const float g_dither[32] = {
+    0.03125f, 0.53125f, 0.28125f, 0.78125f, 0.15625f, 0.65625f, 0.40625f, 0.90625f,
+    0.09375f, 0.59375f, 0.34375f, 0.84375f, 0.21875f, 0.71875f, 0.46875f, 0.96875f,
+    0.03125f, 0.53125f, 0.28125f, 0.78125f, 0.15625f, 0.65625f, 0.40625f, 0.90625f,
+    0.09375f, 0.59375f, 0.34375f, 0.84375f, 0.21875f, 0.71875f, 0.46875f, 0.96875f
+};
+
+static void unpack_row_scalar(const uint16_t* src, float* dst, int count) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = (float)src[i] * FIXED_UNIT;
+    }
+}
+
+// Cell i of a packed row gets dither[(seed + i) & 15]; first is the index
+// of src[0] in the row, for the tails of the vector kernels
+static void pack_cells_scalar(const float* src, uint16_t* dst, int count, unsigned int seed, int first) {
+    const float* dither = g_dither + (seed & 15);
+    for (int i = 0; i < count; i++) {
+        float value = src[i] * PHEROMONE_FIXED_SCALE + dither[(first + i) & 15];
+        if (value < 0.0f) value = 0.0f;
+        if (value > (float)FIXED_MAX_VALUE) value = (float)FIXED_MAX_VALUE;
+        dst[i] = (uint16_t)value;
+    }
+}
+
+static void pack_row_scalar(const float* src, uint16_t* dst, int count, unsigned int seed) {
+    pack_cells_scalar(src, dst, count, seed, 0);
+}
+
+// Row reductions. Levels are never negative, so the max starts at 0. The
+// scalar kernel counts each non-empty cell in its bin. The vector ones
+// count per lane the cells at or above each bin instead, comparing with
+// the bins' lower edges in turn until no lane reaches one; most cells sit
+// in the low bins, so a step rarely needs many compares. A cell is in bin
+// b or above exactly when its scaled level is at least b, so both come to
+// the same histogram.
+#define REDUCE_LANES PHEROMONE_REDUCE_LANES
+#define HISTOGRAM_SCALE ((float)PHEROMONE_HISTOGRAM_BINS / PHEROMONE_MAX)
+#define HISTOGRAM_LAST_BIN ((float)(PHEROMONE_HISTOGRAM_BINS - 1))
+
+// Also the tails of the vector kernels, from a multiple of REDUCE_LANES
+// cells into the row
+static void reduce_row_scalar(const float* src, int count, PheromoneReduction* reduction) {
+    for (int i = 0; i < count; i++) {
+        float level = src[i];
+        reduction->sums[i & (REDUCE_LANES - 1)] += level;
+        if (level > reduction->max) reduction->max = level;
+        if (level == 0.0f) continue;
+        
+        float scaled = level * HISTOGRAM_SCALE;
+        if (scaled > HISTOGRAM_LAST_BIN) scaled = HISTOGRAM_LAST_BIN;
+        reduction->counts[(int)scaled]++;
+    }
+}
+
+float pheromone_reduction_sum(const PheromoneReduction* reduction) {
+    float lanes[REDUCE_LANES];
+    memcpy(lanes, reduction->sums, sizeof(lanes));
+    for (int width = REDUCE_LANES / 2; width > 0; width /= 2) {
+        for (int i = 0; i < width; i++) {
+            lanes[i] += lanes[i + width];
+        }
+    }
+    return lanes[0];
+}
+
+void pheromone_reduction_histogram(const PheromoneReduction* reduction, int histogram[PHEROMONE_HISTOGRAM_BINS]) {
+    int at_least[PHEROMONE_HISTOGRAM_BINS + 1] = {0};
+    for (int bin = 0; bin < PHEROMONE_HISTOGRAM_BINS; bin++) {
+        for (int lane = 0; lane < REDUCE_LANES; lane++) {
+            at_least[bin] += reduction->at_least[bin][lane];
+        }
+    }
+    for (int bin = 0; bin < PHEROMONE_HISTOGRAM_BINS; bin++) {
+        histogram[bin] = reduction->counts[bin] + at_least[bin] - at_least[bin + 1];
+    }
+}
+
+#ifdef PHEROMONE_KERNELS_X86
+// The vector kernels divide by 8 as a multiply by 0.125, which is exact
+
+// SSE2: 4 cells per step
+static void evaporate_row_sse2(const float* src, float* dst, int count) {
+    const __m128 factor = _mm_set1_ps(EVAPORATION_FACTOR);
+    const __m128 threshold = _mm_set1_ps(PHEROMONE_MIN_THRESHOLD);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 level = _mm_mul_ps(_mm_loadu_ps(src + i), factor);
+        _mm_storeu_ps(dst + i, _mm_andnot_ps(_mm_cmplt_ps(level, threshold), level));
+    }
+    evaporate_row_scalar(src + i, dst + i, count - i);
+}
+
+static int diffuse_row_sse2(const float* above, const float* mid, const float* below,
+                            float* dst, int count) {
+    const __m128 keep = _mm_set1_ps(DIFFUSION_KEEP);
+    const __m128 rate = _mm_set1_ps(PHEROMONE_DIFFUSION_RATE);
+    const __m128 eighth = _mm_set1_ps(0.125f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 nonzero = zero;
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(above + x - 1), _mm_loadu_ps(above + x));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(above + x + 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(mid + x - 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(mid + x + 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(below + x - 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(below + x));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(below + x + 1));
+        __m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(mid + x), keep),
+                                   _mm_mul_ps(_mm_mul_ps(sum, rate), eighth));
+        _mm_storeu_ps(dst + x, result);
+        nonzero = _mm_or_ps(nonzero, _mm_cmpneq_ps(result, zero));
+    }
+    int active = _mm_movemask_ps(nonzero) != 0;
+    return diffuse_row_scalar(above + x, mid + x, below + x, dst + x, count - x) | active;
+}
+
+static int diffuse_weighted_row_sse2(const float* above, const float* mid, const float* below,
+                                     const float* keep, const float* share, float* dst, int count) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 nonzero = zero;
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(above + x - 1), _mm_loadu_ps(above + x));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(above + x + 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(mid + x - 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(mid + x + 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(below + x - 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(below + x));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(below + x + 1));
+        __m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(mid + x), _mm_loadu_ps(keep + x)),
+                                   _mm_mul_ps(sum, _mm_loadu_ps(share + x)));
+        _mm_storeu_ps(dst + x, result);
+        nonzero = _mm_or_ps(nonzero, _mm_cmpneq_ps(result, zero));
+    }
+    int active = _mm_movemask_ps(nonzero) != 0;
+    return diffuse_weighted_row_scalar(above + x, mid + x, below + x, keep + x, share + x,
+                                       dst + x, count - x) | active;
+}
+
+static void unpack_row_sse2(const uint16_t* src, float* dst, int count) {
+    const __m128 unit = _mm_set1_ps(FIXED_UNIT);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(values, zero)), unit));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(values, zero)), unit));
+    }
+    unpack_row_scalar(src + i, dst + i, count - i);
+}
+
+// SSE2 only packs with signed saturation, so values are moved down by
+// 32768 first and the sign bit flipped back afterwards
+static void pack_row_sse2(const float* src, uint16_t* dst, int count, unsigned int seed) {
+    const float* dither = g_dither + (seed & 15);
+    const __m128 scale = _mm_set1_ps(PHEROMONE_FIXED_SCALE);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 limit = _mm_set1_ps((float)FIXED_MAX_VALUE);
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i flip = _mm_set1_epi16((short)0x8000);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float* offsets = dither + (i & 15);
+        __m128 low = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), _mm_loadu_ps(offsets));
+        __m128 high = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), _mm_loadu_ps(offsets + 4));
+        low = _mm_min_ps(_mm_max_ps(low, zero), limit);
+        high = _mm_min_ps(_mm_max_ps(high, zero), limit);
+        __m128i packed = _mm_packs_epi32(_mm_sub_epi32(_mm_cvttps_epi32(low), bias),
+                                         _mm_sub_epi32(_mm_cvttps_epi32(high), bias));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(packed, flip));
+    }
+    pack_cells_scalar(src + i, dst + i, count - i, seed, i);
+}
+
+// 16 cells per step, a register of 4 lanes for each quarter
+static void reduce_row_sse2(const float* src, int count, PheromoneReduction* reduction) {
+    const __m128 scale = _mm_set1_ps(HISTOGRAM_SCALE);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 sums[4], maxes = zero;
+    for (int k = 0; k < 4; k++) {
+        sums[k] = _mm_loadu_ps(reduction->sums + 4 * k);
+    }
+    int i = 0;
+    for (; i + REDUCE_LANES <= count; i += REDUCE_LANES) {
+        for (int k = 0; k < 4; k++) {
+            __m128 level = _mm_loadu_ps(src + i + 4 * k);
+            sums[k] = _mm_add_ps(sums[k], level);
+            maxes = _mm_max_ps(maxes, level);
+            
+            // A true compare is -1 in its lane
+            __m128 scaled = _mm_mul_ps(level, scale);
+            __m128 reached = _mm_cmpneq_ps(level, zero);
+            for (int bin = 0; bin < PHEROMONE_HISTOGRAM_BINS && _mm_movemask_ps(reached) != 0; bin++) {
+                __m128i* lanes = (__m128i*)(reduction->at_least[bin] + 4 * k);
+                _mm_storeu_si128(lanes, _mm_sub_epi32(_mm_loadu_si128(lanes), _mm_castps_si128(reached)));
+                reached = _mm_cmpge_ps(scaled, _mm_set1_ps((float)(bin + 1)));
+            }
+        }
+    }
+    
+    float max_lanes[4];
+    for (int k = 0; k < 4; k++) {
+        _mm_storeu_ps(reduction->sums + 4 * k, sums[k]);
+    }
+    _mm_storeu_ps(max_lanes, maxes);
+    for (int k = 0; k < 4; k++) {
+        if (max_lanes[k] > reduction->max) reduction->max = max_lanes[k];
+    }
+    reduce_row_scalar(src + i, count - i, reduction);
+}
+
+// AVX2: 8 cells per step
+KERNEL_TARGET("avx2")
+static void evaporate_row_avx2(const float* src, float* dst, int count) {
+    const __m256 factor = _mm256_set1_ps(EVAPORATION_FACTOR);
+    const __m256 threshold = _mm256_set1_ps(PHEROMONE_MIN_THRESHOLD);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 level = _mm256_mul_ps(_mm256_loadu_ps(src + i), factor);
+        _mm256_storeu_ps(dst + i, _mm256_andnot_ps(_mm256_cmp_ps(level, threshold, _CMP_LT_OQ), level));
+    }
+    evaporate_row_scalar(src + i, dst + i, count - i);
+}
+
+KERNEL_TARGET("avx2")
+static int diffuse_row_avx2(const float* above, const float* mid, const float* below,
+                            float* dst, int count) {
+    const __m256 keep = _mm256_set1_ps(DIFFUSION_KEEP);
+    const __m256 rate = _mm256_set1_ps(PHEROMONE_DIFFUSION_RATE);
+    const __m256 eighth = _mm256_set1_ps(0.125f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 nonzero = zero;
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(above + x - 1), _mm256_loadu_ps(above + x));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(above + x + 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(mid + x - 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(mid + x + 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(below + x - 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(below + x));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(below + x + 1));
+        __m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(mid + x), keep),
+                                      _mm256_mul_ps(_mm256_mul_ps(sum, rate), eighth));
+        _mm256_storeu_ps(dst + x, result);
+        nonzero = _mm256_or_ps(nonzero, _mm256_cmp_ps(result, zero, _CMP_NEQ_UQ));
+    }
+    int active = _mm256_movemask_ps(nonzero) != 0;
+    return diffuse_row_scalar(above + x, mid + x, below + x, dst + x, count - x) | active;
+}
+
+KERNEL_TARGET("avx2")
+static int diffuse_weighted_row_avx2(const float* above, const float* mid, const float* below,
+                                     const float* keep, const float* share, float* dst, int count) {
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 nonzero = zero;
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(above + x - 1), _mm256_loadu_ps(above + x));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(above + x + 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(mid + x - 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(mid + x + 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(below + x - 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(below + x));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(below + x + 1));
+        __m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(mid + x), _mm256_loadu_ps(keep + x)),
+                                      _mm256_mul_ps(sum, _mm256_loadu_ps(share + x)));
+        _mm256_storeu_ps(dst + x, result);
+        nonzero = _mm256_or_ps(nonzero, _mm256_cmp_ps(result, zero, _CMP_NEQ_UQ));
+    }
+    int active = _mm256_movemask_ps(nonzero) != 0;
+    return diffuse_weighted_row_scalar(above + x, mid + x, below + x, keep + x, share + x,
+                                       dst + x, count - x) | active;
+}
+
+KERNEL_TARGET("avx2")
+static void unpack_row_avx2(const uint16_t* src, float* dst, int count) {
+    const __m256 unit = _mm256_set1_ps(FIXED_UNIT);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i values = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), unit));
+    }
+    unpack_row_scalar(src + i, dst + i, count - i);
+}
+
+KERNEL_TARGET("avx2")
+static void pack_row_avx2(const float* src, uint16_t* dst, int count, unsigned int seed) {
+    const float* dither = g_dither + (seed & 15);
+    const __m256 scale = _mm256_set1_ps(PHEROMONE_FIXED_SCALE);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 limit = _mm256_set1_ps((float)FIXED_MAX_VALUE);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale),
+                                     _mm256_loadu_ps(dither + (i & 15)));
+        value = _mm256_min_ps(_mm256_max_ps(value, zero), limit);
+        __m256i values = _mm256_cvttps_epi32(value);
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+        _mm_storeu_si128((__m128i*)(dst + i), packed);
+    }
+    pack_cells_scalar(src + i, dst + i, count - i, seed, i);
+}
+
+KERNEL_TARGET("avx2")
+static void reduce_row_avx2(const float* src, int count, PheromoneReduction* reduction) {
+    const __m256 scale = _mm256_set1_ps(HISTOGRAM_SCALE);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 sums[2], maxes = zero;
+    sums[0] = _mm256_loadu_ps(reduction->sums);
+    sums[1] = _mm256_loadu_ps(reduction->sums + 8);
+    int i = 0;
+    for (; i + REDUCE_LANES <= count; i += REDUCE_LANES) {
+        for (int k = 0; k < 2; k++) {
+            __m256 level = _mm256_loadu_ps(src + i + 8 * k);
+            sums[k] = _mm256_add_ps(sums[k], level);
+            maxes = _mm256_max_ps(maxes, level);
+            
+            __m256 scaled = _mm256_mul_ps(level, scale);
+            __m256 reached = _mm256_cmp_ps(level, zero, _CMP_NEQ_UQ);
+            for (int bin = 0; bin < PHEROMONE_HISTOGRAM_BINS && _mm256_movemask_ps(reached) != 0; bin++) {
+                __m256i* lanes = (__m256i*)(reduction->at_least[bin] + 8 * k);
+                _mm256_storeu_si256(lanes, _mm256_sub_epi32(_mm256_loadu_si256(lanes), _mm256_castps_si256(reached)));
+                reached = _mm256_cmp_ps(scaled, _mm256_set1_ps((float)(bin + 1)), _CMP_GE_OQ);
+            }
+        }
+    }
+    
+    float max_lanes[8];
+    _mm256_storeu_ps(reduction->sums, sums[0]);
+    _mm256_storeu_ps(reduction->sums + 8, sums[1]);
+    _mm256_storeu_ps(max_lanes, maxes);
+    for (int k = 0; k < 8; k++) {
+        if (max_lanes[k] > reduction->max) reduction->max = max_lanes[k];
+    }
+    reduce_row_scalar(src + i, count - i, reduction);
+}
+
+// AVX-512: 16 cells per step
+KERNEL_TARGET("avx512f")
+static void evaporate_row_avx512(const float* src, float* dst, int count) {
+    const __m512 factor = _mm512_set1_ps(EVAPORATION_FACTOR);
+    const __m512 threshold = _mm512_set1_ps(PHEROMONE_MIN_THRESHOLD);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 level = _mm512_mul_ps(_mm512_loadu_ps(src + i), factor);
+        __mmask16 keep = _mm512_cmp_ps_mask(level, threshold, _CMP_NLT_UQ);
+        _mm512_storeu_ps(dst + i, _mm512_maskz_mov_ps(keep, level));
+    }
+    evaporate_row_scalar(src + i, dst + i, count - i);
+}
+
+KERNEL_TARGET("avx512f")
+static int diffuse_row_avx512(const float* above, const float* mid, const float* below,
+                              float* dst, int count) {
+    const __m512 keep = _mm512_set1_ps(DIFFUSION_KEEP);
+    const __m512 rate = _mm512_set1_ps(PHEROMONE_DIFFUSION_RATE);
+    const __m512 eighth = _mm512_set1_ps(0.125f);
+    const __m512 zero = _mm512_setzero_ps();
+    __mmask16 nonzero = 0;
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m512 sum = _mm512_add_ps(_mm512_loadu_ps(above + x - 1), _mm512_loadu_ps(above + x));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(above + x + 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(mid + x - 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(mid + x + 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(below + x - 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(below + x));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(below + x + 1));
+        __m512 result = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(mid + x), keep),
+                                      _mm512_mul_ps(_mm512_mul_ps(sum, rate), eighth));
+        _mm512_storeu_ps(dst + x, result);
+        nonzero |= _mm512_cmp_ps_mask(result, zero, _CMP_NEQ_UQ);
+    }
+    int active = nonzero != 0;
+    return diffuse_row_scalar(above + x, mid + x, below + x, dst + x, count - x) | active;
+}
+
+KERNEL_TARGET("avx512f")
+static int diffuse_weighted_row_avx512(const float* above, const float* mid, const float* below,
+                                       const float* keep, const float* share, float* dst, int count) {
+    const __m512 zero = _mm512_setzero_ps();
+    __mmask16 nonzero = 0;
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m512 sum = _mm512_add_ps(_mm512_loadu_ps(above + x - 1), _mm512_loadu_ps(above + x));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(above + x + 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(mid + x - 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(mid + x + 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(below + x - 1));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(below + x));
+        sum = _mm512_add_ps(sum, _mm512_loadu_ps(below + x + 1));
+        __m512 result = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(mid + x), _mm512_loadu_ps(keep + x)),
+                                      _mm512_mul_ps(sum, _mm512_loadu_ps(share + x)));
+        _mm512_storeu_ps(dst + x, result);
+        nonzero |= _mm512_cmp_ps_mask(result, zero, _CMP_NEQ_UQ);
+    }
+    int active = nonzero != 0;
+    return diffuse_weighted_row_scalar(above + x, mid + x, below + x, keep + x, share + x,
+                                       dst + x, count - x) | active;
+}
+
+KERNEL_TARGET("avx512f")
+static void unpack_row_avx512(const uint16_t* src, float* dst, int count) {
+    const __m512 unit = _mm512_set1_ps(FIXED_UNIT);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i values = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(src + i)));
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_cvtepi32_ps(values), unit));
+    }
+    unpack_row_scalar(src + i, dst + i, count - i);
+}
+
+// 16 cells take all 16 dither offsets, starting from the row's seed
+KERNEL_TARGET("avx512f")
+static void pack_row_avx512(const float* src, uint16_t* dst, int count, unsigned int seed) {
+    const __m512 offsets = _mm512_loadu_ps(g_dither + (seed & 15));
+    const __m512 scale = _mm512_set1_ps(PHEROMONE_FIXED_SCALE);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 limit = _mm512_set1_ps((float)FIXED_MAX_VALUE);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 value = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(src + i), scale), offsets);
+        value = _mm512_min_ps(_mm512_max_ps(value, zero), limit);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtusepi32_epi16(_mm512_cvttps_epi32(value)));
+    }
+    pack_cells_scalar(src + i, dst + i, count - i, seed, i);
+}
+
+KERNEL_TARGET("avx512f")
+static void reduce_row_avx512(const float* src, int count, PheromoneReduction* reduction) {
+    const __m512 scale = _mm512_set1_ps(HISTOGRAM_SCALE);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512i one = _mm512_set1_epi32(1);
+    __m512 sums = _mm512_loadu_ps(reduction->sums);
+    __m512 maxes = zero;
+    int i = 0;
+    for (; i + REDUCE_LANES <= count; i += REDUCE_LANES) {
+        __m512 level = _mm512_loadu_ps(src + i);
+        sums = _mm512_add_ps(sums, level);
+        maxes = _mm512_max_ps(maxes, level);
+        
+        __m512 scaled = _mm512_mul_ps(level, scale);
+        __mmask16 reached = _mm512_cmp_ps_mask(level, zero, _CMP_NEQ_UQ);
+        for (int bin = 0; bin < PHEROMONE_HISTOGRAM_BINS && reached != 0; bin++) {
+            int* lanes = reduction->at_least[bin];
+            _mm512_storeu_si512(lanes, _mm512_mask_add_epi32(_mm512_loadu_si512(lanes), reached,
+                                                             _mm512_loadu_si512(lanes), one));
+            reached = _mm512_cmp_ps_mask(scaled, _mm512_set1_ps((float)(bin + 1)), _CMP_GE_OQ);
+        }
+    }
+    
+    float max_lanes[16];
+    _mm512_storeu_ps(reduction->sums, sums);
+    _mm512_storeu_ps(max_lanes, maxes);
+    for (int k = 0; k < 16; k++) {
+        if (max_lanes[k] > reduction->max) reduction->max = max_lanes[k];
+    }
+    reduce_row_scalar(src + i, count - i, reduction);
+}
+#endif
+
+static const PheromoneKernels g_kernels[PHEROMONE_KERNEL_COUNT] = {
+    {"scalar", evaporate_row_scalar, diffuse_row_scalar, diffuse_weighted_row_scalar,
+     unpack_row_scalar, pack_row_scalar, reduce_row_scalar},
+#ifdef PHEROMONE_KERNELS_X86
+    {"sse2", evaporate_row_sse2, diffuse_row_sse2, diffuse_weighted_row_sse2,
+     unpack_row_sse2, pack_row_sse2, reduce_row_sse2},
+    {"avx2", evaporate_row_avx2, diffuse_row_avx2, diffuse_weighted_row_avx2,
+     unpack_row_avx2, pack_row_avx2, reduce_row_avx2},
+    {"avx512", evaporate_row_avx512, diffuse_row_avx512, diffuse_weighted_row_avx512,
+     unpack_row_avx512, pack_row_avx512, reduce_row_avx512}
+#endif
+};
+
+static const PheromoneKernels* g_active_kernels = NULL;
+
+// CPU feature detection
+#ifdef PHEROMONE_KERNELS_X86
+static void read_cpuid(int leaf, int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (unsigned int)info[i];
+#else
+    if (!__get_cpuid_count((unsigned int)leaf, (unsigned int)subleaf, &regs[0], &regs[1], &regs[2], &regs[3])) {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    }
+#endif
+}
+
+// Register state the OS saves on context switches (XCR0)
+static unsigned long long read_xcr0(void) {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((unsigned long long)high << 32) | low;
+#endif
+}
+#endif
+
+int pheromone_kernel_supported(PheromoneKernelLevel level) {
+    if (level == PHEROMONE_KERNEL_SCALAR) return 1;
+#ifdef PHEROMONE_KERNELS_X86
+    if (level < 0 || level >= PHEROMONE_KERNEL_COUNT) return 0;
+    
+    unsigned int basic[4], extended[4];
+    read_cpuid(0, 0, basic);
+    unsigned int max_leaf = basic[0];
+    read_cpuid(1, 0, basic);
+    if (level == PHEROMONE_KERNEL_SSE2) return (basic[3] >> 26) & 1;
+    
+    // AVX state must be enabled by the OS (OSXSAVE, then XMM and YMM in XCR0)
+    if (!((basic[2] >> 27) & 1) || max_leaf < 7) return 0;
+    unsigned long long xcr0 = read_xcr0();
+    if ((xcr0 & 0x6) != 0x6) return 0;
+    read_cpuid(7, 0, extended);
+    if (level == PHEROMONE_KERNEL_AVX2) return (extended[1] >> 5) & 1;
+    
+    // AVX-512 also needs the opmask and upper ZMM state
+    if ((xcr0 & 0xE6) != 0xE6) return 0;
+    return (extended[1] >> 16) & 1;
+#else
+    return 0;
+#endif
+}
+
+int select_pheromone_kernels(PheromoneKernelLevel level) {
+    if (!pheromone_kernel_supported(level)) return 0;
+    g_active_kernels = &g_kernels[level];
+    return 1;
+}
+
+const PheromoneKernels* get_pheromone_kernels(void) {
+    if (g_active_kernels == NULL) {
+        int level = PHEROMONE_KERNEL_COUNT - 1;
+        while (!select_pheromone_kernels((PheromoneKernelLevel)level)) {
+            level--;
+        }
+    }
+    return g_active_kernels;
+}
+
+// Kernel self-check
+#define CHECK_ROW_CELLS 67   // Odd, so every vector width leaves a tail
+#define CHECK_ROUNDS 2000
+
+// Row kernels compared, in the order of each round
+enum {
+    CHECK_EVAPORATE,
+    CHECK_DIFFUSE,
+    CHECK_DIFFUSE_WEIGHTED,  // Walkable-only diffusion
+    CHECK_PACK,
+    CHECK_UNPACK,
+    CHECK_REDUCE,
+    CHECK_KERNEL_COUNT
+};
+
+static const char* g_check_kernel_names[CHECK_KERNEL_COUNT] = {
+    "evaporate", "diffuse", "diffuse_weighted", "pack", "unpack", "reduce"
+};
+
+static float random_check_level(void) {
+    // Mostly empty cells, some around the threshold, some large
+    int pick = random_int(0, 9);
+    if (pick < 4) return 0.0f;
+    if (pick < 7) return random_float(0.0f, 2.0f * PHEROMONE_MIN_THRESHOLD);
+    return random_float(0.0f, PHEROMONE_MAX);
+}
+
+int check_pheromone_kernels(void) {
+    const PheromoneKernels* scalar = &g_kernels[PHEROMONE_KERNEL_SCALAR];
+    float rows[3][CHECK_ROW_CELLS + 2];
+    float expected[CHECK_ROW_CELLS], actual[CHECK_ROW_CELLS];
+    float keep[CHECK_ROW_CELLS], share[CHECK_ROW_CELLS];
+    uint16_t packed[CHECK_ROW_CELLS], expected_packed[CHECK_ROW_CELLS], actual_packed[CHECK_ROW_CELLS];
+    PheromoneReduction expected_reduction, actual_reduction;
+    int expected_histogram[PHEROMONE_HISTOGRAM_BINS], actual_histogram[PHEROMONE_HISTOGRAM_BINS];
+    int total_mismatches = 0;
+    
+    for (int level = PHEROMONE_KERNEL_SCALAR + 1; level < PHEROMONE_KERNEL_COUNT; level++) {
+        const PheromoneKernels* kernels = &g_kernels[level];
+        if (!pheromone_kernel_supported((PheromoneKernelLevel)level)) {
+            printf("%-8s not supported by this CPU\n", kernels->name);
+            continue;
+        }
+        
+        int mismatches[CHECK_KERNEL_COUNT] = {0};
+        for (int round = 0; round < CHECK_ROUNDS; round++) {
+            for (int r = 0; r < 3; r++) {
+                for (int i = 0; i < CHECK_ROW_CELLS + 2; i++) {
+                    rows[r][i] = random_check_level();
+                }
+            }
+            int count = random_int(0, CHECK_ROW_CELLS);
+            
+            scalar->evaporate_row(rows[0], expected, count);
+            kernels->evaporate_row(rows[0], actual, count);
+            if (memcmp(expected, actual, count * sizeof(float)) != 0) mismatches[CHECK_EVAPORATE]++;
+            
+            int expected_active = scalar->diffuse_row(rows[0] + 1, rows[1] + 1, rows[2] + 1, expected, count);
+            int actual_active = kernels->diffuse_row(rows[0] + 1, rows[1] + 1, rows[2] + 1, actual, count);
+            if (expected_active != actual_active ||
+                memcmp(expected, actual, count * sizeof(float)) != 0) {
+                mismatches[CHECK_DIFFUSE]++;
+            }
+            
+            // Weights as a walkable-only chunk has them: walls, lone cells
+            // and cells with 1 to 8 walkable neighbours
+            for (int i = 0; i < count; i++) {
+                int neighbors = random_int(-1, 8);
+                keep[i] = (neighbors < 0) ? 0.0f : (neighbors == 0) ? 1.0f : DIFFUSION_KEEP;
+                share[i] = (neighbors > 0) ? PHEROMONE_DIFFUSION_RATE / neighbors : 0.0f;
+            }
+            expected_active = scalar->diffuse_weighted_row(rows[0] + 1, rows[1] + 1, rows[2] + 1,
+                                                           keep, share, expected, count);
+            actual_active = kernels->diffuse_weighted_row(rows[0] + 1, rows[1] + 1, rows[2] + 1,
+                                                          keep, share, actual, count);
+            if (expected_active != actual_active ||
+                memcmp(expected, actual, count * sizeof(float)) != 0) {
+                mismatches[CHECK_DIFFUSE_WEIGHTED]++;
+            }
+            
+            unsigned int seed = (unsigned int)random_int(0, 1 << 20);
+            scalar->pack_row(rows[1], expected_packed, count, seed);
+            kernels->pack_row(rows[1], actual_packed, count, seed);
+            if (memcmp(expected_packed, actual_packed, count * sizeof(uint16_t)) != 0) mismatches[CHECK_PACK]++;
+            
+            for (int i = 0; i < count; i++) {
+                packed[i] = (uint16_t)random_int(0, FIXED_MAX_VALUE);
+            }
+            scalar->unpack_row(packed, expected, count);
+            kernels->unpack_row(packed, actual, count);
+            if (memcmp(expected, actual, count * sizeof(float)) != 0) mismatches[CHECK_UNPACK]++;
+            
+            // Every row of the round into one reduction, as a channel's rows
+            memset(&expected_reduction, 0, sizeof(expected_reduction));
+            memset(&actual_reduction, 0, sizeof(actual_reduction));
+            for (int r = 0; r < 3; r++) {
+                scalar->reduce_row(rows[r], count, &expected_reduction);
+                kernels->reduce_row(rows[r], count, &actual_reduction);
+            }
+            pheromone_reduction_histogram(&expected_reduction, expected_histogram);
+            pheromone_reduction_histogram(&actual_reduction, actual_histogram);
+            if (expected_reduction.max != actual_reduction.max ||
+                pheromone_reduction_sum(&expected_reduction) != pheromone_reduction_sum(&actual_reduction) ||
+                memcmp(expected_histogram, actual_histogram, sizeof(expected_histogram)) != 0) {
+                mismatches[CHECK_REDUCE]++;
+            }
+        }
+        
+        int level_mismatches = 0;
+        for (int k = 0; k < CHECK_KERNEL_COUNT; k++) {
+            level_mismatches += mismatches[k];
+        }
+        printf("%-8s %s (%d rows)", kernels->name,
+               level_mismatches ? "MISMATCH" : "bit-identical to scalar", CHECK_KERNEL_COUNT * CHECK_ROUNDS);
+        for (int k = 0; k < CHECK_KERNEL_COUNT; k++) {
+            if (mismatches[k] > 0) printf(" %s: %d", g_check_kernel_names[k], mismatches[k]);
+        }
+        printf("\n");
+        total_mismatches += level_mismatches;
+    }
+    return total_mismatches;
+}
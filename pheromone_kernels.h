@@ -0,0 +1,73 @@
+#ifndef PHEROMONE_KERNELS_H
+#define PHEROMONE_KERNELS_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Row kernels behind the pheromone update, in scalar, SSE2, AVX2 and
+// AVX-512 variants. The best one the CPU supports is picked on first use.
+// Every variant is bit-identical to the scalar one: each lane adds the 8
+// neighbours in the scalar order and nothing is fused into a multiply-add.
+typedef enum {
+    PHEROMONE_KERNEL_SCALAR = 0,
+    PHEROMONE_KERNEL_SSE2,
+    PHEROMONE_KERNEL_AVX2,
+    PHEROMONE_KERNEL_AVX512,
+    PHEROMONE_KERNEL_COUNT
+} PheromoneKernelLevel;
+
+// Running aggregates of rows of levels, see reduce_row; zeroed to start.
+// Cell i of a row is summed in lane i % PHEROMONE_REDUCE_LANES.
+#define PHEROMONE_REDUCE_LANES 16
+typedef struct PheromoneReduction {
+    float max;
+    float sums[PHEROMONE_REDUCE_LANES];
+    int at_least[PHEROMONE_HISTOGRAM_BINS][PHEROMONE_REDUCE_LANES];  // Cells per lane at or above each bin
+    int counts[PHEROMONE_HISTOGRAM_BINS];  // Cells per bin, for the cells counted one by one
+} PheromoneReduction;
+
+typedef struct PheromoneKernels {
+    const char* name;
+    // dst[i] = src[i] after one step of evaporation; dst may equal src
+    void (*evaporate_row)(const float* src, float* dst, int count);
+    // Diffuses count cells with all 8 neighbours in the world. above, mid
+    // and below point at the cells' column in the rows around them.
+    // Returns whether any result is non-zero.
+    int (*diffuse_row)(const float* above, const float* mid, const float* below,
+                       float* dst, int count);
+    // The same with a weight per cell: dst[i] = mid[i] * keep[i] + the
+    // neighbour sum * share[i]. With keep 1 - rate and share rate / 8 it
+    // matches diffuse_row.
+    int (*diffuse_weighted_row)(const float* above, const float* mid, const float* below,
+                                const float* keep, const float* share, float* dst, int count);
+    // 16-bit fixed-point planes (PHEROMONE_FIXED_POINT): levels of count
+    // stored values, and count levels stored with stochastic rounding. Cell
+    // i is rounded up when its fraction exceeds dither offset (seed + i) % 16
+    // of 16 spread over 0..1, so a new seed per row and tick keeps the
+    // rounding unbiased over time for every cell.
+    void (*unpack_row)(const uint16_t* src, float* dst, int count);
+    void (*pack_row)(const float* src, uint16_t* dst, int count, unsigned int seed);
+    // Adds count levels to a reduction. Every variant sums a lane's cells
+    // in the same order, so the sum does not depend on the vector width
+    // either.
+    void (*reduce_row)(const float* src, int count, PheromoneReduction* reduction);
+} PheromoneKernels;
+
+// Kernel selection
+const PheromoneKernels* get_pheromone_kernels(void);
+int select_pheromone_kernels(PheromoneKernelLevel level);  // 0 if the CPU lacks it
+int pheromone_kernel_supported(PheromoneKernelLevel level);
+
+// One pheromone level after one step of evaporation
+float evaporated_pheromone(float level);
+
+// Total of a reduction, its lanes folded in a fixed order, and its
+// non-empty cells per bin
+float pheromone_reduction_sum(const PheromoneReduction* reduction);
+void pheromone_reduction_histogram(const PheromoneReduction* reduction, int histogram[PHEROMONE_HISTOGRAM_BINS]);
+
+// Runs every supported kernel against the scalar one on random rows and
+// prints the result. Returns the number of mismatching values.
+int check_pheromone_kernels(void);
+
+#endif // PHEROMONE_KERNELS_H
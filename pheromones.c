@@ -1,200 +1,2811 @@
 #include "pheromones.h"
+#include "pheromone_kernels.h"
 #include "config.h"
 #include "utils.h"
 #include "world.h"
+#include "ant_logic.h"
+#include "worker_pool.h"
 #include "visualization.h"  // for is_unicode_enabled()
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+
+// Adds pheromone to one cell of colony's channel, allocating the chunk and
+// channel if needed. Returns the new level, or -1 if the position or type
+// is invalid.
+static float add_pheromone(World* world, int x, int y, int colony, int type, float amount) {
+    if (type != PHEROMONE_TYPE_FOOD && type != PHEROMONE_TYPE_HOME) return -1.0f;
+    
+    PheromoneChannel* channel = touch_pheromone_channel(world, touch_chunk(world, x, y),
+                                                        PHEROMONE_CHANNEL_COLONY(world, colony));
+    if (channel == NULL) return -1.0f;
+    
+    PheromoneValue* plane = (type == PHEROMONE_TYPE_FOOD) ? channel->pheromone_food : channel->pheromone_home;
+    int local = CHUNK_LOCAL(x, y);
+#if PHEROMONE_LAZY_EVAPORATION
+    // Catch both levels up to now, since the cell has one write step
+    float food = lazy_pheromone_level(world, channel, channel->pheromone_food, local);
+    float home = lazy_pheromone_level(world, channel, channel->pheromone_home, local);
+    channel->pheromone_food[local] = food;
+    channel->pheromone_home[local] = home;
+#endif
+    stamp_pheromone(channel, local, world->current_step);
+    
+    // Saturates at PHEROMONE_MAX
+    float level = PHEROMONE_UNPACK(plane[local]) + amount;
+    if (level > PHEROMONE_MAX) {
+        level = PHEROMONE_MAX;
+    }
+    plane[local] = PHEROMONE_PACK(level);
+    channel->pheromone_active = 1;
+    widen_pheromone_box(channel, x & CHUNK_MASK, y & CHUNK_MASK);
+    update_channel_halos(world, channel, x, y);
+    invalidate_pheromone_gradients(world);
+    return PHEROMONE_UNPACK(plane[local]);
+}
+
+// Ticks each pheromone update advances, 1 = every tick
+static int g_block_ticks = 1;
+
+// Ticks of spread each implicit update covers, 0 = explicit updates. Only
+// one of the two modes is on at a time; turning one on turns off the other.
+static int g_implicit_dt = 0;
+
+// Whether the per-tick update diffuses between walkable cells only. Blocked
+// updates do not know walls, so this and blocking exclude each other too.
+static int g_walkable_only = 0;
+
+// Whether ant deposits are buffered and merged after the ant update
+static int g_deferred_deposits = 0;
+
+int set_pheromone_block_ticks(int ticks) {
+#if PHEROMONE_LAZY_EVAPORATION
+    ticks = 1;  // Nothing to block without diffusion
+#endif
+    g_block_ticks = clamp_int(ticks, 1, PHEROMONE_BLOCK_MAX_TICKS);
+    if (g_block_ticks > 1) {
+        g_implicit_dt = 0;
+        g_walkable_only = 0;
+    }
+    return g_block_ticks;
+}
+
+int get_pheromone_block_ticks(void) {
+    return g_block_ticks;
+}
+
+int set_pheromone_implicit_dt(int dt) {
+#if PHEROMONE_LAZY_EVAPORATION
+    dt = 0;  // Nothing to diffuse
+#endif
+    g_implicit_dt = (dt <= 0) ? 0 : clamp_int(dt, 1, PHEROMONE_IMPLICIT_MAX_DT);
+    if (g_implicit_dt > 0) g_block_ticks = 1;
+    return g_implicit_dt;
+}
+
+int get_pheromone_implicit_dt(void) {
+    return g_implicit_dt;
+}
+
+int set_pheromone_walkable_only(int enabled) {
+#if PHEROMONE_LAZY_EVAPORATION
+    enabled = 0;  // Nothing to diffuse
+#endif
+    g_walkable_only = enabled ? 1 : 0;
+    if (g_walkable_only) g_block_ticks = 1;
+    return g_walkable_only;
+}
+
+int get_pheromone_walkable_only(void) {
+    return g_walkable_only;
+}
+
+int set_pheromone_deferred_deposits(int enabled) {
+    g_deferred_deposits = enabled ? 1 : 0;
+    return g_deferred_deposits;
+}
+
+int get_pheromone_deferred_deposits(void) {
+    return g_deferred_deposits;
+}
+
+// Whether the blocked update handles this tick: blocking is on, or ticks
+// from before it was turned off are still owed
+static int is_blocking(const World* world) {
+    return g_block_ticks > 1 || world->pheromone_block_ticks > 0;
+}
+
+// Drops the deposits held back for every channel
+static void clear_block_deposits(World* world) {
+    for (int c = 0; c < world->chunk_count; c++) {
+        const Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            PheromoneDepositList* lists = chunk->channels[k]->deposits;
+            for (int l = 0; l < 2; l++) {
+                lists[l].count = 0;
+                memset(lists[l].step_end, 0, sizeof(lists[l].step_end));
+            }
+        }
+    }
+}
+
+// Holds a deposit back for the blocked update, which applies it at the tick
+// it was made. The channel is allocated now and kept active until then.
+static void buffer_deposit(World* world, int x, int y, int colony, int type, float amount) {
+    Chunk* chunk = touch_chunk(world, x, y);
+    PheromoneChannel* channel = touch_pheromone_channel(world, chunk, PHEROMONE_CHANNEL_COLONY(world, colony));
+    if (channel == NULL) return;
+    
+    int lx = x & CHUNK_MASK;
+    int ly = y & CHUNK_MASK;
+    int border = lx < PHEROMONE_BLOCK_MAX_TICKS || ly < PHEROMONE_BLOCK_MAX_TICKS ||
+                 lx >= chunk->cols - PHEROMONE_BLOCK_MAX_TICKS || ly >= chunk->rows - PHEROMONE_BLOCK_MAX_TICKS;
+    PheromoneDepositList* list = &channel->deposits[border ? 0 : 1];
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 256;
+        PheromoneDeposit* deposits = (PheromoneDeposit*)safe_realloc(list->deposits,
+                                                                      capacity * sizeof(PheromoneDeposit));
+        if (deposits == NULL) return;
+        list->deposits = deposits;
+        list->capacity = capacity;
+    }
+    
+    PheromoneDeposit* deposit = &list->deposits[list->count++];
+    deposit->x = (uint8_t)lx;
+    deposit->y = (uint8_t)ly;
+    deposit->type = (uint8_t)type;
+    deposit->step = (uint8_t)(world->pheromone_block_ticks + 1);
+    deposit->amount = amount;
+    list->step_end[deposit->step] = list->count;
+    channel->pheromone_active = 1;
+    widen_pheromone_box(channel, lx, ly);
+}
 
 // Pheromone deposit and evaporation
 void deposit_pheromone(World* world, Ant* ant) {
     if (world == NULL || ant == NULL) return;
+    if (g_deferred_deposits) {
+        queue_pheromone_deposit(world, ant, 0);
+        return;
+    }
+    
+    if (!is_valid_position(world, ant->pos.x, ant->pos.y)) return;
+    if (g_walkable_only && !is_walkable(world, ant->pos.x, ant->pos.y)) return;
+    
+    if (is_blocking(world) && (ant->state & (ANT_STATE_SEARCHING | ANT_STATE_RETURNING))) {
+        int type = (ant->state & ANT_STATE_SEARCHING) ? PHEROMONE_TYPE_HOME : PHEROMONE_TYPE_FOOD;
+        buffer_deposit(world, ant->pos.x, ant->pos.y, ant->colony_id, type, PHEROMONE_DEPOSIT_AMOUNT);
+        return;
+    }
+    
+    if (ant->state & ANT_STATE_SEARCHING) {
+        // Searching ants deposit home pheromone
+        float level = add_pheromone(world, ant->pos.x, ant->pos.y, ant->colony_id,
+                                    PHEROMONE_TYPE_HOME, PHEROMONE_DEPOSIT_AMOUNT);
+        (void)level;
+        
+        LOG_PHEROMONE_INFO("Ant %d deposited home pheromone at (%d, %d), level: %.1f", 
+                           ant->id, ant->pos.x, ant->pos.y, level);
+                           
+    } else if (ant->state & ANT_STATE_RETURNING) {
+        // Returning ants deposit food pheromone
+        float level = add_pheromone(world, ant->pos.x, ant->pos.y, ant->colony_id,
+                                    PHEROMONE_TYPE_FOOD, PHEROMONE_DEPOSIT_AMOUNT);
+        (void)level;
+        
+        LOG_PHEROMONE_INFO("Ant %d deposited food pheromone at (%d, %d), level: %.1f", 
+                           ant->id, ant->pos.x, ant->pos.y, level);
+    }
+}
+
+void deposit_pheromone_at_position(World* world, int x, int y, int colony, int type, float amount) {
+    if (world == NULL || !is_valid_position(world, x, y)) return;
+    if (g_walkable_only && !is_walkable(world, x, y)) return;
+    
+    add_pheromone(world, x, y, colony, type, amount);
+}
+
+// Deferred deposits (set_pheromone_deferred_deposits). Each band of an ant
+// update appends its ants' deposits to its own buffer, so the bands write
+// neither the planes nor each other's memory. merge_pheromone_deposits
+// then sorts them all by tile, channel, type and cell with a stable radix
+// sort, adds up each cell's amounts in band order and adds the sum to the
+// plane once, clamped once. Band b holds the b-th slice of the ants in
+// their serial order, so the sums do not depend on the band count
+// (--check-deposits). Deposits left queued are dropped with
+// discard_pheromone_deposits when the world is reset, loaded or destroyed.
+#define DEPOSIT_RADIX_BITS 11
+
+typedef struct DepositRecord {
+    uint64_t key;            // Tile, channel, type and cell, see deposit_key
+    float amount;
+} DepositRecord;
+
+typedef struct DepositBuffer {
+    DepositRecord* records;
+    int count;
+    int capacity;
+} DepositBuffer;
+
+static DepositBuffer g_deposit_buffers[MAX_WORKER_THREADS];
+static DepositRecord* g_merge_records = NULL;  // Every band's records, then the sort's other half
+static int g_merge_capacity = 0;
+
+// Channels a tile can have: the shared one or one per colony
+static int deposit_channel_slots(const World* world) {
+    return world->private_trails ? world->colony_count : 1;
+}
+
+// Sort key of a deposit: the tile in directory order, then the channel,
+// the type and the cell within the tile
+static uint64_t deposit_key(const World* world, int x, int y, int colony, int type) {
+    uint64_t tile = (uint64_t)(y >> CHUNK_SHIFT) * world->chunks_x + (uint64_t)(x >> CHUNK_SHIFT);
+    uint64_t channel = tile * deposit_channel_slots(world) + (world->private_trails ? colony : 0);
+    uint64_t cell = (uint64_t)((y & CHUNK_MASK) << CHUNK_SHIFT | (x & CHUNK_MASK));
+    return (channel << 1 | (uint64_t)type) << (2 * CHUNK_SHIFT) | cell;
+}
+
+// Appends a deposit to a band's buffer; each band only ever grows its own
+static void record_deposit(const World* world, int band, int x, int y, int colony, int type, float amount) {
+    DepositBuffer* buffer = &g_deposit_buffers[band];
+    if (buffer->count == buffer->capacity) {
+        int capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+        DepositRecord* records = (DepositRecord*)safe_realloc(buffer->records, capacity * sizeof(DepositRecord));
+        if (records == NULL) return;
+        buffer->records = records;
+        buffer->capacity = capacity;
+    }
+    
+    DepositRecord* record = &buffer->records[buffer->count++];
+    record->key = deposit_key(world, x, y, colony, type);
+    record->amount = amount;
+}
+
+void queue_pheromone_deposit(World* world, const Ant* ant, int band) {
+    if (world == NULL || ant == NULL || band < 0 || band >= MAX_WORKER_THREADS) return;
+    if (!(ant->state & (ANT_STATE_SEARCHING | ANT_STATE_RETURNING))) return;
+    if (!is_valid_position(world, ant->pos.x, ant->pos.y)) return;
+    if (g_walkable_only && !is_walkable(world, ant->pos.x, ant->pos.y)) return;
+    
+    // Searching ants lay home pheromone, returning ones food pheromone
+    int type = (ant->state & ANT_STATE_SEARCHING) ? PHEROMONE_TYPE_HOME : PHEROMONE_TYPE_FOOD;
+    record_deposit(world, band, ant->pos.x, ant->pos.y, ant->colony_id, type, PHEROMONE_DEPOSIT_AMOUNT);
+}
+
+void discard_pheromone_deposits(void) {
+    for (int band = 0; band < MAX_WORKER_THREADS; band++) {
+        g_deposit_buffers[band].count = 0;
+    }
+}
+
+// One cell's summed deposit, held back for the blocked update if ticks
+// are blocked
+static void apply_deposit(World* world, int x, int y, int colony, int type, float amount) {
+    if (is_blocking(world)) {
+        buffer_deposit(world, x, y, colony, type, amount);
+    } else {
+        add_pheromone(world, x, y, colony, type, amount);
+    }
+}
+
+// Stable LSD radix sort of count records on the low bits of their keys.
+// Returns whichever of records and scratch holds the result.
+static DepositRecord* sort_deposits(DepositRecord* records, DepositRecord* scratch, int count, int bits) {
+    int buckets[1 << DEPOSIT_RADIX_BITS];
+    for (int shift = 0; shift < bits; shift += DEPOSIT_RADIX_BITS) {
+        memset(buckets, 0, sizeof(buckets));
+        for (int i = 0; i < count; i++) {
+            buckets[(records[i].key >> shift) & ((1 << DEPOSIT_RADIX_BITS) - 1)]++;
+        }
+        int start = 0;
+        for (int b = 0; b < (1 << DEPOSIT_RADIX_BITS); b++) {
+            int size = buckets[b];
+            buckets[b] = start;
+            start += size;
+        }
+        for (int i = 0; i < count; i++) {
+            scratch[buckets[(records[i].key >> shift) & ((1 << DEPOSIT_RADIX_BITS) - 1)]++] = records[i];
+        }
+        DepositRecord* sorted = scratch;
+        scratch = records;
+        records = sorted;
+    }
+    return records;
+}
+
+void merge_pheromone_deposits(World* world) {
+    if (world == NULL) return;
+    
+    int total = 0;
+    for (int band = 0; band < MAX_WORKER_THREADS; band++) {
+        total += g_deposit_buffers[band].count;
+    }
+    if (total == 0) return;
+    
+    if (g_merge_capacity < total) {
+        DepositRecord* records = (DepositRecord*)safe_realloc(g_merge_records, 2 * (size_t)total * sizeof(DepositRecord));
+        if (records == NULL) {
+            print_error("Out of memory merging pheromone deposits");
+            discard_pheromone_deposits();
+            return;
+        }
+        g_merge_records = records;
+        g_merge_capacity = total;
+    }
+    
+    // Bands in order, so equal keys stay in the ants' serial order
+    int count = 0;
+    uint64_t highest = 0;
+    for (int band = 0; band < MAX_WORKER_THREADS; band++) {
+        DepositBuffer* buffer = &g_deposit_buffers[band];
+        for (int i = 0; i < buffer->count; i++) {
+            if (buffer->records[i].key > highest) highest = buffer->records[i].key;
+        }
+        if (buffer->count > 0) {
+            memcpy(g_merge_records + count, buffer->records, (size_t)buffer->count * sizeof(DepositRecord));
+        }
+        count += buffer->count;
+        buffer->count = 0;
+    }
+    int bits = 0;
+    while (bits < 64 && (highest >> bits) != 0) bits++;
+    const DepositRecord* sorted = sort_deposits(g_merge_records, g_merge_records + total, total, bits);
+    
+    int slots = deposit_channel_slots(world);
+    for (int i = 0; i < total;) {
+        uint64_t key = sorted[i].key;
+        float amount = 0.0f;
+        for (; i < total && sorted[i].key == key; i++) {
+            amount += sorted[i].amount;
+        }
+        
+        int cell = (int)(key & (CHUNK_SIZE * CHUNK_SIZE - 1));
+        int type = (int)((key >> (2 * CHUNK_SHIFT)) & 1);
+        uint64_t channel = key >> (2 * CHUNK_SHIFT + 1);
+        int colony = (int)(channel % slots);
+        int tile = (int)(channel / slots);
+        int x = (tile % world->chunks_x) * CHUNK_SIZE + (cell & CHUNK_MASK);
+        int y = (tile / world->chunks_x) * CHUNK_SIZE + (cell >> CHUNK_SHIFT);
+        apply_deposit(world, x, y, colony, type, amount);
+    }
+}
+
+// Channels one pheromone pass works on, sorted by chunk row so that each
+// worker band covers a horizontal strip of the world. Every channel is
+// written by exactly one band and reads nothing another band writes, so
+// the result does not depend on the thread count.
+typedef struct PheromonePass {
+    World* world;
+    PheromoneChannel** channels;
+    int count;
+    int evaporate;
+    int steps;               // Ticks a blocked update advances
+    long long traffic[MAX_WORKER_THREADS];  // Plane bytes each band moved
+    PheromoneFieldStats (*stats)[2];        // Per channel, for updates that reduce their results; NULL if not
+} PheromonePass;
+
+static PheromoneChannel** g_pass_channels = NULL;
+static int g_pass_capacity = 0;
+static int* g_row_starts = NULL;
+static int g_row_capacity = 0;
+
+// Fills pass with the channels that hold pheromone (or, with stale set,
+// whose halo must be refreshed) in chunk row order. Returns 0 if out of
+// memory.
+static int collect_pass_channels(World* world, int stale, int evaporate, PheromonePass* pass) {
+    if (g_row_capacity < world->chunks_y + 1) {
+        int* starts = (int*)safe_realloc(g_row_starts, (world->chunks_y + 1) * sizeof(int));
+        if (starts == NULL) return 0;
+        g_row_starts = starts;
+        g_row_capacity = world->chunks_y + 1;
+    }
+    
+    // Counting sort on the chunk row
+    int total = 0;
+    memset(g_row_starts, 0, (world->chunks_y + 1) * sizeof(int));
+    for (int c = 0; c < world->chunk_count; c++) {
+        const Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            const PheromoneChannel* channel = chunk->channels[k];
+            if (stale ? channel->halo_stale : channel->pheromone_active) {
+                g_row_starts[chunk->cy + 1]++;
+                total++;
+            }
+        }
+    }
+    if (g_pass_capacity < total) {
+        PheromoneChannel** channels = (PheromoneChannel**)safe_realloc(g_pass_channels,
+                                                                       total * sizeof(PheromoneChannel*));
+        if (channels == NULL) return 0;
+        g_pass_channels = channels;
+        g_pass_capacity = total;
+    }
+    for (int row = 0; row < world->chunks_y; row++) {
+        g_row_starts[row + 1] += g_row_starts[row];
+    }
+    for (int c = 0; c < world->chunk_count; c++) {
+        const Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            PheromoneChannel* channel = chunk->channels[k];
+            if (stale ? channel->halo_stale : channel->pheromone_active) {
+                g_pass_channels[g_row_starts[chunk->cy]++] = channel;
+            }
+        }
+    }
+    
+    pass->world = world;
+    pass->channels = g_pass_channels;
+    pass->count = total;
+    pass->evaporate = evaporate;
+    pass->steps = 1;
+    memset(pass->traffic, 0, sizeof(pass->traffic));
+    pass->stats = NULL;
+    return 1;
+}
+
+// Channels [*first, *last) of the pass belong to band
+static void band_range(const PheromonePass* pass, int band, int band_count, int* first, int* last) {
+    *first = (int)((long long)pass->count * band / band_count);
+    *last = (int)((long long)pass->count * (band + 1) / band_count);
+}
+
+static void run_pass(WorkerTask task, PheromonePass* pass) {
+    run_worker_bands(task, pass, pass->count / PHEROMONE_CHANNELS_PER_BAND);
+}
+
+// Bytes of pheromone plane the update passes have read and written
+static long long g_plane_traffic = 0;
+
+static void count_pass_traffic(const PheromonePass* pass) {
+    for (int band = 0; band < MAX_WORKER_THREADS; band++) {
+        g_plane_traffic += pass->traffic[band];
+    }
+}
+
+long long get_pheromone_traffic(void) {
+    return g_plane_traffic;
+}
+
+// Field statistics (reduce_pheromones). Each channel is reduced on its own,
+// row by row with the kernels, and the channels are added up in pass order,
+// so the totals do not depend on how the channels were split between
+// bands. The per-tick update reduces its result rows while they are still
+// in cache, so publishing them costs no sweep of its own.
+static PheromoneFieldStats (*g_channel_stats)[2] = NULL;
+static int g_channel_stats_capacity = 0;
+
+// Room for the results of a pass of count channels, cleared. Returns 0 if
+// out of memory.
+static int reserve_channel_stats(int count) {
+    if (g_channel_stats_capacity < count) {
+        PheromoneFieldStats (*channel_stats)[2] =
+            (PheromoneFieldStats (*)[2])safe_realloc(g_channel_stats, count * sizeof(*g_channel_stats));
+        if (channel_stats == NULL) return 0;
+        g_channel_stats = channel_stats;
+        g_channel_stats_capacity = count;
+    }
+    memset(g_channel_stats, 0, count * sizeof(*g_channel_stats));
+    return 1;
+}
+
+// Column a row reduction starting at in-world column lx starts at instead.
+// Cells left of lx are empty and add nothing, and every pass puts a cell in
+// the same sum lane, so the update and reduce_pheromones agree to the bit.
+static int reduced_column(int lx) {
+    return lx - lx % PHEROMONE_REDUCE_LANES;
+}
+
+// Adds one channel's reduction of a type to the type's statistics
+static void add_pheromone_reduction(const PheromoneReduction* reduction, PheromoneFieldStats* field) {
+    int histogram[PHEROMONE_HISTOGRAM_BINS];
+    pheromone_reduction_histogram(reduction, histogram);
+    if (reduction->max > field->max) field->max = reduction->max;
+    field->sum += pheromone_reduction_sum(reduction);
+    for (int bin = 0; bin < PHEROMONE_HISTOGRAM_BINS; bin++) {
+        field->histogram[bin] += histogram[bin];
+        field->nonzero_cells += histogram[bin];
+    }
+}
+
+// World statistics from the results of the first count channels of a pass
+static void sum_channel_stats(const World* world, int count, PheromoneStats* stats) {
+    memset(stats, 0, sizeof(PheromoneStats));
+    stats->cells = (long long)world->width * world->height * (world->private_trails ? world->colony_count : 1);
+    stats->generation = world->pheromone_generation;
+    stats->step = world->current_step;
+    
+    for (int i = 0; i < count; i++) {
+        for (int type = PHEROMONE_TYPE_FOOD; type <= PHEROMONE_TYPE_HOME; type++) {
+            const PheromoneFieldStats* part = &g_channel_stats[i][type];
+            PheromoneFieldStats* total = &stats->types[type];
+            if (part->max > total->max) total->max = part->max;
+            total->sum += part->sum;
+            total->nonzero_cells += part->nonzero_cells;
+            for (int bin = 0; bin < PHEROMONE_HISTOGRAM_BINS; bin++) {
+                total->histogram[bin] += part->histogram[bin];
+            }
+        }
+    }
+}
+
+#if PHEROMONE_FIXED_POINT
+// Dither seed for packing world row y of one pheromone type this step.
+// Packing offsets it by the world column, so a cell's rounding does not
+// depend on which chunk or band wrote it.
+static unsigned int dither_seed(const World* world, int y, int type) {
+    unsigned int h = (unsigned int)world->current_step * 0x9E3779B1u;
+    h ^= (unsigned int)(2 * y + type) * 0x85EBCA77u;
+    h ^= h >> 15;
+    h *= 0xC2B2AE3Du;
+    return h ^ (h >> 13);
+}
+#endif
+
+static void evaporate_band(void* context, int band, int band_count) {
+    PheromonePass* pass = (PheromonePass*)context;
+    const PheromoneKernels* kernels = get_pheromone_kernels();
+    int first, last;
+    band_range(pass, band, band_count, &first, &last);
+    
+    // Rows outside the pheromone box are zero and stay zero
+    for (int i = first; i < last; i++) {
+        PheromoneChannel* channel = pass->channels[i];
+        const PheromoneBox* box = &channel->pheromone_box;
+        if (box->y0 > box->y1) continue;
+#if PHEROMONE_FIXED_POINT
+        // In-world cells only, each row through a float buffer; the caller
+        // refreshes the halos
+        const Chunk* chunk = channel->chunk;
+        float row[CHUNK_SIZE];
+        int y0 = (box->y0 > 0) ? box->y0 : 0;
+        int y1 = (box->y1 < chunk->rows - 1) ? box->y1 : chunk->rows - 1;
+        for (int ly = y0; ly <= y1; ly++) {
+            int start = CHUNK_PAD_INDEX(0, ly);
+            int y = chunk->cy * CHUNK_SIZE + ly;
+            unsigned int column = (unsigned int)(chunk->cx * CHUNK_SIZE);
+            kernels->unpack_row(channel->pheromone_food + start, row, chunk->cols);
+            kernels->evaporate_row(row, row, chunk->cols);
+            kernels->pack_row(row, channel->pheromone_food + start, chunk->cols,
+                              dither_seed(pass->world, y, PHEROMONE_TYPE_FOOD) + column);
+            kernels->unpack_row(channel->pheromone_home + start, row, chunk->cols);
+            kernels->evaporate_row(row, row, chunk->cols);
+            kernels->pack_row(row, channel->pheromone_home + start, chunk->cols,
+                              dither_seed(pass->world, y, PHEROMONE_TYPE_HOME) + column);
+        }
+#else
+        int start = CHUNK_PAD_INDEX(-1, box->y0);
+        int count = (box->y1 - box->y0 + 1) * CHUNK_STRIDE;
+        kernels->evaporate_row(channel->pheromone_food + start, channel->pheromone_food + start, count);
+        kernels->evaporate_row(channel->pheromone_home + start, channel->pheromone_home + start, count);
+#endif
+    }
+}
+
+// Colony's channel in the neighbouring chunk (cx, cy), allocating both
+static void touch_neighbor_channel(World* world, int cx, int cy, int colony) {
+    touch_pheromone_channel(world, touch_neighbor_chunk(world, cx, cy), colony);
+}
+
+// Whether cell i will still hold pheromone once evaporated (if evaporate
+// is set)
+static int has_pheromone(const PheromoneChannel* channel, int i, int evaporate) {
+    float food = PHEROMONE_UNPACK(channel->pheromone_food[i]);
+    float home = PHEROMONE_UNPACK(channel->pheromone_home[i]);
+    if (evaporate) {
+        food = evaporated_pheromone(food);
+        home = evaporated_pheromone(home);
+    }
+    return food != 0.0f || home != 0.0f;
+}
+
+// Pheromone that diffuses across a chunk edge needs somewhere to land, so
+// the neighbours of every channel with pheromone on its border get a
+// channel for the same colony (and are allocated if needed) before
+// diffusing
+static void expand_pheromone_chunks(World* world, int evaporate) {
+    // Chunks and channels allocated here hold nothing in-world and need no
+    // expansion themselves
+    int count = world->chunk_count;
+    
+    for (int c = 0; c < count; c++) {
+        Chunk* chunk = world->chunk_list[c];
+        int last_x = chunk->cols - 1;
+        int last_y = chunk->rows - 1;
+        
+        for (int k = 0; k < chunk->channel_count; k++) {
+            const PheromoneChannel* channel = chunk->channels[k];
+            if (!channel->pheromone_active) continue;
+            
+            // Only edges the pheromone box reaches can hold any
+            const PheromoneBox* box = &channel->pheromone_box;
+            if (box->x0 > 0 && box->y0 > 0 && box->x1 < last_x && box->y1 < last_y) continue;
+            
+            // Each side stops at its first cell that still holds pheromone
+            int north = 0, south = 0, west = 0, east = 0;
+            for (int i = 0; i < chunk->cols && !north; i++) {
+                north = has_pheromone(channel, CHUNK_PAD_INDEX(i, 0), evaporate);
+            }
+            for (int i = 0; i < chunk->cols && !south; i++) {
+                south = has_pheromone(channel, CHUNK_PAD_INDEX(i, last_y), evaporate);
+            }
+            for (int i = 0; i < chunk->rows && !west; i++) {
+                west = has_pheromone(channel, CHUNK_PAD_INDEX(0, i), evaporate);
+            }
+            for (int i = 0; i < chunk->rows && !east; i++) {
+                east = has_pheromone(channel, CHUNK_PAD_INDEX(last_x, i), evaporate);
+            }
+            
+            int cx = chunk->cx;
+            int cy = chunk->cy;
+            int colony = channel->colony;
+            if (north) touch_neighbor_channel(world, cx, cy - 1, colony);
+            if (south) touch_neighbor_channel(world, cx, cy + 1, colony);
+            if (west) touch_neighbor_channel(world, cx - 1, cy, colony);
+            if (east) touch_neighbor_channel(world, cx + 1, cy, colony);
+            
+            // Corner cells also reach the diagonal chunks
+            if (has_pheromone(channel, CHUNK_PAD_INDEX(0, 0), evaporate)) {
+                touch_neighbor_channel(world, cx - 1, cy - 1, colony);
+            }
+            if (has_pheromone(channel, CHUNK_PAD_INDEX(last_x, 0), evaporate)) {
+                touch_neighbor_channel(world, cx + 1, cy - 1, colony);
+            }
+            if (has_pheromone(channel, CHUNK_PAD_INDEX(0, last_y), evaporate)) {
+                touch_neighbor_channel(world, cx - 1, cy + 1, colony);
+            }
+            if (has_pheromone(channel, CHUNK_PAD_INDEX(last_x, last_y), evaporate)) {
+                touch_neighbor_channel(world, cx + 1, cy + 1, colony);
+            }
+        }
+    }
+}
+
+// The three source rows around the row being diffused, each pointing at
+// local column 0 so that column -1 and cols (the halo) are in reach
+typedef struct StencilRows {
+    const float* above;
+    const float* mid;
+    const float* below;
+} StencilRows;
+
+// One cell of the diffusion stencil, for cells on a bounded world's edge.
+// The sum runs in the same order as the original bounds-checked loop (row
+// above, sides, row below), as it does in the row kernels. Returns whether
+// the cell still holds pheromone.
+static inline int diffuse_cell(const StencilRows* food, const StencilRows* home,
+                               float* dst_food, float* dst_home, int x, int valid_neighbors) {
+    float neighbor_food_contribution =
+        food->above[x - 1] + food->above[x] + food->above[x + 1] +
+        food->mid[x - 1] + food->mid[x + 1] +
+        food->below[x - 1] + food->below[x] + food->below[x + 1];
+    float neighbor_home_contribution =
+        home->above[x - 1] + home->above[x] + home->above[x + 1] +
+        home->mid[x - 1] + home->mid[x + 1] +
+        home->below[x - 1] + home->below[x] + home->below[x + 1];
+    
+    // Apply proper diffusion: keep most original + small neighbor influence
+    dst_food[x] = food->mid[x] * (1.0f - PHEROMONE_DIFFUSION_RATE) + 
+                  (neighbor_food_contribution * PHEROMONE_DIFFUSION_RATE) / valid_neighbors;
+    dst_home[x] = home->mid[x] * (1.0f - PHEROMONE_DIFFUSION_RATE) + 
+                  (neighbor_home_contribution * PHEROMONE_DIFFUSION_RATE) / valid_neighbors;
+    return (dst_food[x] != 0.0f) | (dst_home[x] != 0.0f);
+}
+
+// Neighbours inside a bounded world: fewer than 8 along its edges
+static int count_valid_neighbors(const World* world, int x, int y) {
+    if (world->toroidal) return 8;
+    int columns = 1 + (x > 0) + (x < world->width - 1);
+    int rows = 1 + (y > 0) + (y < world->height - 1);
+    return columns * rows - 1;
+}
+
+// Diffuses columns x0..x1 of one row from its stencil rows into dst_food
+// and dst_home. Column lx is world column origin_x + lx of world row y.
+// Cells touching a bounded world's edge have fewer neighbours and take the
+// slow path; the rest of the row is branch free. Returns whether any result
+// is non-zero.
+static int diffuse_span(const World* world, const PheromoneKernels* kernels,
+                        const StencilRows* food, const StencilRows* home,
+                        float* dst_food, float* dst_home, int x0, int x1, int origin_x, int y) {
+    int active = 0;
+    if (!world->toroidal && (y == 0 || y == world->height - 1)) {
+        for (int lx = x0; lx <= x1; lx++) {
+            int valid_neighbors = count_valid_neighbors(world, origin_x + lx, y);
+            if (valid_neighbors > 0) {
+                active |= diffuse_cell(food, home, dst_food, dst_home, lx, valid_neighbors);
+            } else {
+                // No neighbors: the cell keeps its value
+                dst_food[lx] = food->mid[lx];
+                dst_home[lx] = home->mid[lx];
+                active |= (dst_food[lx] != 0.0f) | (dst_home[lx] != 0.0f);
+            }
+        }
+        return active;
+    }
+    
+    int kernel_first = x0;
+    int kernel_last = x1 + 1;
+    if (!world->toroidal) {
+        if (origin_x + kernel_first < 1) kernel_first = 1 - origin_x;
+        if (origin_x + kernel_last > world->width - 1) kernel_last = world->width - 1 - origin_x;
+        if (kernel_first > x1 + 1) kernel_first = x1 + 1;
+        if (kernel_last < kernel_first) kernel_last = kernel_first;
+    }
+    
+    for (int lx = x0; lx < kernel_first; lx++) {
+        active |= diffuse_cell(food, home, dst_food, dst_home, lx,
+                               count_valid_neighbors(world, origin_x + lx, y));
+    }
+    if (kernel_last > kernel_first) {
+        active |= kernels->diffuse_row(food->above + kernel_first, food->mid + kernel_first,
+                                       food->below + kernel_first, dst_food + kernel_first,
+                                       kernel_last - kernel_first);
+        active |= kernels->diffuse_row(home->above + kernel_first, home->mid + kernel_first,
+                                       home->below + kernel_first, dst_home + kernel_first,
+                                       kernel_last - kernel_first);
+    }
+    for (int lx = kernel_last; lx <= x1; lx++) {
+        active |= diffuse_cell(food, home, dst_food, dst_home, lx,
+                               count_valid_neighbors(world, origin_x + lx, y));
+    }
+    return active;
+}
+
+// Padded row ly of a front plane as a stencil source, for columns x0 - 1
+// onwards. When evaporating, width cells from there are evaporated into
+// window on the way, so each source value is read from the plane once.
+// Fixed-point planes are always unpacked into window.
+static const float* load_source_row(const PheromoneKernels* kernels, const PheromoneValue* plane, int ly,
+                                    int x0, int width, int evaporate, float* window) {
+    const PheromoneValue* row = plane + CHUNK_PAD_INDEX(-1, ly);
+#if PHEROMONE_FIXED_POINT
+    kernels->unpack_row(row + x0, window + x0, width);
+    if (evaporate) kernels->evaporate_row(window + x0, window + x0, width);
+#else
+    if (!evaporate) return row + 1;
+    kernels->evaporate_row(row + x0, window + x0, width);
+#endif
+    return window + 1;
+}
+
+// Zeroes the in-world cells of the back planes that their box says may hold
+// pheromone and that the update will not overwrite (outside x0..x1, y0..y1)
+static void clear_back_planes(PheromoneChannel* channel, int x0, int y0, int x1, int y1) {
+    const Chunk* chunk = channel->chunk;
+    const PheromoneBox* box = &channel->back_box;
+    int bx0 = (box->x0 > 0) ? box->x0 : 0;
+    int bx1 = (box->x1 < chunk->cols - 1) ? box->x1 : chunk->cols - 1;
+    int by0 = (box->y0 > 0) ? box->y0 : 0;
+    int by1 = (box->y1 < chunk->rows - 1) ? box->y1 : chunk->rows - 1;
+    
+    for (int ly = by0; ly <= by1 && bx0 <= bx1; ly++) {
+        PheromoneValue* food = channel->back_food + CHUNK_PAD_INDEX(0, ly);
+        PheromoneValue* home = channel->back_home + CHUNK_PAD_INDEX(0, ly);
+        if (ly < y0 || ly > y1) {
+            memset(food + bx0, 0, (bx1 - bx0 + 1) * sizeof(PheromoneValue));
+            memset(home + bx0, 0, (bx1 - bx0 + 1) * sizeof(PheromoneValue));
+            continue;
+        }
+        for (int lx = bx0; lx < x0 && lx <= bx1; lx++) {
+            food[lx] = home[lx] = 0;
+        }
+        for (int lx = (x1 + 1 > bx0) ? x1 + 1 : bx0; lx <= bx1; lx++) {
+            food[lx] = home[lx] = 0;
+        }
+    }
+}
+
+// Whether column lx of the back planes is zero in rows y0..y1
+static int back_column_is_zero(const PheromoneChannel* channel, int lx, int y0, int y1) {
+    for (int ly = y0; ly <= y1; ly++) {
+        int i = CHUNK_PAD_INDEX(lx, ly);
+        if (channel->back_food[i] != 0 || channel->back_home[i] != 0) return 0;
+    }
+    return 1;
+}
+
+// Sets the box of the freshly written back planes. The rows of result are
+// exact; its columns start at the written span x0..x1 and drop empty
+// columns from either side.
+static void set_back_box(PheromoneChannel* channel, PheromoneBox result, int x0, int x1) {
+    if (result.y0 <= result.y1) {
+        int left = x0, right = x1;
+        while (left < right && back_column_is_zero(channel, left, result.y0, result.y1)) left++;
+        while (right > left && back_column_is_zero(channel, right, result.y0, result.y1)) right--;
+        result.x0 = (int16_t)left;
+        result.x1 = (int16_t)right;
+    }
+    channel->back_box = result;
+}
+
+// Makes the back planes the front, boxes included
+static void swap_pheromone_planes(PheromoneChannel* channel) {
+    PheromoneValue* swap = channel->pheromone_food;
+    channel->pheromone_food = channel->back_food;
+    channel->back_food = swap;
+    swap = channel->pheromone_home;
+    channel->pheromone_home = channel->back_home;
+    channel->back_home = swap;
+    
+    PheromoneBox box = channel->pheromone_box;
+    channel->pheromone_box = channel->back_box;
+    channel->back_box = box;
+}
+
+// Adds columns x0..x1 of result row ly to the reductions, from the row's
+// first reduced column on (see reduced_column). Fixed-point rows are read
+// back as packed, so the statistics see the rounded levels.
+static void reduce_result_row(const PheromoneKernels* kernels, const PheromoneChannel* channel, int ly,
+                              int x0, int x1, float* dst_food, float* dst_home, PheromoneReduction reductions[2]) {
+    int start = reduced_column(x0);
+#if PHEROMONE_FIXED_POINT
+    kernels->unpack_row(channel->back_food + CHUNK_PAD_INDEX(start, ly), dst_food + start, x1 - start + 1);
+    kernels->unpack_row(channel->back_home + CHUNK_PAD_INDEX(start, ly), dst_home + start, x1 - start + 1);
+#else
+    (void)channel; (void)ly;  // The float results are already in dst
+#endif
+    kernels->reduce_row(dst_food + start, x1 - start + 1, &reductions[PHEROMONE_TYPE_FOOD]);
+    kernels->reduce_row(dst_home + start, x1 - start + 1, &reductions[PHEROMONE_TYPE_HOME]);
+}
+
+// Diffuses the in-world cells of one channel from its front planes into its
+// back planes, evaporating the source first if asked, then swaps the two.
+// Only cells within one step of the pheromone box can become non-zero, so
+// the rest is skipped and the box of the result is tracked for next tick.
+// The halo of the new front is left for the caller to refresh. Adds the
+// plane bytes read and written to *traffic, and with stats set each result
+// row to the statistics of its type. Returns whether any cell still holds
+// pheromone.
+static int update_channel(const World* world, PheromoneChannel* channel, int evaporate, long long* traffic,
+                          PheromoneFieldStats* stats) {
+    // Evaporated source rows, three per channel, reused round-robin
+    float window[2][3][CHUNK_STRIDE];
+    const PheromoneKernels* kernels = get_pheromone_kernels();
+    const Chunk* chunk = channel->chunk;
+    const PheromoneValue* src_food = channel->pheromone_food;
+    const PheromoneValue* src_home = channel->pheromone_home;
+#if PHEROMONE_FIXED_POINT
+    float results[2][CHUNK_SIZE];  // Row results before packing
+#endif
+    const PheromoneBox box = channel->pheromone_box;
+    int origin_x = chunk->cx * CHUNK_SIZE;
+    int origin_y = chunk->cy * CHUNK_SIZE;
+    
+    // In-world cells the box reaches
+    int x0 = (box.x0 > 1) ? box.x0 - 1 : 0;
+    int x1 = (box.x1 < chunk->cols - 2) ? box.x1 + 1 : chunk->cols - 1;
+    int y0 = (box.y0 > 1) ? box.y0 - 1 : 0;
+    int y1 = (box.y1 < chunk->rows - 2) ? box.y1 + 1 : chunk->rows - 1;
+    int width = x1 - x0 + 3;
+    
+    PheromoneReduction reductions[2];
+    if (stats != NULL) memset(reductions, 0, sizeof(reductions));
+    clear_back_planes(channel, x0, y0, x1, y1);
+    PheromoneBox result;
+    clear_pheromone_box(&result);
+    
+    StencilRows food, home;
+    if (x0 <= x1 && y0 <= y1) {
+        *traffic += (long long)2 * sizeof(PheromoneValue) *
+                    ((y1 - y0 + 3) * width + (y1 - y0 + 1) * (x1 - x0 + 1));
+        food.mid = load_source_row(kernels, src_food, y0 - 1, x0, width, evaporate, window[0][y0 % 3]);
+        home.mid = load_source_row(kernels, src_home, y0 - 1, x0, width, evaporate, window[1][y0 % 3]);
+        food.below = load_source_row(kernels, src_food, y0, x0, width, evaporate, window[0][(y0 + 1) % 3]);
+        home.below = load_source_row(kernels, src_home, y0, x0, width, evaporate, window[1][(y0 + 1) % 3]);
+    }
+    
+    for (int ly = y0; ly <= y1 && x0 <= x1; ly++) {
+        int y = origin_y + ly;
+#if PHEROMONE_FIXED_POINT
+        float* dst_food = results[0];
+        float* dst_home = results[1];
+#else
+        float* dst_food = channel->back_food + CHUNK_PAD_INDEX(0, ly);
+        float* dst_home = channel->back_home + CHUNK_PAD_INDEX(0, ly);
+#endif
+        
+        // Row r of the padded plane sits in window slot (r + 1) % 3
+        food.above = food.mid;
+        home.above = home.mid;
+        food.mid = food.below;
+        home.mid = home.below;
+        food.below = load_source_row(kernels, src_food, ly + 1, x0, width, evaporate, window[0][(ly + 2) % 3]);
+        home.below = load_source_row(kernels, src_home, ly + 1, x0, width, evaporate, window[1][(ly + 2) % 3]);
+        int active = diffuse_span(world, kernels, &food, &home, dst_food, dst_home, x0, x1, origin_x, y);
+        
+#if PHEROMONE_FIXED_POINT
+        unsigned int column = (unsigned int)(origin_x + x0);
+        kernels->pack_row(dst_food + x0, channel->back_food + CHUNK_PAD_INDEX(x0, ly), x1 - x0 + 1,
+                          dither_seed(world, y, PHEROMONE_TYPE_FOOD) + column);
+        kernels->pack_row(dst_home + x0, channel->back_home + CHUNK_PAD_INDEX(x0, ly), x1 - x0 + 1,
+                          dither_seed(world, y, PHEROMONE_TYPE_HOME) + column);
+#endif
+        if (stats != NULL) {
+            reduce_result_row(kernels, channel, ly, x0, x1, dst_food, dst_home, reductions);
+        }
+        
+        if (active) {
+            if (result.y0 > ly) result.y0 = (int16_t)ly;
+            result.y1 = (int16_t)ly;
+        }
+    }
+    
+    if (stats != NULL) {
+        add_pheromone_reduction(&reductions[PHEROMONE_TYPE_FOOD], &stats[PHEROMONE_TYPE_FOOD]);
+        add_pheromone_reduction(&reductions[PHEROMONE_TYPE_HOME], &stats[PHEROMONE_TYPE_HOME]);
+    }
+    set_back_box(channel, result, x0, x1);
+    swap_pheromone_planes(channel);
+    return result.y0 <= result.y1;
+}
+
+// Walkable-only diffusion (set_pheromone_walkable_only). A cell keeps
+// 1 - rate of its level and takes rate / n of each of its n walkable
+// neighbours' levels; walls hold no pheromone and pass none. As walls are
+// kept at zero, the sum over all 8 neighbours is the sum over the walkable
+// ones, so each chunk only needs a weight for a cell's own level and one
+// for that sum, built once from the walk masks instead of counting
+// neighbours every tick. Rows are run through kernels->diffuse_weighted_row
+// along their runs of walkable cells; walls between runs are written as
+// zero without being computed. Open cells (n = 8) match the default update.
+#define WALKABLE_RUN_GAP 8  // Shorter wall gaps are computed as part of a run
+
+// Zeroes the pheromone on a chunk's walls, halo included, in every
+// channel. Deposits skip walls while the walkable-only update is on, so
+// this only runs when walls appear or the update is switched on.
+static void clear_wall_pheromone(Chunk* chunk) {
+    for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+        if (TERRAIN_IS_WALKABLE(CELL_TERRAIN(chunk->cell_bits[i]))) continue;
+        for (int k = 0; k < chunk->channel_count; k++) {
+            chunk->channels[k]->pheromone_food[i] = 0;
+            chunk->channels[k]->pheromone_home[i] = 0;
+        }
+    }
+}
+
+// Next run of a row from column lx on: its walkable cells, with wall gaps
+// shorter than WALKABLE_RUN_GAP between them or before the row's ends.
+// Walls have zero weights and level, so they come out as zero and a run
+// needs no scalar tail for a wall cell or two. Returns 0 once there is no
+// walkable cell left, else sets the run's columns [*first, *last).
+static int next_walkable_run(const Chunk* chunk, int ly, int lx, int* first, int* last) {
+    int row = CHUNK_PAD_INDEX(0, ly);
+    int start = lx;
+    while (lx < chunk->cols && !TERRAIN_IS_WALKABLE(CELL_TERRAIN(chunk->cell_bits[row + lx]))) lx++;
+    if (lx >= chunk->cols) return 0;
+    
+    *first = (lx - start < WALKABLE_RUN_GAP) ? start : lx;
+    int end = lx;  // Past the last walkable cell so far
+    for (; lx < chunk->cols && lx - end < WALKABLE_RUN_GAP; lx++) {
+        if (TERRAIN_IS_WALKABLE(CELL_TERRAIN(chunk->cell_bits[row + lx]))) end = lx + 1;
+    }
+    *last = (chunk->cols - end < WALKABLE_RUN_GAP) ? chunk->cols : end;
+    return 1;
+}
+
+// Brings a chunk's walkable cells up to date with its walk masks. Returns 0
+// if out of memory, leaving the old ones.
+static int update_walkable_cells(Chunk* chunk) {
+    if (chunk->walkable != NULL && chunk->walkable->walk_version == chunk->walk_version) return 1;
+    
+    int runs = 0;
+    int first, last;
+    for (int ly = 0; ly < chunk->rows; ly++) {
+        for (int lx = 0; next_walkable_run(chunk, ly, lx, &first, &last); lx = last) runs++;
+    }
+    
+    // Header, the two weight planes, then the runs
+    size_t size = sizeof(WalkableCells) + 2 * CHUNK_PADDED_CELLS * sizeof(float) +
+                  (size_t)runs * 2 * sizeof(uint16_t);
+    WalkableCells* walkable = (WalkableCells*)safe_realloc(chunk->walkable, size);
+    if (walkable == NULL) return 0;
+    walkable->keep = (float*)(walkable + 1);
+    walkable->share = walkable->keep + CHUNK_PADDED_CELLS;
+    walkable->runs = (uint16_t*)(walkable->share + CHUNK_PADDED_CELLS);
+    
+    memset(walkable->keep, 0, 2 * CHUNK_PADDED_CELLS * sizeof(float));
+    int run = 0;
+    for (int ly = 0; ly < chunk->rows; ly++) {
+        walkable->run_start[ly] = (uint16_t)run;
+        for (int lx = 0; next_walkable_run(chunk, ly, lx, &first, &last); lx = last) {
+            walkable->runs[2 * run] = (uint16_t)first;
+            walkable->runs[2 * run + 1] = (uint16_t)last;
+            run++;
+        }
+        for (int i = CHUNK_PAD_INDEX(0, ly); i < CHUNK_PAD_INDEX(chunk->cols, ly); i++) {
+            if (!TERRAIN_IS_WALKABLE(CELL_TERRAIN(chunk->cell_bits[i]))) continue;
+            int neighbors = 0;
+            for (uint8_t mask = chunk->walk_mask[i]; mask != 0; mask &= (uint8_t)(mask - 1)) neighbors++;
+            walkable->keep[i] = (neighbors > 0) ? 1.0f - PHEROMONE_DIFFUSION_RATE : 1.0f;
+            walkable->share[i] = (neighbors > 0) ? PHEROMONE_DIFFUSION_RATE / neighbors : 0.0f;
+        }
+    }
+    for (int ly = chunk->rows; ly <= CHUNK_SIZE; ly++) {
+        walkable->run_start[ly] = (uint16_t)run;
+    }
+    walkable->walk_version = chunk->walk_version;
+    chunk->walkable = walkable;
+    clear_wall_pheromone(chunk);
+    return 1;
+}
+
+// Walkable cells for every chunk of the pass. Returns 0 if out of memory.
+static int prepare_walkable_update(const PheromonePass* pass) {
+    for (int i = 0; i < pass->count; i++) {
+        if (!update_walkable_cells(pass->channels[i]->chunk)) return 0;
+    }
+    return 1;
+}
+
+// update_channel for the walkable-only diffusion. The source rows come
+// through the same window; only the runs of walkable cells in reach are
+// computed, the walls between them written as zero.
+static int update_walkable_channel(const World* world, PheromoneChannel* channel, int evaporate,
+                                   long long* traffic, PheromoneFieldStats* stats) {
+    float window[2][3][CHUNK_STRIDE];
+    const PheromoneKernels* kernels = get_pheromone_kernels();
+    const Chunk* chunk = channel->chunk;
+    const WalkableCells* walkable = chunk->walkable;
+    const PheromoneValue* src_food = channel->pheromone_food;
+    const PheromoneValue* src_home = channel->pheromone_home;
+#if PHEROMONE_FIXED_POINT
+    float results[2][CHUNK_SIZE];  // Row results before packing
+#else
+    (void)world;  // Only the dither seeds need it
+#endif
+    const PheromoneBox box = channel->pheromone_box;
+    
+    // In-world cells the box reaches
+    int x0 = (box.x0 > 1) ? box.x0 - 1 : 0;
+    int x1 = (box.x1 < chunk->cols - 2) ? box.x1 + 1 : chunk->cols - 1;
+    int y0 = (box.y0 > 1) ? box.y0 - 1 : 0;
+    int y1 = (box.y1 < chunk->rows - 2) ? box.y1 + 1 : chunk->rows - 1;
+    int width = x1 - x0 + 3;
+    
+    PheromoneReduction reductions[2];
+    if (stats != NULL) memset(reductions, 0, sizeof(reductions));
+    clear_back_planes(channel, x0, y0, x1, y1);
+    PheromoneBox result;
+    clear_pheromone_box(&result);
+    
+    StencilRows food, home;
+    if (x0 <= x1 && y0 <= y1) {
+        *traffic += (long long)2 * sizeof(PheromoneValue) *
+                    ((y1 - y0 + 3) * width + (y1 - y0 + 1) * (x1 - x0 + 1)) +
+                    (long long)2 * sizeof(float) * (y1 - y0 + 1) * (x1 - x0 + 1);  // Weights
+        food.mid = load_source_row(kernels, src_food, y0 - 1, x0, width, evaporate, window[0][y0 % 3]);
+        home.mid = load_source_row(kernels, src_home, y0 - 1, x0, width, evaporate, window[1][y0 % 3]);
+        food.below = load_source_row(kernels, src_food, y0, x0, width, evaporate, window[0][(y0 + 1) % 3]);
+        home.below = load_source_row(kernels, src_home, y0, x0, width, evaporate, window[1][(y0 + 1) % 3]);
+    }
+    
+    for (int ly = y0; ly <= y1 && x0 <= x1; ly++) {
+        int row = CHUNK_PAD_INDEX(0, ly);
+#if PHEROMONE_FIXED_POINT
+        float* dst_food = results[0];
+        float* dst_home = results[1];
+#else
+        float* dst_food = channel->back_food + row;
+        float* dst_home = channel->back_home + row;
+#endif
+        
+        food.above = food.mid;
+        home.above = home.mid;
+        food.mid = food.below;
+        home.mid = home.below;
+        food.below = load_source_row(kernels, src_food, ly + 1, x0, width, evaporate, window[0][(ly + 2) % 3]);
+        home.below = load_source_row(kernels, src_home, ly + 1, x0, width, evaporate, window[1][(ly + 2) % 3]);
+        
+        int active = 0;
+        int next = x0;  // First column not written yet
+        for (int k = walkable->run_start[ly]; k < walkable->run_start[ly + 1]; k++) {
+            int first = (walkable->runs[2 * k] > x0) ? walkable->runs[2 * k] : x0;
+            int last = (walkable->runs[2 * k + 1] <= x1) ? walkable->runs[2 * k + 1] : x1 + 1;
+            if (first >= last) continue;
+            if (first > next) {
+                memset(dst_food + next, 0, (first - next) * sizeof(float));
+                memset(dst_home + next, 0, (first - next) * sizeof(float));
+            }
+            const float* keep = walkable->keep + row + first;
+            const float* share = walkable->share + row + first;
+            active |= kernels->diffuse_weighted_row(food.above + first, food.mid + first, food.below + first,
+                                                    keep, share, dst_food + first, last - first);
+            active |= kernels->diffuse_weighted_row(home.above + first, home.mid + first, home.below + first,
+                                                    keep, share, dst_home + first, last - first);
+            next = last;
+        }
+        if (next <= x1) {
+            memset(dst_food + next, 0, (x1 + 1 - next) * sizeof(float));
+            memset(dst_home + next, 0, (x1 + 1 - next) * sizeof(float));
+        }
+        
+#if PHEROMONE_FIXED_POINT
+        int y = chunk->cy * CHUNK_SIZE + ly;
+        unsigned int column = (unsigned int)(chunk->cx * CHUNK_SIZE + x0);
+        kernels->pack_row(dst_food + x0, channel->back_food + row + x0, x1 - x0 + 1,
+                          dither_seed(world, y, PHEROMONE_TYPE_FOOD) + column);
+        kernels->pack_row(dst_home + x0, channel->back_home + row + x0, x1 - x0 + 1,
+                          dither_seed(world, y, PHEROMONE_TYPE_HOME) + column);
+#endif
+        if (stats != NULL) {
+            reduce_result_row(kernels, channel, ly, x0, x1, dst_food, dst_home, reductions);
+        }
+        if (active) {
+            if (result.y0 > ly) result.y0 = (int16_t)ly;
+            result.y1 = (int16_t)ly;
+        }
+    }
+    
+    if (stats != NULL) {
+        add_pheromone_reduction(&reductions[PHEROMONE_TYPE_FOOD], &stats[PHEROMONE_TYPE_FOOD]);
+        add_pheromone_reduction(&reductions[PHEROMONE_TYPE_HOME], &stats[PHEROMONE_TYPE_HOME]);
+    }
+    set_back_box(channel, result, x0, x1);
+    swap_pheromone_planes(channel);
+    return result.y0 <= result.y1;
+}
+
+static void update_band(void* context, int band, int band_count) {
+    PheromonePass* pass = (PheromonePass*)context;
+    int first, last;
+    band_range(pass, band, band_count, &first, &last);
+    
+    for (int i = first; i < last; i++) {
+        PheromoneChannel* channel = pass->channels[i];
+        PheromoneFieldStats* stats = (pass->stats != NULL) ? pass->stats[i] : NULL;
+        if (g_walkable_only) {
+            channel->pheromone_active = update_walkable_channel(pass->world, channel, pass->evaporate,
+                                                                &pass->traffic[band], stats);
+        } else {
+            channel->pheromone_active = update_channel(pass->world, channel, pass->evaporate,
+                                                       &pass->traffic[band], stats);
+        }
+    }
+}
+
+static void refresh_band(void* context, int band, int band_count) {
+    PheromonePass* pass = (PheromonePass*)context;
+    int first, last;
+    band_range(pass, band, band_count, &first, &last);
+    
+    for (int i = first; i < last; i++) {
+        PheromoneChannel* channel = pass->channels[i];
+        channel->halo_stale = 0;
+        if (refresh_channel_halo(pass->world, channel)) {
+            channel->pheromone_active = 1;
+        }
+    }
+}
+
+// The same colony's channels around every channel in the pass mirror its
+// edges in their halos, so they are marked for a refresh. With extend set,
+// neighbours without such a channel get one (its halo filled as it is
+// allocated) wherever the channel's pheromone now reaches them.
+static void mark_stale_halos(World* world, const PheromonePass* pass, int extend) {
+    for (int i = 0; i < pass->count; i++) {
+        const PheromoneChannel* channel = pass->channels[i];
+        for (int ny = -1; ny <= 1; ny++) {
+            for (int nx = -1; nx <= 1; nx++) {
+                Chunk* near = get_neighbor_chunk(world, channel->chunk->cx + nx, channel->chunk->cy + ny);
+                if (near == NULL) continue;
+                
+                PheromoneChannel* mirror = (near == channel->chunk) ? pass->channels[i]
+                                                                    : get_pheromone_channel(near, channel->colony);
+                if (mirror != NULL) {
+                    mirror->halo_stale = 1;
+                } else if (extend && channel->pheromone_active && channel_reaches_neighbor(channel, nx, ny)) {
+                    touch_pheromone_channel(world, near, channel->colony);
+                }
+            }
+        }
+    }
+}
+
+// Diffuses every channel holding pheromone, evaporating first if asked.
+// Each channel reads only its own front planes, halo included, so every
+// cell diffuses from the same generation whatever order the channels go
+// in. The channel updates and then the halo refreshes are split over the
+// worker threads in row bands; channels of different colonies never mix.
+static void update_pheromone_planes(World* world, int evaporate) {
+    invalidate_pheromone_gradients(world);
+    expand_pheromone_chunks(world, evaporate);
+    get_pheromone_kernels();  // Picked here, before any worker asks
+    
+    // Channels without pheromone (halo included) stay zero and are skipped
+    PheromonePass pass;
+    if (!collect_pass_channels(world, 0, evaporate, &pass)) return;
+    
+    // Back planes first, so running out of memory leaves every channel as
+    // it was
+    for (int i = 0; i < pass.count; i++) {
+        if (!reserve_pheromone_buffers(pass.channels[i])) {
+            print_error("Out of memory for pheromone buffers");
+            return;
+        }
+    }
+    if (g_walkable_only && !prepare_walkable_update(&pass)) {
+        print_error("Out of memory for the walkable-only pheromone update");
+        return;
+    }
+    
+    // The result rows are reduced on the way; without room for that the
+    // statistics are left to update_pheromone_stats
+    if (reserve_channel_stats(pass.count)) pass.stats = g_channel_stats;
+    run_pass(update_band, &pass);
+    count_pass_traffic(&pass);
+    if (pass.stats != NULL) sum_channel_stats(world, pass.count, &world->pheromone_stats);
+    
+    // Pheromone that reached a chunk edge may need a channel on the other
+    // side; allocating is kept off the workers
+    mark_stale_halos(world, &pass, 1);
+    
+    // Halos are rebuilt from the new values; channels that were not updated
+    // and border no updated channel were all zero and stay that way
+    if (!collect_pass_channels(world, 1, evaporate, &pass)) return;
+    run_pass(refresh_band, &pass);
+}
+
+// Cells of a tile (or chunk), bounds inclusive; empty while x0 > x1
+typedef struct TileRect {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} TileRect;
+
+// A run of a span's cells along one axis that lies in one chunk column (or
+// row), or past the edge of a bounded world
+typedef struct SpanRun {
+    int start;               // First cell, counted from the span's origin
+    int length;
+    int chunk;               // Chunk coordinate, -1 past the edge
+    int local;               // Local coordinate of the first cell
+} SpanRun;
+
+// Splits world cells origin..origin + length - 1 of one axis into runs by
+// chunk, wrapping in a toroidal world. Returns the run count (at most
+// length).
+static int split_span(int origin, int length, int world_size, int toroidal, SpanRun* runs) {
+    int count = 0;
+    int t = 0;
+    while (t < length) {
+        int w = origin + t;
+        if (toroidal) w = ((w % world_size) + world_size) % world_size;
+        
+        SpanRun* run = &runs[count++];
+        run->start = t;
+        if (w < 0 || w >= world_size) {
+            run->chunk = -1;
+            run->local = 0;
+            run->length = (w < 0) ? -w : length - t;
+        } else {
+            run->chunk = CHUNK_COORD(w);
+            run->local = w & CHUNK_MASK;
+            run->length = CHUNK_SIZE - run->local;
+            if (run->length > world_size - w) run->length = world_size - w;
+        }
+        if (run->length > length - t) run->length = length - t;
+        t += run->length;
+    }
+    return count;
+}
+
+// In-world cells of a channel's pheromone box, in local coordinates.
+// Returns 0 if there are none.
+static int box_cells(const PheromoneChannel* channel, TileRect* cells) {
+    const PheromoneBox* box = &channel->pheromone_box;
+    cells->x0 = (box->x0 > 0) ? box->x0 : 0;
+    cells->y0 = (box->y0 > 0) ? box->y0 : 0;
+    cells->x1 = (box->x1 < channel->chunk->cols - 1) ? box->x1 : channel->chunk->cols - 1;
+    cells->y1 = (box->y1 < channel->chunk->rows - 1) ? box->y1 : channel->chunk->rows - 1;
+    return cells->x0 <= cells->x1 && cells->y0 <= cells->y1;
+}
+
+#if !PHEROMONE_LAZY_EVAPORATION
+// Blocked updates (set_pheromone_block_ticks). Each channel's chunk is
+// advanced every tick of the block at once, in a tile that also holds the
+// cells up to that many steps around it, so the planes are read and written
+// once per block and the steps in between stay in cache. Each step drops
+// one ring of the tile, whose cells can no longer be computed, so the last
+// step yields exactly the chunk; the ring is recomputed by every tile that
+// overlaps it. Cells sum the same values in the same order as in the
+// per-tick update, so float planes come out bit-identical; fixed-point
+// planes are rounded once per block instead of once per tick.
+#define BLOCK_TILE_STRIDE (CHUNK_SIZE + 2 * PHEROMONE_BLOCK_MAX_TICKS)
+#define BLOCK_TILE_CELLS (BLOCK_TILE_STRIDE * BLOCK_TILE_STRIDE)
+
+// Part of a tile that one channel of the tile's colony covers (the tile's
+// own channel included)
+typedef struct TilePiece {
+    const PheromoneChannel* source;
+    int tx;                  // Tile position of the first cell
+    int ty;
+    int lx;                  // Local position of that cell in the source
+    int ly;
+    int cols;
+    int rows;
+} TilePiece;
+
+// Working set of one worker band: two generations of both planes
+typedef struct BlockTile {
+    float planes[2][2][BLOCK_TILE_CELLS];  // [generation][type]
+} BlockTile;
+
+static BlockTile* g_block_tiles[MAX_WORKER_THREADS];
+static TilePiece* g_tile_pieces = NULL;
+static int g_piece_capacity = 0;
+static int* g_piece_starts = NULL;       // Pass channel i owns pieces [start[i], start[i + 1])
+static int g_piece_start_capacity = 0;
+
+// Every channel with pheromone gets a channel for the same colony in each
+// chunk within steps (at most CHUNK_SIZE) cells of its box, marked active
+// so the pass takes it
+static void expand_pheromone_reach(World* world, int steps) {
+    SpanRun columns[3 * CHUNK_SIZE];
+    SpanRun rows[3 * CHUNK_SIZE];
+    
+    // Channels allocated here hold nothing yet and need no expansion
+    int count = world->chunk_count;
+    for (int c = 0; c < count; c++) {
+        Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            const PheromoneChannel* channel = chunk->channels[k];
+            TileRect cells;
+            if (!channel->pheromone_active || !box_cells(channel, &cells)) continue;
+            if (cells.x0 >= steps && cells.y0 >= steps &&
+                cells.x1 < chunk->cols - steps && cells.y1 < chunk->rows - steps) continue;
+            
+            int column_count = split_span(chunk->cx * CHUNK_SIZE + cells.x0 - steps,
+                                          cells.x1 - cells.x0 + 1 + 2 * steps,
+                                          world->width, world->toroidal, columns);
+            int row_count = split_span(chunk->cy * CHUNK_SIZE + cells.y0 - steps,
+                                       cells.y1 - cells.y0 + 1 + 2 * steps,
+                                       world->height, world->toroidal, rows);
+            for (int r = 0; r < row_count; r++) {
+                for (int q = 0; q < column_count; q++) {
+                    if (rows[r].chunk < 0 || columns[q].chunk < 0) continue;
+                    if (rows[r].chunk == chunk->cy && columns[q].chunk == chunk->cx) continue;
+                    
+                    PheromoneChannel* reached = touch_pheromone_channel(
+                        world, touch_chunk_at(world, columns[q].chunk, rows[r].chunk), channel->colony);
+                    if (reached != NULL) reached->pheromone_active = 1;
+                }
+            }
+        }
+    }
+}
+
+// Makes step_end[s] of every pass channel's deposit lists the count of
+// deposits made up to tick s, for ticks that made none too
+static void close_block_deposits(const PheromonePass* pass, int steps) {
+    for (int i = 0; i < pass->count; i++) {
+        for (int l = 0; l < 2; l++) {
+            PheromoneDepositList* list = &pass->channels[i]->deposits[l];
+            list->step_end[0] = 0;
+            for (int s = 1; s <= steps; s++) {
+                if (list->step_end[s] < list->step_end[s - 1]) list->step_end[s] = list->step_end[s - 1];
+            }
+        }
+    }
+}
+
+// Deposit lists of a piece's source that can fall in the piece: both if
+// it reaches the chunk's interior, otherwise only the border one
+static int piece_deposit_lists(const TilePiece* piece) {
+    const Chunk* chunk = piece->source->chunk;
+    if (piece->lx + piece->cols > PHEROMONE_BLOCK_MAX_TICKS && piece->lx < chunk->cols - PHEROMONE_BLOCK_MAX_TICKS &&
+        piece->ly + piece->rows > PHEROMONE_BLOCK_MAX_TICKS && piece->ly < chunk->rows - PHEROMONE_BLOCK_MAX_TICKS) {
+        return 2;
+    }
+    return 1;
+}
+
+// Looks up the pieces of every pass channel's tile, steps cells around its
+// chunk. Returns 0 if out of memory.
+static int collect_tile_pieces(const World* world, const PheromonePass* pass, int steps) {
+    if (g_piece_start_capacity < pass->count + 1) {
+        int* starts = (int*)safe_realloc(g_piece_starts, (pass->count + 1) * sizeof(int));
+        if (starts == NULL) return 0;
+        g_piece_starts = starts;
+        g_piece_start_capacity = pass->count + 1;
+    }
+    
+    SpanRun columns[BLOCK_TILE_STRIDE];
+    SpanRun rows[BLOCK_TILE_STRIDE];
+    int total = 0;
+    for (int i = 0; i < pass->count; i++) {
+        const PheromoneChannel* channel = pass->channels[i];
+        const Chunk* chunk = channel->chunk;
+        int column_count = split_span(chunk->cx * CHUNK_SIZE - steps, chunk->cols + 2 * steps,
+                                      world->width, world->toroidal, columns);
+        int row_count = split_span(chunk->cy * CHUNK_SIZE - steps, chunk->rows + 2 * steps,
+                                   world->height, world->toroidal, rows);
+        
+        g_piece_starts[i] = total;
+        for (int r = 0; r < row_count; r++) {
+            for (int q = 0; q < column_count; q++) {
+                if (rows[r].chunk < 0 || columns[q].chunk < 0) continue;
+                const PheromoneChannel* source = get_pheromone_channel(
+                    get_chunk_at(world, columns[q].chunk, rows[r].chunk), channel->colony);
+                if (source == NULL || !source->pheromone_active) continue;
+                
+                if (total == g_piece_capacity) {
+                    int capacity = g_piece_capacity ? g_piece_capacity * 2 : 256;
+                    TilePiece* pieces = (TilePiece*)safe_realloc(g_tile_pieces, capacity * sizeof(TilePiece));
+                    if (pieces == NULL) return 0;
+                    g_tile_pieces = pieces;
+                    g_piece_capacity = capacity;
+                }
+                TilePiece* piece = &g_tile_pieces[total++];
+                piece->source = source;
+                piece->tx = columns[q].start;
+                piece->ty = rows[r].start;
+                piece->lx = columns[q].local;
+                piece->ly = rows[r].local;
+                piece->cols = columns[q].length;
+                piece->rows = rows[r].length;
+            }
+        }
+    }
+    g_piece_starts[pass->count] = total;
+    return 1;
+}
+
+// A tile for every worker band. Returns 0 if out of memory.
+static int reserve_block_tiles(void) {
+    int bands = get_worker_threads();
+    for (int band = 0; band < bands; band++) {
+        if (g_block_tiles[band] == NULL) {
+            g_block_tiles[band] = (BlockTile*)safe_malloc(sizeof(BlockTile));
+            if (g_block_tiles[band] == NULL) return 0;
+        }
+    }
+    return 1;
+}
+
+// Part of piece (in tile coordinates) its source's box covers. Returns 0 if
+// none.
+static int piece_cells(const TilePiece* piece, TileRect* cells) {
+    TileRect box;
+    if (!box_cells(piece->source, &box)) return 0;
+    int x0 = (box.x0 > piece->lx) ? box.x0 : piece->lx;
+    int y0 = (box.y0 > piece->ly) ? box.y0 : piece->ly;
+    int x1 = (box.x1 < piece->lx + piece->cols - 1) ? box.x1 : piece->lx + piece->cols - 1;
+    int y1 = (box.y1 < piece->ly + piece->rows - 1) ? box.y1 : piece->ly + piece->rows - 1;
+    cells->x0 = piece->tx + x0 - piece->lx;
+    cells->y0 = piece->ty + y0 - piece->ly;
+    cells->x1 = piece->tx + x1 - piece->lx;
+    cells->y1 = piece->ty + y1 - piece->ly;
+    return x0 <= x1 && y0 <= y1;
+}
+
+// Copies the pieces' pheromone into generation 0 of the tile
+static void gather_tile(const PheromoneKernels* kernels, const TilePiece* pieces, int piece_count,
+                        BlockTile* tile, long long* traffic) {
+    for (int p = 0; p < piece_count; p++) {
+        const TilePiece* piece = &pieces[p];
+        const PheromoneChannel* source = piece->source;
+        TileRect cells;
+        if (piece_cells(piece, &cells)) {
+            int count = cells.x1 - cells.x0 + 1;
+            for (int ty = cells.y0; ty <= cells.y1; ty++) {
+                int from = CHUNK_PAD_INDEX(piece->lx + cells.x0 - piece->tx, piece->ly + ty - piece->ty);
+                int to = ty * BLOCK_TILE_STRIDE + cells.x0;
+#if PHEROMONE_FIXED_POINT
+                kernels->unpack_row(source->pheromone_food + from, tile->planes[0][0] + to, count);
+                kernels->unpack_row(source->pheromone_home + from, tile->planes[0][1] + to, count);
+#else
+                (void)kernels;
+                memcpy(tile->planes[0][0] + to, source->pheromone_food + from, count * sizeof(float));
+                memcpy(tile->planes[0][1] + to, source->pheromone_home + from, count * sizeof(float));
+#endif
+            }
+            *traffic += (long long)2 * sizeof(PheromoneValue) * count * (cells.y1 - cells.y0 + 1);
+        }
+    }
+}
+
+// Adds tick step's deposits that fall in the pieces to the tile planes
+// food and home, in the order they were made, as add_pheromone would
+static void apply_tile_deposits(const TilePiece* pieces, int piece_count, int step, float* food, float* home) {
+    for (int p = 0; p < piece_count; p++) {
+        const TilePiece* piece = &pieces[p];
+        int lists = piece_deposit_lists(piece);
+        for (int l = 0; l < lists; l++) {
+            const PheromoneDepositList* list = &piece->source->deposits[l];
+            for (int d = list->step_end[step - 1]; d < list->step_end[step]; d++) {
+                const PheromoneDeposit* deposit = &list->deposits[d];
+                int lx = deposit->x - piece->lx;
+                int ly = deposit->y - piece->ly;
+                if (lx < 0 || lx >= piece->cols || ly < 0 || ly >= piece->rows) continue;
+                
+                int index = (piece->ty + ly) * BLOCK_TILE_STRIDE + piece->tx + lx;
+                float* plane = (deposit->type == PHEROMONE_TYPE_FOOD) ? food : home;
+                float level = plane[index] + deposit->amount;
+                if (level > PHEROMONE_MAX) {
+                    level = PHEROMONE_MAX;
+                }
+                plane[index] = level;
+            }
+        }
+    }
+}
+
+// Advances one channel steps ticks: its tile is gathered from the pieces,
+// stepped with each tick's deposits and evaporation, and the chunk's part
+// written to the back planes. Other tiles still read the front planes, so
+// the caller swaps them once the pass is done. Adds the plane bytes read
+// and written to *traffic. Returns whether any cell will hold pheromone.
+static int block_channel(const World* world, PheromoneChannel* channel, const TilePiece* pieces,
+                         int piece_count, int steps, BlockTile* tile, long long* traffic) {
+    const PheromoneKernels* kernels = get_pheromone_kernels();
+    const Chunk* chunk = channel->chunk;
+    int width = chunk->cols + 2 * steps;
+    int height = chunk->rows + 2 * steps;
+    int origin_x = chunk->cx * CHUNK_SIZE - steps;  // World position of tile cell (0, 0)
+    int origin_y = chunk->cy * CHUNK_SIZE - steps;
+    
+    // Cells that may hold pheromone at the start, deposits included
+    TileRect reach = { width, height, -1, -1 };
+    for (int p = 0; p < piece_count; p++) {
+        TileRect cells;
+        if (!piece_cells(&pieces[p], &cells)) continue;
+        if (cells.x0 < reach.x0) reach.x0 = cells.x0;
+        if (cells.y0 < reach.y0) reach.y0 = cells.y0;
+        if (cells.x1 > reach.x1) reach.x1 = cells.x1;
+        if (cells.y1 > reach.y1) reach.y1 = cells.y1;
+    }
+    
+    // Tile cells inside a bounded world
+    TileRect inside = { 0, 0, width - 1, height - 1 };
+    if (!world->toroidal) {
+        if (inside.x0 < -origin_x) inside.x0 = -origin_x;
+        if (inside.y0 < -origin_y) inside.y0 = -origin_y;
+        if (inside.x1 > world->width - 1 - origin_x) inside.x1 = world->width - 1 - origin_x;
+        if (inside.y1 > world->height - 1 - origin_y) inside.y1 = world->height - 1 - origin_y;
+    }
+    
+    PheromoneBox result;
+    clear_pheromone_box(&result);
+    TileRect cells = { 0, 0, -1, -1 };  // Cells the latest step computed
+    if (reach.x0 <= reach.x1) {
+        // Both generations start zero wherever the steps can read, then
+        // take the pieces' pheromone
+        int zx0 = (reach.x0 > steps) ? reach.x0 - steps - 1 : 0;
+        int zy0 = (reach.y0 > steps) ? reach.y0 - steps - 1 : 0;
+        int zx1 = (reach.x1 + steps + 1 < width - 1) ? reach.x1 + steps + 1 : width - 1;
+        int zy1 = (reach.y1 + steps + 1 < height - 1) ? reach.y1 + steps + 1 : height - 1;
+        for (int ty = zy0; ty <= zy1; ty++) {
+            for (int g = 0; g < 2; g++) {
+                memset(tile->planes[g][0] + ty * BLOCK_TILE_STRIDE + zx0, 0, (zx1 - zx0 + 1) * sizeof(float));
+                memset(tile->planes[g][1] + ty * BLOCK_TILE_STRIDE + zx0, 0, (zx1 - zx0 + 1) * sizeof(float));
+            }
+        }
+        gather_tile(kernels, pieces, piece_count, tile, traffic);
+        
+        for (int s = 1; s <= steps; s++) {
+            float* src_food = tile->planes[(s - 1) & 1][0];
+            float* src_home = tile->planes[(s - 1) & 1][1];
+            float* dst_food = tile->planes[s & 1][0];
+            float* dst_home = tile->planes[s & 1][1];
+            
+            // Tick s's deposits land before it evaporates and diffuses, as
+            // the ants' step precedes the update
+            apply_tile_deposits(pieces, piece_count, s, src_food, src_home);
+            
+            // Cells this step can compute: s cells in from the tile's edge,
+            // in the world, and within s cells of the starting pheromone
+            cells.x0 = (reach.x0 - s > s) ? reach.x0 - s : s;
+            cells.y0 = (reach.y0 - s > s) ? reach.y0 - s : s;
+            cells.x1 = (reach.x1 + s < width - 1 - s) ? reach.x1 + s : width - 1 - s;
+            cells.y1 = (reach.y1 + s < height - 1 - s) ? reach.y1 + s : height - 1 - s;
+            if (cells.x0 < inside.x0) cells.x0 = inside.x0;
+            if (cells.y0 < inside.y0) cells.y0 = inside.y0;
+            if (cells.x1 > inside.x1) cells.x1 = inside.x1;
+            if (cells.y1 > inside.y1) cells.y1 = inside.y1;
+            if (cells.x0 > cells.x1 || cells.y0 > cells.y1) {
+                // Nothing left within reach: the rest of the block is zero
+                cells.x0 = cells.y0 = 0;
+                cells.x1 = cells.y1 = -1;
+                break;
+            }
+            
+            // The cells read are evaporated in place first
+            for (int ty = cells.y0 - 1; ty <= cells.y1 + 1; ty++) {
+                int start = ty * BLOCK_TILE_STRIDE + cells.x0 - 1;
+                kernels->evaporate_row(src_food + start, src_food + start, cells.x1 - cells.x0 + 3);
+                kernels->evaporate_row(src_home + start, src_home + start, cells.x1 - cells.x0 + 3);
+            }
+            
+            for (int ty = cells.y0; ty <= cells.y1; ty++) {
+                int row = ty * BLOCK_TILE_STRIDE;
+                StencilRows food = { src_food + row - BLOCK_TILE_STRIDE, src_food + row, src_food + row + BLOCK_TILE_STRIDE };
+                StencilRows home = { src_home + row - BLOCK_TILE_STRIDE, src_home + row, src_home + row + BLOCK_TILE_STRIDE };
+                int active = diffuse_span(world, kernels, &food, &home, dst_food + row, dst_home + row,
+                                          cells.x0, cells.x1, origin_x, origin_y + ty);
+                if (active && s == steps) {
+                    if (result.y0 > ty - steps) result.y0 = (int16_t)(ty - steps);
+                    result.y1 = (int16_t)(ty - steps);
+                }
+            }
+        }
+    }
+    
+    // The last step's cells lie within the chunk; they go to the back
+    // planes and the rest of those is cleared
+    int x0 = cells.x0 - steps, x1 = cells.x1 - steps;
+    int y0 = cells.y0 - steps, y1 = cells.y1 - steps;
+    if (cells.x0 > cells.x1) {
+        x0 = y0 = 0;
+        x1 = y1 = -1;
+    }
+    clear_back_planes(channel, x0, y0, x1, y1);
+    const float* food = tile->planes[steps & 1][0];
+    const float* home = tile->planes[steps & 1][1];
+    for (int ly = y0; ly <= y1; ly++) {
+        const float* from_food = food + (ly + steps) * BLOCK_TILE_STRIDE + x0 + steps;
+        const float* from_home = home + (ly + steps) * BLOCK_TILE_STRIDE + x0 + steps;
+        int to = CHUNK_PAD_INDEX(x0, ly);
+#if PHEROMONE_FIXED_POINT
+        unsigned int column = (unsigned int)(chunk->cx * CHUNK_SIZE + x0);
+        int y = chunk->cy * CHUNK_SIZE + ly;
+        kernels->pack_row(from_food, channel->back_food + to, x1 - x0 + 1,
+                          dither_seed(world, y, PHEROMONE_TYPE_FOOD) + column);
+        kernels->pack_row(from_home, channel->back_home + to, x1 - x0 + 1,
+                          dither_seed(world, y, PHEROMONE_TYPE_HOME) + column);
+#else
+        memcpy(channel->back_food + to, from_food, (x1 - x0 + 1) * sizeof(float));
+        memcpy(channel->back_home + to, from_home, (x1 - x0 + 1) * sizeof(float));
+#endif
+    }
+    if (y0 <= y1) {
+        *traffic += (long long)2 * sizeof(PheromoneValue) * (x1 - x0 + 1) * (y1 - y0 + 1);
+    }
+    
+    set_back_box(channel, result, x0, x1);
+    return result.y0 <= result.y1;
+}
+
+static void block_band(void* context, int band, int band_count) {
+    PheromonePass* pass = (PheromonePass*)context;
+    int first, last;
+    band_range(pass, band, band_count, &first, &last);
+    
+    for (int i = first; i < last; i++) {
+        PheromoneChannel* channel = pass->channels[i];
+        const TilePiece* pieces = g_tile_pieces + g_piece_starts[i];
+        int piece_count = g_piece_starts[i + 1] - g_piece_starts[i];
+        channel->pheromone_active = block_channel(pass->world, channel, pieces, piece_count, pass->steps,
+                                                  g_block_tiles[band], &pass->traffic[band]);
+    }
+}
+
+// Runs the ticks the blocked update owes in one pass, deposits included,
+// then rebuilds the halos as update_pheromone_planes does. Returns 0 if out
+// of memory, leaving every channel as it was.
+static int advance_pheromone_block(World* world, int steps) {
+    invalidate_pheromone_gradients(world);
+    expand_pheromone_reach(world, steps);
+    get_pheromone_kernels();  // Picked here, before any worker asks
+    
+    PheromonePass pass;
+    if (!collect_pass_channels(world, 0, 1, &pass)) return 0;
+    for (int i = 0; i < pass.count; i++) {
+        if (!reserve_pheromone_buffers(pass.channels[i])) return 0;
+    }
+    if (!collect_tile_pieces(world, &pass, steps) || !reserve_block_tiles()) return 0;
+    close_block_deposits(&pass, steps);
+    
+    pass.steps = steps;
+    run_pass(block_band, &pass);
+    count_pass_traffic(&pass);
+    for (int i = 0; i < pass.count; i++) {
+        swap_pheromone_planes(pass.channels[i]);
+    }
+    
+    mark_stale_halos(world, &pass, 1);
+    if (!collect_pass_channels(world, 1, 1, &pass)) return 0;
+    run_pass(refresh_band, &pass);
+    return 1;
+}
+
+static void run_pheromone_block(World* world) {
+    if (!advance_pheromone_block(world, world->pheromone_block_ticks)) {
+        print_error("Out of memory for the blocked pheromone update");
+    }
+    world->pheromone_block_ticks = 0;
+    clear_block_deposits(world);
+}
+
+// Implicit diffusion (set_pheromone_implicit_dt). An update diffuses along
+// rows and then along columns, each pass solving the tridiagonal system of
+// one backward Euler step on its axis, which is stable for any step size.
+// A row is solved over a run of consecutive chunks that hold a channel of
+// its colony, round the world if the run closes on itself. Walls and a
+// bounded world's edges pass no pheromone; the open ends of a run absorb
+// what reaches them, but channels are first allocated as far as a solve
+// can carry pheromone above PHEROMONE_MIN_THRESHOLD, so none does. Levels
+// below the threshold are dropped afterwards, as evaporation drops them.
+// Chunk rows (and columns) are solved independently, so the two passes
+// split over the worker threads and give the same result for any count.
+
+// Per-axis coefficient of dt ticks. An explicit tick hands each of the 6
+// neighbours off a cell's column (or row) PHEROMONE_DIFFUSION_RATE / 8 of
+// it, a variance of 0.75 * rate along the axis; one backward Euler step
+// with coefficient a adds a variance of 2a.
+static float implicit_coefficient(int dt) {
+    return 0.375f * PHEROMONE_DIFFUSION_RATE * (float)dt;
+}
+
+// Cells along an axis past which a solve leaves a full cell less than
+// PHEROMONE_MIN_THRESHOLD: its response falls by the smaller root r of
+// a r^2 - (1 + 2a) r + a = 0 per cell
+static int implicit_reach(float a) {
+    float r = (1.0f + 2.0f * a - sqrtf(1.0f + 4.0f * a)) / (2.0f * a);
+    int reach = (int)ceilf(logf(PHEROMONE_MIN_THRESHOLD / PHEROMONE_MAX) / logf(r));
+    return clamp_int(reach, 1, CHUNK_SIZE);
+}
+
+// Factors the system of n >= 2 cells (1 + 2a) u[i] - a u[i - 1] - a u[i + 1]
+// = v[i], with first and last as the diagonal of the two end cells: factor
+// and inverse get each row's elimination factor and reciprocal pivot
+static void factor_tridiagonal(float* factor, float* inverse, int n, float a, float first, float last) {
+    float pivot = first;
+    for (int i = 0; i < n; i++) {
+        if (i > 0) pivot = ((i == n - 1) ? last : 1.0f + 2.0f * a) + a * factor[i - 1];
+        inverse[i] = 1.0f / pivot;
+        factor[i] = -a * inverse[i];
+    }
+}
+
+// Solves a factored system for the values in u, in place
+static void substitute_tridiagonal(float* u, const float* factor, const float* inverse, int n, float a) {
+    u[0] *= inverse[0];
+    for (int i = 1; i < n; i++) {
+        u[i] = (u[i] + a * u[i - 1]) * inverse[i];
+    }
+    for (int i = n - 2; i >= 0; i--) {
+        u[i] -= factor[i] * u[i + 1];
+    }
+}
+
+// How a line ends: against a wall or a bounded world's edge, at the open
+// end of a run, or joined to its other end
+#define LINE_END_CLOSED 0
+#define LINE_END_OPEN 1
+#define LINE_RING 2
+
+// Per-band working set: one line of levels of both types and the walls
+// along it, the factors of its system, and the channels of the run being
+// solved. Lines without walls of the same length and ends share a system,
+// so its factors are kept until a different one is needed.
+typedef struct ImplicitLine {
+    float* level[2];         // Food, home
+    float* factor;
+    float* inverse;
+    float* fix;              // Ring correction, see factor_line
+    float* scratch;
+    uint8_t* open;           // 0 on walls, which keep their level
+    uint8_t* rotated;
+    int factored_n;          // System in factor, 0 when none is kept
+    int factored_start;
+    int factored_end;
+    float factored_a;
+    float fix_scale;         // Ring correction denominator
+    PheromoneChannel** run;
+    PheromoneBox* boxes;     // Column pass: box of each run channel's result
+    int capacity;            // Cells
+    int run_capacity;        // Channels
+} ImplicitLine;
+
+static ImplicitLine g_implicit_lines[MAX_WORKER_THREADS];
+
+// Line buffers for every worker band. Returns 0 if out of memory.
+static int reserve_implicit_lines(const World* world) {
+    int cells = (world->width > world->height) ? world->width : world->height;
+    int chunks = (world->chunks_x > world->chunks_y) ? world->chunks_x : world->chunks_y;
+    int bands = get_worker_threads();
+    for (int band = 0; band < bands; band++) {
+        ImplicitLine* line = &g_implicit_lines[band];
+        if (line->capacity < cells) {
+            float* level = (float*)safe_realloc(line->level[0], 6 * (size_t)cells * sizeof(float));
+            if (level == NULL) return 0;
+            uint8_t* open = (uint8_t*)safe_realloc(line->open, 2 * (size_t)cells);
+            if (open == NULL) {
+                line->level[0] = level;  // Keeps the capacity it had
+                return 0;
+            }
+            line->level[0] = level;
+            line->level[1] = level + cells;
+            line->factor = level + 2 * (size_t)cells;
+            line->inverse = level + 3 * (size_t)cells;
+            line->fix = level + 4 * (size_t)cells;
+            line->scratch = level + 5 * (size_t)cells;
+            line->open = open;
+            line->rotated = open + cells;
+            line->capacity = cells;
+            line->factored_n = 0;
+        }
+        if (line->run_capacity < chunks) {
+            PheromoneChannel** run = (PheromoneChannel**)safe_realloc(line->run, chunks * sizeof(PheromoneChannel*));
+            if (run == NULL) return 0;
+            line->run = run;
+            PheromoneBox* boxes = (PheromoneBox*)safe_realloc(line->boxes, chunks * sizeof(PheromoneBox));
+            if (boxes == NULL) return 0;
+            line->boxes = boxes;
+            line->run_capacity = chunks;
+        }
+    }
+    return 1;
+}
+
+// Factors the system of a line of n cells without walls, unless it is the
+// one already factored. A ring of n >= 3 cells is solved by Sherman-Morrison:
+// its corner terms are folded into the end diagonals, and fix holds the
+// correction the result then needs, scaled by each solve's own error.
+static void factor_line(ImplicitLine* line, int n, float a, int start, int end) {
+    if (line->factored_n == n && line->factored_start == start && line->factored_end == end &&
+        line->factored_a == a) return;
+    
+    float diagonal = 1.0f + 2.0f * a;
+    if (start == LINE_RING) {
+        float gamma = -diagonal;
+        factor_tridiagonal(line->factor, line->inverse, n, a, diagonal - gamma, diagonal - a * a / gamma);
+        line->fix[0] = gamma;
+        for (int i = 1; i < n - 1; i++) line->fix[i] = 0.0f;
+        line->fix[n - 1] = -a;
+        substitute_tridiagonal(line->fix, line->factor, line->inverse, n, a);
+        line->fix_scale = 1.0f / (1.0f + line->fix[0] - a * line->fix[n - 1] / gamma);
+    } else {
+        factor_tridiagonal(line->factor, line->inverse, n, a,
+                           (start == LINE_END_OPEN) ? diagonal : 1.0f + a,
+                           (end == LINE_END_OPEN) ? diagonal : 1.0f + a);
+    }
+    line->factored_n = n;
+    line->factored_start = start;
+    line->factored_end = end;
+    line->factored_a = a;
+}
+
+// Solves the n cells of both types gathered in line, in place. Walls split
+// it into separate systems closed at the wall; a ring with a wall in it is
+// solved from just past the wall, so that every system lies in one piece.
+static void solve_line(ImplicitLine* line, int n, float a, int start, int end) {
+    if (n <= 0) return;
+    const uint8_t* wall = (const uint8_t*)memchr(line->open, 0, (size_t)n);
+    if (wall == NULL && (start != LINE_RING || n >= 3) && n >= 2) {
+        factor_line(line, n, a, start, end);
+        for (int type = 0; type < 2; type++) {
+            float* level = line->level[type];
+            substitute_tridiagonal(level, line->factor, line->inverse, n, a);
+            if (start == LINE_RING) {
+                float scale = (level[0] + a * level[n - 1] / (1.0f + 2.0f * a)) * line->fix_scale;
+                for (int i = 0; i < n; i++) {
+                    level[i] -= scale * line->fix[i];
+                }
+            }
+        }
+        return;
+    }
+    
+    // The wall (if any) becomes a ring's last cell
+    int shift = 0;
+    if (start == LINE_RING) {
+        shift = (wall == NULL) ? 0 : (int)(wall - line->open + 1) % n;
+        start = end = LINE_END_CLOSED;
+    }
+    if (shift != 0) {
+        for (int type = 0; type < 2; type++) {
+            memcpy(line->scratch, line->level[type], (size_t)n * sizeof(float));
+            for (int i = 0; i < n; i++) {
+                line->level[type][i] = line->scratch[(i + shift) % n];
+            }
+        }
+        memcpy(line->rotated, line->open, (size_t)n);
+        for (int i = 0; i < n; i++) {
+            line->open[i] = line->rotated[(i + shift) % n];
+        }
+    }
+    
+    line->factored_n = 0;  // The segments overwrite the factors
+    for (int i = 0; i < n;) {
+        if (!line->open[i]) {
+            i++;
+            continue;
+        }
+        int j = i;
+        while (j < n && line->open[j]) j++;
+        
+        // Cells i..j-1; an end on the line's own end takes its kind
+        float open_first = (i == 0 && start == LINE_END_OPEN) ? a : 0.0f;
+        float open_last = (j == n && end == LINE_END_OPEN) ? a : 0.0f;
+        if (j - i == 1) {
+            float keep = 1.0f / (1.0f + open_first + open_last);
+            line->level[0][i] *= keep;
+            line->level[1][i] *= keep;
+        } else {
+            factor_tridiagonal(line->factor + i, line->inverse + i, j - i, a,
+                               1.0f + a + open_first, 1.0f + a + open_last);
+            substitute_tridiagonal(line->level[0] + i, line->factor + i, line->inverse + i, j - i, a);
+            substitute_tridiagonal(line->level[1] + i, line->factor + i, line->inverse + i, j - i, a);
+        }
+        i = j;
+    }
+    
+    if (shift != 0) {
+        for (int type = 0; type < 2; type++) {
+            memcpy(line->scratch, line->level[type], (size_t)n * sizeof(float));
+            for (int i = 0; i < n; i++) {
+                line->level[type][(i + shift) % n] = line->scratch[i];
+            }
+        }
+        memcpy(line->open, line->rotated, (size_t)n);
+    }
+}
+
+// Run of colony's channels along one axis that starts at chunk: the chunks
+// after it, in order, as long as each holds such a channel. A line of
+// chunks that all hold one is a ring, started from its first chunk. Sets
+// how the run ends and returns its length, 0 if chunk starts none.
+static int collect_run(const World* world, const Chunk* chunk, int colony, int horizontal,
+                       PheromoneChannel** run, int* start, int* end) {
+    int step_x = horizontal ? 1 : 0;
+    int step_y = horizontal ? 0 : 1;
+    int coord = horizontal ? chunk->cx : chunk->cy;
+    int last_coord = (horizontal ? world->chunks_x : world->chunks_y) - 1;
+    
+    const Chunk* before = get_neighbor_chunk(world, chunk->cx - step_x, chunk->cy - step_y);
+    int ring = before != NULL && get_pheromone_channel(before, colony) != NULL;
+    if (ring && coord != 0) return 0;
+    
+    int count = 0;
+    const Chunk* next = chunk;
+    PheromoneChannel* channel = get_pheromone_channel(chunk, colony);
+    while (channel != NULL) {
+        run[count++] = channel;
+        next = get_neighbor_chunk(world, next->cx + step_x, next->cy + step_y);
+        if (next == NULL || next == chunk) break;
+        channel = get_pheromone_channel(next, colony);
+    }
+    if (ring) {
+        if (next != chunk) return 0;  // Starts further back
+        *start = *end = LINE_RING;
+        return count;
+    }
+    
+    const Chunk* tail = run[count - 1]->chunk;
+    *start = (!world->toroidal && coord == 0) ? LINE_END_CLOSED : LINE_END_OPEN;
+    *end = (!world->toroidal && (horizontal ? tail->cx : tail->cy) == last_coord) ? LINE_END_CLOSED
+                                                                                 : LINE_END_OPEN;
+    return count;
+}
+
+typedef struct ImplicitPass {
+    World* world;
+    float coefficient;
+    int evaporate;
+    long long traffic[MAX_WORKER_THREADS];  // Plane bytes each band moved
+} ImplicitPass;
+
+static PheromoneValue* type_plane(PheromoneChannel* channel, int type) {
+    return (type == PHEROMONE_TYPE_FOOD) ? channel->pheromone_food : channel->pheromone_home;
+}
+
+// Solves the rows a run holds pheromone in, in place. Every run channel's
+// box then spans those rows in full.
+static void solve_run_rows(ImplicitPass* pass, ImplicitLine* line, PheromoneChannel** run, int count,
+                           int start, int end, long long* traffic) {
+    int y0 = CHUNK_SIZE, y1 = -1;
+    for (int j = 0; j < count; j++) {
+        TileRect cells;
+        if (!box_cells(run[j], &cells)) continue;
+        if (cells.y0 < y0) y0 = cells.y0;
+        if (cells.y1 > y1) y1 = cells.y1;
+    }
+    if (y0 > y1) return;
+    
+#if PHEROMONE_FIXED_POINT
+    const PheromoneKernels* kernels = get_pheromone_kernels();
+#endif
+    for (int ly = y0; ly <= y1; ly++) {
+        int n = 0;
+        for (int j = 0; j < count; j++) {
+            const Chunk* chunk = run[j]->chunk;
+            const uint16_t* bits = chunk->cell_bits + CHUNK_PAD_INDEX(0, ly);
+            for (int lx = 0; lx < chunk->cols; lx++) {
+                line->open[n + lx] = (uint8_t)TERRAIN_IS_WALKABLE(CELL_TERRAIN(bits[lx]));
+            }
+            n += chunk->cols;
+        }
+        
+        for (int type = 0; type < 2; type++) {
+            int offset = 0;
+            for (int j = 0; j < count; j++) {
+                const PheromoneValue* from = type_plane(run[j], type) + CHUNK_PAD_INDEX(0, ly);
+#if PHEROMONE_FIXED_POINT
+                kernels->unpack_row(from, line->level[type] + offset, run[j]->chunk->cols);
+#else
+                memcpy(line->level[type] + offset, from, run[j]->chunk->cols * sizeof(float));
+#endif
+                offset += run[j]->chunk->cols;
+            }
+        }
+        
+        solve_line(line, n, pass->coefficient, start, end);
+        
+        for (int type = 0; type < 2; type++) {
+            int offset = 0;
+            for (int j = 0; j < count; j++) {
+                const Chunk* chunk = run[j]->chunk;
+                PheromoneValue* to = type_plane(run[j], type) + CHUNK_PAD_INDEX(0, ly);
+#if PHEROMONE_FIXED_POINT
+                // Offset from the column pass's dither, which rounds the
+                // same cells again
+                unsigned int seed = ~dither_seed(pass->world, chunk->cy * CHUNK_SIZE + ly, type);
+                kernels->pack_row(line->level[type] + offset, to, chunk->cols,
+                                  seed + (unsigned int)(chunk->cx * CHUNK_SIZE));
+#else
+                memcpy(to, line->level[type] + offset, chunk->cols * sizeof(float));
+#endif
+                offset += chunk->cols;
+            }
+        }
+        *traffic += (long long)4 * sizeof(PheromoneValue) * n;
+    }
     
-    Cell* cell = get_cell(world, ant->pos.x, ant->pos.y);
-    if (cell == NULL) return;
+    for (int j = 0; j < count; j++) {
+        PheromoneBox* box = &run[j]->pheromone_box;
+        box->x0 = 0;
+        box->x1 = (int16_t)(run[j]->chunk->cols - 1);
+        box->y0 = (int16_t)y0;
+        box->y1 = (int16_t)y1;
+    }
+}
+
+// Solves the columns a run holds pheromone in, in place, evaporating the
+// result or dropping what is below the threshold. Every run channel's box
+// is then set to its non-zero cells and its halo left to the caller.
+static void solve_run_columns(ImplicitPass* pass, ImplicitLine* line, PheromoneChannel** run, int count,
+                              int start, int end, long long* traffic) {
+    int x0 = CHUNK_SIZE, x1 = -1;
+    for (int j = 0; j < count; j++) {
+        TileRect cells;
+        clear_pheromone_box(&line->boxes[j]);
+        if (!box_cells(run[j], &cells)) continue;
+        if (cells.x0 < x0) x0 = cells.x0;
+        if (cells.x1 > x1) x1 = cells.x1;
+    }
     
-    if (ant->state & ANT_STATE_SEARCHING) {
-        // Searching ants deposit home pheromone
-        cell->pheromone_home += PHEROMONE_DEPOSIT_AMOUNT;
-        if (cell->pheromone_home > PHEROMONE_MAX) {
-            cell->pheromone_home = PHEROMONE_MAX;
+#if PHEROMONE_FIXED_POINT
+    const PheromoneKernels* kernels = get_pheromone_kernels();
+#endif
+    for (int lx = x0; lx <= x1; lx++) {
+        int n = 0;
+        for (int j = 0; j < count; j++) {
+            const Chunk* chunk = run[j]->chunk;
+            for (int ly = 0; ly < chunk->rows; ly++) {
+                line->open[n + ly] = (uint8_t)TERRAIN_IS_WALKABLE(CELL_TERRAIN(chunk->cell_bits[CHUNK_PAD_INDEX(lx, ly)]));
+            }
+            n += chunk->rows;
         }
         
-        LOG_PHEROMONE_INFO("Ant %d deposited home pheromone at (%d, %d), level: %.1f", 
-                           ant->id, ant->pos.x, ant->pos.y, cell->pheromone_home);
-        
-    } else if (ant->state & ANT_STATE_RETURNING) {
-        // Returning ants deposit food pheromone
-        cell->pheromone_food += PHEROMONE_DEPOSIT_AMOUNT;
-        if (cell->pheromone_food > PHEROMONE_MAX) {
-            cell->pheromone_food = PHEROMONE_MAX;
+        for (int type = 0; type < 2; type++) {
+            int offset = 0;
+            for (int j = 0; j < count; j++) {
+                const PheromoneValue* from = type_plane(run[j], type);
+                for (int ly = 0; ly < run[j]->chunk->rows; ly++) {
+                    line->level[type][offset + ly] = PHEROMONE_UNPACK(from[CHUNK_PAD_INDEX(lx, ly)]);
+                }
+                offset += run[j]->chunk->rows;
+            }
         }
         
-        LOG_PHEROMONE_INFO("Ant %d deposited food pheromone at (%d, %d), level: %.1f", 
-                           ant->id, ant->pos.x, ant->pos.y, cell->pheromone_food);
+        solve_line(line, n, pass->coefficient, start, end);
+        
+        for (int type = 0; type < 2; type++) {
+            int offset = 0;
+            for (int j = 0; j < count; j++) {
+                const Chunk* chunk = run[j]->chunk;
+                PheromoneValue* to = type_plane(run[j], type);
+                PheromoneBox* box = &line->boxes[j];
+                for (int ly = 0; ly < chunk->rows; ly++) {
+                    float level = line->level[type][offset + ly];
+                    if (pass->evaporate) {
+                        level = evaporated_pheromone(level);
+                    } else if (level < PHEROMONE_MIN_THRESHOLD) {
+                        level = 0.0f;
+                    }
+                    PheromoneValue* cell = to + CHUNK_PAD_INDEX(lx, ly);
+#if PHEROMONE_FIXED_POINT
+                    int y = chunk->cy * CHUNK_SIZE + ly;
+                    kernels->pack_row(&level, cell, 1,
+                                      dither_seed(pass->world, y, type) + (unsigned int)(chunk->cx * CHUNK_SIZE + lx));
+#else
+                    *cell = level;
+#endif
+                    if (*cell != 0) {
+                        if (box->x0 > box->x1) {
+                            box->x0 = box->x1 = (int16_t)lx;
+                        }
+                        box->x1 = (int16_t)lx;
+                        if (box->y0 > ly) box->y0 = (int16_t)ly;
+                        if (box->y1 < ly) box->y1 = (int16_t)ly;
+                    }
+                }
+                offset += chunk->rows;
+            }
+        }
+        *traffic += (long long)4 * sizeof(PheromoneValue) * n;
+    }
+    
+    for (int j = 0; j < count; j++) {
+        run[j]->pheromone_box = line->boxes[j];
+        run[j]->pheromone_active = line->boxes[j].x0 <= line->boxes[j].x1;
     }
 }
 
-void deposit_pheromone_at_position(World* world, int x, int y, int type, float amount) {
-    if (world == NULL || !is_valid_position(world, x, y)) return;
-    
-    Cell* cell = get_cell(world, x, y);
-    if (cell == NULL) return;
+// Band of chunk rows (or columns) a worker solves
+static void implicit_band(ImplicitPass* pass, int band, int band_count, int horizontal) {
+    World* world = pass->world;
+    ImplicitLine* line = &g_implicit_lines[band];
+    int lines = horizontal ? world->chunks_y : world->chunks_x;
+    int length = horizontal ? world->chunks_x : world->chunks_y;
+    int first = (int)((long long)lines * band / band_count);
+    int last = (int)((long long)lines * (band + 1) / band_count);
     
-    if (type == PHEROMONE_TYPE_FOOD) {
-        cell->pheromone_food += amount;
-        if (cell->pheromone_food > PHEROMONE_MAX) {
-            cell->pheromone_food = PHEROMONE_MAX;
-        }
-    } else if (type == PHEROMONE_TYPE_HOME) {
-        cell->pheromone_home += amount;
-        if (cell->pheromone_home > PHEROMONE_MAX) {
-            cell->pheromone_home = PHEROMONE_MAX;
+    for (int l = first; l < last; l++) {
+        for (int t = 0; t < length; t++) {
+            const Chunk* chunk = horizontal ? get_chunk_at(world, t, l) : get_chunk_at(world, l, t);
+            if (chunk == NULL) continue;
+            for (int k = 0; k < chunk->channel_count; k++) {
+                int start, end;
+                int count = collect_run(world, chunk, chunk->channels[k]->colony, horizontal,
+                                        line->run, &start, &end);
+                if (count == 0) continue;
+                if (horizontal) {
+                    solve_run_rows(pass, line, line->run, count, start, end, &pass->traffic[band]);
+                } else {
+                    solve_run_columns(pass, line, line->run, count, start, end, &pass->traffic[band]);
+                }
+            }
         }
     }
 }
 
+static void implicit_row_band(void* context, int band, int band_count) {
+    implicit_band((ImplicitPass*)context, band, band_count, 1);
+}
+
+static void implicit_column_band(void* context, int band, int band_count) {
+    implicit_band((ImplicitPass*)context, band, band_count, 0);
+}
+
+// One implicit update of g_implicit_dt ticks' spread, evaporating once if
+// asked, then the halos are rebuilt as update_pheromone_planes does.
+// Returns 0 if out of memory, before anything changed.
+static int advance_pheromone_implicit(World* world, int evaporate) {
+    ImplicitPass implicit;
+    memset(&implicit, 0, sizeof(implicit));
+    implicit.world = world;
+    implicit.coefficient = implicit_coefficient(g_implicit_dt);
+    implicit.evaporate = evaporate;
+    
+    invalidate_pheromone_gradients(world);
+    expand_pheromone_reach(world, implicit_reach(implicit.coefficient));
+    get_pheromone_kernels();  // Picked here, before any worker asks
+    
+    PheromonePass pass;
+    if (!collect_pass_channels(world, 0, evaporate, &pass) || !reserve_implicit_lines(world)) return 0;
+    if (pass.count == 0) return 1;
+    
+    run_worker_bands(implicit_row_band, &implicit, world->chunks_y);
+    run_worker_bands(implicit_column_band, &implicit, world->chunks_x);
+    for (int band = 0; band < MAX_WORKER_THREADS; band++) {
+        g_plane_traffic += implicit.traffic[band];
+    }
+    
+    mark_stale_halos(world, &pass, 1);
+    if (!collect_pass_channels(world, 1, evaporate, &pass)) return 0;
+    run_pass(refresh_band, &pass);
+    return 1;
+}
+
+static void update_pheromone_implicit(World* world, int evaporate) {
+    if (!advance_pheromone_implicit(world, evaporate)) {
+        print_error("Out of memory for the implicit pheromone update");
+    }
+}
+#endif
+
+// Evaporation on its own. The simulation step evaporates inside
+// update_pheromones instead; this pass and diffuse_pheromones together give
+// the same result.
 void evaporate_pheromones(World* world) {
     if (world == NULL) return;
+#if PHEROMONE_LAZY_EVAPORATION
+    return;  // Levels evaporate as they are read
+#endif
+    flush_pheromone_block(world);
+    invalidate_pheromone_gradients(world);
     
-    for (int y = 0; y < world->height; y++) {
-        for (int x = 0; x < world->width; x++) {
-            Cell* cell = &world->grid[y][x];
-            
-            // Evaporate food pheromone
-            cell->pheromone_food *= (1.0f - PHEROMONE_EVAPORATION_RATE);
-            if (cell->pheromone_food < PHEROMONE_MIN_THRESHOLD) {  // USE CONSTANT
-                cell->pheromone_food = 0.0f;
-            }
-            
-            // Evaporate home pheromone
-            cell->pheromone_home *= (1.0f - PHEROMONE_EVAPORATION_RATE);
-            if (cell->pheromone_home < PHEROMONE_MIN_THRESHOLD) {  // USE CONSTANT
-                cell->pheromone_home = 0.0f;
-            }
+    // Only allocated channels hold pheromone, so only they are swept.
+    // The halo is evaporated along with the cells: it ends up equal to the
+    // neighbours' evaporated edge cells, so it stays in sync for free.
+    // Fixed-point rounding differs between a cell and its image across a
+    // wrapped edge, so there the halos are rebuilt instead.
+    PheromonePass pass;
+    if (!collect_pass_channels(world, 0, 1, &pass)) return;
+    get_pheromone_kernels();  // Picked here, before any worker asks
+#if PHEROMONE_FIXED_POINT
+    run_pass(evaporate_band, &pass);
+    mark_stale_halos(world, &pass, 0);
+    if (!collect_pass_channels(world, 1, 1, &pass)) return;
+    run_pass(refresh_band, &pass);
+#else
+    run_pass(evaporate_band, &pass);
+#endif
+}
+
+#if PHEROMONE_LAZY_EVAPORATION
+// Lazy evaporation: a level written at step t reads as
+// level * (1 - rate)^(now - t), cut to zero below the threshold, which
+// matches evaporating it once per step up to float rounding
+#define DECAY_TABLE_SIZE 1024
+
+static float g_decay[DECAY_TABLE_SIZE];  // (1 - rate)^age
+static int g_decay_steps = 0;            // Age at which even PHEROMONE_MAX is gone
+
+static void build_decay_table(void) {
+    double factor = 1.0f - PHEROMONE_EVAPORATION_RATE;
+    double power = 1.0;
+    for (int age = 0; age < DECAY_TABLE_SIZE; age++) {
+        g_decay[age] = (float)power;
+        power *= factor;
+    }
+    g_decay_steps = (int)ceil(log(PHEROMONE_MIN_THRESHOLD / PHEROMONE_MAX) / log(factor)) + 1;
+}
+
+float lazy_pheromone_level(const World* world, const PheromoneChannel* channel, const PheromoneValue* plane, int i) {
+    float level = plane[i];
+    if (level == 0.0f) return 0.0f;
+    
+    int age = world->current_step - channel->pheromone_step[i];
+    if (age <= 0) return level;
+    if (g_decay_steps == 0) build_decay_table();
+    if (age >= g_decay_steps) return 0.0f;
+    
+    level *= (age < DECAY_TABLE_SIZE) ? g_decay[age] : (float)pow(1.0f - PHEROMONE_EVAPORATION_RATE, age);
+    return (level < PHEROMONE_MIN_THRESHOLD) ? 0.0f : level;
+}
+
+// Writes the current levels back into the planes, as if written now
+static void settle_pheromones(World* world, PheromoneChannel* channel) {
+    copy_pheromone_levels(world, channel, channel->pheromone_food, channel->pheromone_home);
+    for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+        if (channel->pheromone_food[i] != 0.0f || channel->pheromone_home[i] != 0.0f) {
+            stamp_pheromone(channel, i, world->current_step);
+        }
+    }
+}
+
+// The per-step work left with lazy evaporation: channels whose last write
+// will have evaporated entirely by the next step are cleared and marked
+// inactive, so they can be released. Costs one check per channel.
+static void expire_pheromone_channels(World* world) {
+    if (g_decay_steps == 0) build_decay_table();
+    int next_step = world->current_step + 1;
+    
+    for (int c = 0; c < world->chunk_count; c++) {
+        Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            PheromoneChannel* channel = chunk->channels[k];
+            if (!channel->pheromone_active || next_step - channel->last_pheromone_step < g_decay_steps) continue;
+            memset(channel->pheromone_food, 0, CHUNK_PADDED_CELLS * sizeof(PheromoneValue));
+            memset(channel->pheromone_home, 0, CHUNK_PADDED_CELLS * sizeof(PheromoneValue));
+            channel->pheromone_active = 0;
+            clear_pheromone_box(&channel->pheromone_box);
+        }
+    }
+}
+#endif
+
+// Current levels of a channel's padded planes, for code that reads the
+// planes wholesale (saving)
+void copy_pheromone_levels(const World* world, const PheromoneChannel* channel, float* food, float* home) {
+#if !PHEROMONE_LAZY_EVAPORATION
+    (void)world;  // Stored levels are current
+#endif
+    for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+        food[i] = PHEROMONE_LEVEL(world, channel, channel->pheromone_food, i);
+        home[i] = PHEROMONE_LEVEL(world, channel, channel->pheromone_home, i);
+    }
+}
+
+// The reverse for whole padded planes of levels (loading), written as if
+// deposited now
+void store_pheromone_levels(PheromoneChannel* channel, const float* food, const float* home) {
+    for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+        channel->pheromone_food[i] = PHEROMONE_PACK(food[i]);
+        channel->pheromone_home[i] = PHEROMONE_PACK(home[i]);
+    }
+    channel->gradient_generation[0] = channel->gradient_generation[1] = 0;
+}
+
+// Evaporation and diffusion in one pass over the front planes, written to
+// the back planes that then become the front. Blocked updates only count
+// the tick until the block is full; implicit updates solve in place. Lazy
+// evaporation builds have no diffusion and only expire channels.
+void update_pheromones(World* world) {
+    if (world == NULL) return;
+#if PHEROMONE_LAZY_EVAPORATION
+    expire_pheromone_channels(world);
+#else
+    if (is_blocking(world)) {
+        if (++world->pheromone_block_ticks >= g_block_ticks) {
+            run_pheromone_block(world);
         }
+        return;
+    }
+    if (g_implicit_dt > 0) {
+        update_pheromone_implicit(world, 1);
+        return;
+    }
+    update_pheromone_planes(world, 1);
+#endif
+}
+
+void flush_pheromone_block(World* world) {
+    if (world == NULL) return;
+#if !PHEROMONE_LAZY_EVAPORATION
+    if (world->pheromone_block_ticks > 0) {
+        run_pheromone_block(world);
     }
+#endif
 }
 
 void diffuse_pheromones(World* world) {
     if (world == NULL) return;
+#if PHEROMONE_LAZY_EVAPORATION
+    return;  // Evaporation-only configuration
+#endif
+    flush_pheromone_block(world);
+#if !PHEROMONE_LAZY_EVAPORATION
+    if (g_implicit_dt > 0) {
+        update_pheromone_implicit(world, 0);
+        return;
+    }
+#endif
+    update_pheromone_planes(world, 0);
+}
+
+// Self-checks
+static float g_check_levels[4][CHUNK_PADDED_CELLS];
+
+// Whether two worlds hold the same chunks, channels and front planes
+static int same_pheromone_planes(const World* a, const World* b) {
+    if (a->chunk_count != b->chunk_count) return 0;
     
-    // Create temporary grid for diffusion calculations
-    float** temp_food = (float**)safe_malloc(world->height * sizeof(float*));
-    float** temp_home = (float**)safe_malloc(world->height * sizeof(float*));
+    for (int c = 0; c < a->chunk_count; c++) {
+        const Chunk* chunk = a->chunk_list[c];
+        const Chunk* other = get_chunk_at(b, chunk->cx, chunk->cy);
+        if (other == NULL || other->channel_count != chunk->channel_count) return 0;
+        
+        for (int k = 0; k < chunk->channel_count; k++) {
+            const PheromoneChannel* channel = chunk->channels[k];
+            const PheromoneChannel* match = get_pheromone_channel(other, channel->colony);
+            if (match == NULL) return 0;
+            copy_pheromone_levels(a, channel, g_check_levels[0], g_check_levels[1]);
+            copy_pheromone_levels(b, match, g_check_levels[2], g_check_levels[3]);
+            if (memcmp(g_check_levels[0], g_check_levels[2], 2 * sizeof(g_check_levels[0])) != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+// Fused update self-check, float builds with per-tick evaporation only
+#if !PHEROMONE_LAZY_EVAPORATION && !PHEROMONE_FIXED_POINT
+#define FUSED_CHECK_WIDTH 300          // No multiple of a chunk edge, so edge chunks are partial
+#define FUSED_CHECK_HEIGHT 190
+#define FUSED_CHECK_TICKS 400
+#define FUSED_CHECK_DEPOSIT_TICKS 150  // Then the trails fade and their chunks are released
+#define FUSED_CHECK_DEPOSITS 24
+#define FUSED_CHECK_WALLS 300
+
+// Runs one world through evaporate_pheromones and diffuse_pheromones and
+// a copy through update_pheromones, with the same walls and deposits, and
+// compares them after every tick. Returns the ticks that differ.
+static int check_fused_update(int toroidal) {
+    World* split = create_world(FUSED_CHECK_WIDTH, FUSED_CHECK_HEIGHT, 2);
+    World* fused = create_world(FUSED_CHECK_WIDTH, FUSED_CHECK_HEIGHT, 2);
+    if (split == NULL || fused == NULL) {
+        destroy_world(split);
+        destroy_world(fused);
+        return 1;
+    }
+    World* worlds[2] = { split, fused };
     
-    if (temp_food == NULL || temp_home == NULL) {
-        // Clean up and return if allocation failed
-        if (temp_food) safe_free(temp_food);
-        if (temp_home) safe_free(temp_home);
-        return;
+    for (int w = 0; w < 2; w++) {
+        worlds[w]->private_trails = 1;
+        set_world_toroidal(worlds[w], toroidal);
+    }
+    // Walls in the left third only, so chunks elsewhere can be released
+    for (int i = 0; i < FUSED_CHECK_WALLS; i++) {
+        int x = random_int(0, FUSED_CHECK_WIDTH / 3);
+        int y = random_int(0, FUSED_CHECK_HEIGHT - 1);
+        if (!is_walkable(split, x, y)) continue;
+        place_obstacle(split, x, y);
+        place_obstacle(fused, x, y);
     }
     
-    // Allocate rows
-    for (int i = 0; i < world->height; i++) {
-        temp_food[i] = (float*)safe_calloc(world->width, sizeof(float));
-        temp_home[i] = (float*)safe_calloc(world->width, sizeof(float));
+    int mismatches = 0;
+    for (int tick = 0; tick < FUSED_CHECK_TICKS; tick++) {
+        // Deposits anywhere, the world's edges included
+        for (int i = 0; tick < FUSED_CHECK_DEPOSIT_TICKS && i < FUSED_CHECK_DEPOSITS; i++) {
+            int x = random_int(0, FUSED_CHECK_WIDTH - 1);
+            int y = random_int(0, FUSED_CHECK_HEIGHT - 1);
+            int colony = random_int(0, 1);
+            int type = random_int(PHEROMONE_TYPE_FOOD, PHEROMONE_TYPE_HOME);
+            float amount = random_float(0.0f, PHEROMONE_DEPOSIT_AMOUNT);
+            deposit_pheromone_at_position(split, x, y, colony, type, amount);
+            deposit_pheromone_at_position(fused, x, y, colony, type, amount);
+        }
         
-        if (temp_food[i] == NULL || temp_home[i] == NULL) {
-            // Clean up THIS row if partially allocated
-            if (temp_food[i]) {
-                safe_free(temp_food[i]);
-                temp_food[i] = NULL;
-            }
-            if (temp_home[i]) {
-                safe_free(temp_home[i]);
-                temp_home[i] = NULL;
-            }
-            
-            // Clean up all previous rows
-            for (int j = 0; j < i; j++) {
-                if (temp_food[j]) safe_free(temp_food[j]);
-                if (temp_home[j]) safe_free(temp_home[j]);
-            }
-            
-            // Free the arrays themselves
-            safe_free(temp_food);
-            safe_free(temp_home);
-            return;
+        evaporate_pheromones(split);
+        diffuse_pheromones(split);
+        update_pheromones(fused);
+        flush_pheromone_block(fused);
+        for (int w = 0; w < 2; w++) {
+            release_idle_chunks(worlds[w]);
+            worlds[w]->current_step++;
+        }
+        
+        if (!same_pheromone_planes(split, fused)) mismatches++;
+    }
+    
+    printf("%-9s %s (%d ticks, %d chunks left)\n", toroidal ? "toroidal" : "bounded",
+           mismatches ? "MISMATCH" : "fused update identical to two passes",
+           FUSED_CHECK_TICKS, fused->chunk_count);
+    destroy_world(split);
+    destroy_world(fused);
+    return mismatches;
+}
+#endif
+
+int check_fused_pheromone_update(void) {
+#if PHEROMONE_LAZY_EVAPORATION
+    printf("Lazy evaporation build: no per-tick update to compare\n");
+    return 0;
+#elif PHEROMONE_FIXED_POINT
+    // The separate passes pack the planes in between, one rounding more
+    printf("Fixed-point build: the two paths round differently, nothing to compare\n");
+    return 0;
+#else
+    // The implicit update evaporates after its solve, so the explicit one
+    // is checked
+    int implicit_dt = get_pheromone_implicit_dt();
+    set_pheromone_implicit_dt(0);
+    int mismatches = check_fused_update(0) + check_fused_update(1);
+    set_pheromone_implicit_dt(implicit_dt);
+    return mismatches;
+#endif
+}
+
+// Deferred deposit self-check
+#define DEPOSIT_CHECK_WIDTH 300
+#define DEPOSIT_CHECK_HEIGHT 190
+#define DEPOSIT_CHECK_COLONIES 3
+#define DEPOSIT_CHECK_TICKS 60
+#define DEPOSIT_CHECK_DEPOSITS 6000   // Per tick
+#define DEPOSIT_CHECK_HOT_CELLS 400   // Half the deposits land on these, so cells get several
+
+static const int g_check_band_counts[] = { 1, 2, 3, 4, 7, MAX_WORKER_THREADS };
+#define DEPOSIT_CHECK_SPLITS ((int)(sizeof(g_check_band_counts) / sizeof(g_check_band_counts[0])))
+
+typedef struct CheckDeposit {
+    int x;
+    int y;
+    int colony;
+    int type;
+    float amount;
+} CheckDeposit;
+
+// Queues deposits into band_count bands, filled in shuffled band order,
+// and merges them
+static void merge_check_deposits(World* world, const CheckDeposit* deposits, int count, int band_count) {
+    int order[MAX_WORKER_THREADS];
+    for (int b = 0; b < band_count; b++) {
+        order[b] = b;
+    }
+    for (int b = band_count - 1; b > 0; b--) {
+        int other = random_int(0, b);
+        int band = order[b];
+        order[b] = order[other];
+        order[other] = band;
+    }
+    
+    for (int b = 0; b < band_count; b++) {
+        int band = order[b];
+        int first = (int)((long long)count * band / band_count);
+        int last = (int)((long long)count * (band + 1) / band_count);
+        for (int i = first; i < last; i++) {
+            const CheckDeposit* deposit = &deposits[i];
+            record_deposit(world, band, deposit->x, deposit->y, deposit->colony, deposit->type, deposit->amount);
         }
     }
+    merge_pheromone_deposits(world);
+}
+
+// Merges the same deposits split into 1 to MAX_WORKER_THREADS bands, and
+// compares each world after every tick with one where each cell's
+// deposits were summed in serial order and added once. Returns the ticks
+// that differ.
+static int check_deposit_bands(int private_trails) {
+    World* serial = create_world(DEPOSIT_CHECK_WIDTH, DEPOSIT_CHECK_HEIGHT, DEPOSIT_CHECK_COLONIES);
+    World* banded[DEPOSIT_CHECK_SPLITS];
+    int channels = private_trails ? DEPOSIT_CHECK_COLONIES : 1;
+    size_t cells = (size_t)DEPOSIT_CHECK_WIDTH * DEPOSIT_CHECK_HEIGHT;
+    float* sums = (float*)safe_calloc((size_t)channels * 2 * cells, sizeof(float));
+    CheckDeposit* deposits = (CheckDeposit*)safe_malloc(DEPOSIT_CHECK_DEPOSITS * sizeof(CheckDeposit));
+    Position hot[DEPOSIT_CHECK_HOT_CELLS];
+    int ready = (serial != NULL && sums != NULL && deposits != NULL);
+    for (int n = 0; n < DEPOSIT_CHECK_SPLITS; n++) {
+        banded[n] = create_world(DEPOSIT_CHECK_WIDTH, DEPOSIT_CHECK_HEIGHT, DEPOSIT_CHECK_COLONIES);
+        if (banded[n] == NULL) ready = 0;
+    }
     
-    // Copy current pheromone levels to temp grid
-    for (int y = 0; y < world->height; y++) {
-        for (int x = 0; x < world->width; x++) {
-            temp_food[y][x] = world->grid[y][x].pheromone_food;
-            temp_home[y][x] = world->grid[y][x].pheromone_home;
+    int mismatches[DEPOSIT_CHECK_SPLITS] = {0};
+    int total_mismatches = ready ? 0 : 1;
+    if (ready) {
+        serial->private_trails = private_trails;
+        for (int n = 0; n < DEPOSIT_CHECK_SPLITS; n++) {
+            banded[n]->private_trails = private_trails;
+        }
+        for (int i = 0; i < DEPOSIT_CHECK_HOT_CELLS; i++) {
+            hot[i].x = random_int(0, DEPOSIT_CHECK_WIDTH - 1);
+            hot[i].y = random_int(0, DEPOSIT_CHECK_HEIGHT - 1);
         }
+        discard_pheromone_deposits();
     }
     
-    // Apply diffusion
-    for (int y = 0; y < world->height; y++) {
-        for (int x = 0; x < world->width; x++) {
-            float neighbor_food_contribution = 0.0f;
-            float neighbor_home_contribution = 0.0f;
-            int valid_neighbors = 0;
-            
-            // Check all 8 neighbors
-            for (int dy = -1; dy <= 1; dy++) {
-                for (int dx = -1; dx <= 1; dx++) {
-                    if (dx == 0 && dy == 0) continue; // Skip center
-                    
-                    int nx = x + dx;
-                    int ny = y + dy;
-                    
-                    if (is_valid_position(world, nx, ny)) {
-                        neighbor_food_contribution += temp_food[ny][nx];
-                        neighbor_home_contribution += temp_home[ny][nx];
-                        valid_neighbors++;
-                    }
-                }
-            }
-            
-            // Apply proper diffusion: keep most original + small neighbor influence
-            if (valid_neighbors > 0) {
-                world->grid[y][x].pheromone_food = temp_food[y][x] * (1.0f - PHEROMONE_DIFFUSION_RATE) + 
-                                                   (neighbor_food_contribution * PHEROMONE_DIFFUSION_RATE) / valid_neighbors;
-                world->grid[y][x].pheromone_home = temp_home[y][x] * (1.0f - PHEROMONE_DIFFUSION_RATE) + 
-                                                   (neighbor_home_contribution * PHEROMONE_DIFFUSION_RATE) / valid_neighbors;
+    for (int tick = 0; ready && tick < DEPOSIT_CHECK_TICKS; tick++) {
+        for (int i = 0; i < DEPOSIT_CHECK_DEPOSITS; i++) {
+            CheckDeposit* deposit = &deposits[i];
+            if (random_int(0, 1)) {
+                const Position* cell = &hot[random_int(0, DEPOSIT_CHECK_HOT_CELLS - 1)];
+                deposit->x = cell->x;
+                deposit->y = cell->y;
             } else {
-                // No neighbors, just keep original values
-                world->grid[y][x].pheromone_food = temp_food[y][x];
-                world->grid[y][x].pheromone_home = temp_home[y][x];
+                deposit->x = random_int(0, DEPOSIT_CHECK_WIDTH - 1);
+                deposit->y = random_int(0, DEPOSIT_CHECK_HEIGHT - 1);
             }
+            deposit->colony = random_int(0, DEPOSIT_CHECK_COLONIES - 1);
+            deposit->type = random_int(PHEROMONE_TYPE_FOOD, PHEROMONE_TYPE_HOME);
+            deposit->amount = random_float(0.0f, PHEROMONE_DEPOSIT_AMOUNT);
+        }
+        
+        // Serial reference: each cell's amounts summed in deposit order
+        for (int i = 0; i < DEPOSIT_CHECK_DEPOSITS; i++) {
+            const CheckDeposit* deposit = &deposits[i];
+            int channel = private_trails ? deposit->colony : 0;
+            sums[((size_t)channel * 2 + deposit->type) * cells + (size_t)deposit->y * DEPOSIT_CHECK_WIDTH + deposit->x] +=
+                deposit->amount;
+        }
+        for (size_t i = 0; i < (size_t)channels * 2 * cells; i++) {
+            if (sums[i] == 0.0f) continue;
+            int cell = (int)(i % cells);
+            int type = (int)(i / cells % 2);
+            int channel = (int)(i / cells / 2);
+            apply_deposit(serial, cell % DEPOSIT_CHECK_WIDTH, cell / DEPOSIT_CHECK_WIDTH, channel, type, sums[i]);
+            sums[i] = 0.0f;
+        }
+        
+        for (int n = 0; n < DEPOSIT_CHECK_SPLITS; n++) {
+            merge_check_deposits(banded[n], deposits, DEPOSIT_CHECK_DEPOSITS, g_check_band_counts[n]);
+        }
+        
+        for (int n = -1; n < DEPOSIT_CHECK_SPLITS; n++) {
+            World* world = (n < 0) ? serial : banded[n];
+            update_pheromones(world);
+            flush_pheromone_block(world);
+            release_idle_chunks(world);
+            world->current_step++;
+        }
+        for (int n = 0; n < DEPOSIT_CHECK_SPLITS; n++) {
+            if (!same_pheromone_planes(serial, banded[n])) mismatches[n]++;
         }
     }
     
-    // Clean up temporary arrays
-    for (int i = 0; i < world->height; i++) {
-        safe_free(temp_food[i]);
-        safe_free(temp_home[i]);
+    if (ready) {
+        printf("%-8s trails:", private_trails ? "private" : "shared");
+        for (int n = 0; n < DEPOSIT_CHECK_SPLITS; n++) {
+            printf(" %d%s", g_check_band_counts[n], mismatches[n] ? " MISMATCH" : "");
+            total_mismatches += mismatches[n];
+        }
+        printf(" bands %s (%d ticks)\n",
+               total_mismatches ? "differ from serial deposits" : "identical to serial deposits",
+               DEPOSIT_CHECK_TICKS);
+    }
+    destroy_world(serial);
+    for (int n = 0; n < DEPOSIT_CHECK_SPLITS; n++) {
+        destroy_world(banded[n]);
     }
-    safe_free(temp_food);
-    safe_free(temp_home);
+    safe_free(sums);
+    safe_free(deposits);
+    return total_mismatches;
 }
 
-// Pheromone queries
-float get_pheromone_intensity(const World* world, int x, int y, int type) {
-    if (!is_valid_position(world, x, y)) return 0.0f;
-    
-    Cell* cell = &world->grid[y][x];
+int check_deferred_deposits(void) {
+    return check_deposit_bands(0) + check_deposit_bands(1);
+}
+
+// Level of one channel at plane index i, 0 without the channel
+static float channel_level(const World* world, const PheromoneChannel* channel, int type, int i) {
+#if !PHEROMONE_LAZY_EVAPORATION
+    (void)world;  // Stored levels are current
+#endif
+    if (channel == NULL) return 0.0f;
     
     switch (type) {
         case PHEROMONE_TYPE_FOOD:
-            return cell->pheromone_food;
+            return PHEROMONE_LEVEL(world, channel, channel->pheromone_food, i);
         case PHEROMONE_TYPE_HOME:
-            return cell->pheromone_home;
+            return PHEROMONE_LEVEL(world, channel, channel->pheromone_home, i);
         default:
             return 0.0f;
     }
 }
 
+// Pheromone queries. The intensity of a cell is the total over every
+// colony's trail.
+float get_pheromone_intensity(const World* world, int x, int y, int type) {
+    Chunk* chunk = get_chunk(world, x, y);
+    if (chunk == NULL) return 0.0f;
+    
+    int local = CHUNK_LOCAL(x, y);
+    float total = 0.0f;
+    for (int k = 0; k < chunk->channel_count; k++) {
+        total += channel_level(world, chunk->channels[k], type, local);
+    }
+    return total;
+}
+
+// The trail one colony follows: its own with private trails, else the
+// shared one
+float get_colony_pheromone_intensity(const World* world, int x, int y, int colony, int type) {
+    Chunk* chunk = get_chunk(world, x, y);
+    if (chunk == NULL) return 0.0f;
+    
+    const PheromoneChannel* channel = get_pheromone_channel(chunk, PHEROMONE_CHANNEL_COLONY(world, colony));
+    return channel_level(world, channel, type, CHUNK_LOCAL(x, y));
+}
+
+// Gradient field. For every cell of a channel it holds the direction of the
+// neighbour with the most pheromone of one type, over all 8 neighbours
+// (the first on ties, PHEROMONE_GRADIENT_NONE if none holds any). When
+// that neighbour is walkable it is also the strongest walkable one, so a
+// following ant needs one lookup. Fields are kept only while ticks are
+// blocked: the planes then stay put between updates, as deposits are held
+// back, so a field is exact until the next update. Per tick, every deposit
+// would have to patch the field, which costs about as much as the scan it
+// saves. A type's field is built for a channel once it is read often
+// enough between updates (pheromone_generation).
+void invalidate_pheromone_gradients(World* world) {
+    if (++world->pheromone_generation == 0) {
+        world->pheromone_generation = 1;  // 0 marks a field never built
+    }
+}
+
+#if !PHEROMONE_LAZY_EVAPORATION
+// Builds a type's field for the cells within one step of the channel's
+// pheromone box; the rest have no pheromone around them. Returns 0 if out
+// of memory.
+static int build_pheromone_gradient(PheromoneChannel* channel, int type) {
+    if (channel->gradient == NULL) {
+        channel->gradient = (uint8_t*)safe_malloc(2 * CHUNK_PADDED_CELLS);
+        if (channel->gradient == NULL) return 0;
+    }
+    uint8_t* field = channel->gradient + type * CHUNK_PADDED_CELLS;
+    const PheromoneValue* plane = (type == PHEROMONE_TYPE_FOOD) ? channel->pheromone_food : channel->pheromone_home;
+    const Chunk* chunk = channel->chunk;
+    memset(field, PHEROMONE_GRADIENT_NONE, CHUNK_PADDED_CELLS);
+    
+    const PheromoneBox* box = &channel->pheromone_box;
+    int x0 = (box->x0 > 1) ? box->x0 - 1 : 0;
+    int y0 = (box->y0 > 1) ? box->y0 - 1 : 0;
+    int x1 = (box->x1 < chunk->cols - 2) ? box->x1 + 1 : chunk->cols - 1;
+    int y1 = (box->y1 < chunk->rows - 2) ? box->y1 + 1 : chunk->rows - 1;
+    
+    // Direction by direction over a row, so the compare and select
+    // vectorize
+    PheromoneValue best[CHUNK_SIZE];
+    uint8_t direction[CHUNK_SIZE];
+    for (int ly = y0; ly <= y1; ly++) {
+        int count = x1 - x0 + 1;
+        int row = CHUNK_PAD_INDEX(x0, ly);
+        for (int i = 0; i < count; i++) {
+            best[i] = 0;
+            direction[i] = PHEROMONE_GRADIENT_NONE;
+        }
+        for (int dir = 0; dir < 8; dir++) {
+            const PheromoneValue* neighbor = plane + row + neighbor_offset[dir];
+            for (int i = 0; i < count; i++) {
+                if (neighbor[i] > best[i]) {
+                    best[i] = neighbor[i];
+                    direction[i] = (uint8_t)dir;
+                }
+            }
+        }
+        memcpy(field + row, direction, count);
+    }
+    
+    return 1;
+}
+
+#endif
+
+int get_pheromone_gradient(const World* world, PheromoneChannel* channel, int type, int local) {
+#if PHEROMONE_LAZY_EVAPORATION
+    // Each cell decays on its own schedule, so there is no field to keep
+    (void)world; (void)channel; (void)type; (void)local;
+    return PHEROMONE_GRADIENT_UNKNOWN;
+#else
+    if (channel == NULL || !is_blocking(world)) return PHEROMONE_GRADIENT_UNKNOWN;
+    if (type != PHEROMONE_TYPE_FOOD && type != PHEROMONE_TYPE_HOME) return PHEROMONE_GRADIENT_UNKNOWN;
+    const PheromoneBox* box = &channel->pheromone_box;
+    if (box->x0 > box->x1) return PHEROMONE_GRADIENT_NONE;
+    
+    if (channel->gradient_generation[type] != world->pheromone_generation) {
+        channel->gradient_generation[type] = world->pheromone_generation;
+        channel->gradient_reads[type] = 0;
+    }
+    
+    // Until the field has been read often enough to pay for building it,
+    // the caller scans the neighbours
+    int cells = (box->x1 - box->x0 + 1) * (box->y1 - box->y0 + 1);
+    if (channel->gradient_reads[type] >= 0 &&
+        ++channel->gradient_reads[type] > (cells >> PHEROMONE_GRADIENT_BUILD_SHIFT) &&
+        build_pheromone_gradient(channel, type)) {
+        channel->gradient_reads[type] = -1;
+    }
+    if (channel->gradient_reads[type] < 0) {
+        return channel->gradient[type * CHUNK_PADDED_CELLS + local];
+    }
+    return PHEROMONE_GRADIENT_UNKNOWN;
+#endif
+}
+
 float get_max_pheromone_neighbor(const World* world, int x, int y, int type) {
     if (!is_valid_position(world, x, y)) return 0.0f;
+    if (type != PHEROMONE_TYPE_FOOD && type != PHEROMONE_TYPE_HOME) return 0.0f;
     
     float max_pheromone = 0.0f;
     
+    // Fast path: the halo holds every neighbour, walls past the edge read 0
+    const Chunk* chunk = get_chunk(world, x, y);
+    if (chunk != NULL) {
+        int i = CHUNK_LOCAL(x, y);
+        if (chunk->channel_count == 1) {
+            // One channel: its strongest neighbour holds the maximum
+            PheromoneChannel* channel = chunk->channels[0];
+            int strongest = get_pheromone_gradient(world, channel, type, i);
+            if (strongest == PHEROMONE_GRADIENT_NONE) return 0.0f;
+            if (strongest != PHEROMONE_GRADIENT_UNKNOWN) {
+                return channel_level(world, channel, type, i + neighbor_offset[strongest]);
+            }
+        }
+        const int s = CHUNK_STRIDE;
+        const int around[8] = { -s - 1, -s, -s + 1, -1, 1, s - 1, s, s + 1 };
+        for (int n = 0; n < 8; n++) {
+            float pheromone = 0.0f;
+            for (int k = 0; k < chunk->channel_count; k++) {
+                pheromone += channel_level(world, chunk->channels[k], type, i + around[n]);
+            }
+            if (pheromone > max_pheromone) max_pheromone = pheromone;
+        }
+        return max_pheromone;
+    }
+    
     // Check 8 neighbors
     for (int dy = -1; dy <= 1; dy++) {
         for (int dx = -1; dx <= 1; dx++) {
@@ -203,7 +2814,7 @@ float get_max_pheromone_neighbor(const World* world, int x, int y, int type) {
             int nx = x + dx;
             int ny = y + dy;
             
-            if (is_valid_position(world, nx, ny)) {
+            if (wrap_position(world, &nx, &ny)) {
                 float pheromone = get_pheromone_intensity(world, nx, ny, type);
                 if (pheromone > max_pheromone) {
                     max_pheromone = pheromone;
@@ -215,57 +2826,343 @@ float get_max_pheromone_neighbor(const World* world, int x, int y, int type) {
     return max_pheromone;
 }
 
+// Wide pheromone sensing (set_pheromone_sense_radius). After each update
+// every channel holding pheromone gets a summed-area table per type over
+// the in-world cells of its box: entry (r, c) is the total of the box's
+// first r rows and c columns, so any rectangle of the chunk sums in four
+// reads whatever its size. A rectangle crossing chunk edges is summed per
+// chunk. The tables are a snapshot of the update; deposits made during the
+// next tick only show up after the one that follows it.
+static int g_sense_radius = PHEROMONE_SENSE_RADIUS_DEFAULT;
+
+int set_pheromone_sense_radius(int radius) {
+    g_sense_radius = clamp_int(radius, 1, PHEROMONE_SENSE_RADIUS_MAX);
+    return g_sense_radius;
+}
+
+int get_pheromone_sense_radius(void) {
+    return g_sense_radius;
+}
+
+// Table entry of cell i of a plane, and the level of a table sum
+#if PHEROMONE_FIXED_POINT
+#define PHEROMONE_SUM_ENTRY(world, channel, plane, i) ((PheromoneSum)(plane)[i])
+#define PHEROMONE_SUM_LEVEL(sum) ((float)(sum) * (1.0f / PHEROMONE_FIXED_SCALE))
+#else
+#define PHEROMONE_SUM_ENTRY(world, channel, plane, i) ((PheromoneSum)PHEROMONE_LEVEL((world), (channel), (plane), (i)))
+#define PHEROMONE_SUM_LEVEL(sum) ((float)(sum))
+#endif
+
+// Fills both tables of one channel, whose table memory is allocated
+static void build_sum_tables(const World* world, PheromoneChannel* channel) {
+#if !PHEROMONE_LAZY_EVAPORATION
+    (void)world;  // Stored levels are current
+#endif
+    TileRect cells;
+    if (!box_cells(channel, &cells)) {
+        clear_pheromone_box(&channel->sum_box);
+        return;
+    }
+    int cols = cells.x1 - cells.x0 + 1;
+    int rows = cells.y1 - cells.y0 + 1;
+    
+    for (int type = PHEROMONE_TYPE_FOOD; type <= PHEROMONE_TYPE_HOME; type++) {
+        const PheromoneValue* plane = (type == PHEROMONE_TYPE_FOOD) ? channel->pheromone_food : channel->pheromone_home;
+        PheromoneSum* table = channel->sum_table + type * PHEROMONE_SUM_CELLS;
+        PheromoneSum row[CHUNK_SIZE + 1];
+        row[0] = 0;
+        for (int c = 0; c <= cols; c++) table[c] = 0;
+        
+        for (int r = 0; r < rows; r++) {
+            // The running total along the row is serial; adding the row
+            // above to it is not, and vectorizes
+            int start = CHUNK_PAD_INDEX(cells.x0, cells.y0 + r);
+            PheromoneSum run = 0;
+            for (int c = 0; c < cols; c++) {
+                run += PHEROMONE_SUM_ENTRY(world, channel, plane, start + c);
+                row[c + 1] = run;
+            }
+            const PheromoneSum* above = table + r * PHEROMONE_SUM_STRIDE;
+            PheromoneSum* out = table + (r + 1) * PHEROMONE_SUM_STRIDE;
+            for (int c = 0; c <= cols; c++) {
+                out[c] = above[c] + row[c];
+            }
+        }
+    }
+    
+    channel->sum_box.x0 = (int16_t)cells.x0;
+    channel->sum_box.y0 = (int16_t)cells.y0;
+    channel->sum_box.x1 = (int16_t)cells.x1;
+    channel->sum_box.y1 = (int16_t)cells.y1;
+}
+
+static void sum_table_band(void* context, int band, int band_count) {
+    PheromonePass* pass = (PheromonePass*)context;
+    int first, last;
+    band_range(pass, band, band_count, &first, &last);
+    
+    for (int i = first; i < last; i++) {
+        PheromoneChannel* channel = pass->channels[i];
+        if (channel->sum_table == NULL) continue;
+        build_sum_tables(pass->world, channel);
+        channel->sum_generation = pass->world->pheromone_sum_generation;
+    }
+}
+
+void build_pheromone_sum_tables(World* world) {
+    if (world == NULL || g_sense_radius <= 1) return;
+#if !PHEROMONE_LAZY_EVAPORATION
+    // Blocked ticks that did not run the block left the planes as they were
+    // (lazy levels decay every tick without any write)
+    if (world->pheromone_sum_generation == world->pheromone_generation) return;
+#endif
+    
+    // Channels left out (idle, or out of memory) keep an older generation
+    // and read as empty
+    PheromonePass pass;
+    world->pheromone_sum_generation = world->pheromone_generation;
+    if (!collect_pass_channels(world, 0, 0, &pass)) return;
+    
+    // Tables are allocated here, off the workers
+    for (int i = 0; i < pass.count; i++) {
+        PheromoneChannel* channel = pass.channels[i];
+        if (channel->sum_table == NULL) {
+            channel->sum_table = (PheromoneSum*)safe_malloc(2 * PHEROMONE_SUM_CELLS * sizeof(PheromoneSum));
+        }
+    }
+    run_pass(sum_table_band, &pass);
+}
+
+// Total of one type over local cells lx0..lx1, ly0..ly1 of a channel's table
+static PheromoneSum table_rect_sum(const PheromoneChannel* channel, int type, int lx0, int ly0, int lx1, int ly1) {
+    const PheromoneBox* box = &channel->sum_box;
+    if (lx0 < box->x0) lx0 = box->x0;
+    if (ly0 < box->y0) ly0 = box->y0;
+    if (lx1 > box->x1) lx1 = box->x1;
+    if (ly1 > box->y1) ly1 = box->y1;
+    if (lx0 > lx1 || ly0 > ly1) return 0;
+    
+    const PheromoneSum* table = channel->sum_table + type * PHEROMONE_SUM_CELLS;
+    int c0 = lx0 - box->x0;
+    int c1 = lx1 - box->x0 + 1;
+    int r0 = (ly0 - box->y0) * PHEROMONE_SUM_STRIDE;
+    int r1 = (ly1 - box->y0 + 1) * PHEROMONE_SUM_STRIDE;
+    return table[r1 + c1] - table[r0 + c1] - table[r1 + c0] + table[r0 + c0];
+}
+
+// Local cells of a run that fall in the square's cells first..last along
+// its axis. Returns 0 if none.
+static int clip_run(const SpanRun* run, int first, int last, int* local0, int* local1) {
+    if (first < run->start) first = run->start;
+    if (last > run->start + run->length - 1) last = run->start + run->length - 1;
+    if (first > last) return 0;
+    *local0 = run->local + first - run->start;
+    *local1 = run->local + last - run->start;
+    return 1;
+}
+
+void get_pheromone_sectors(const World* world, int x, int y, int colony, int type, float sums[8]) {
+    for (int dir = 0; dir < 8; dir++) sums[dir] = 0.0f;
+    if (world == NULL || !is_valid_position(world, x, y)) return;
+    if (type != PHEROMONE_TYPE_FOOD && type != PHEROMONE_TYPE_HOME) return;
+    
+    // Each axis of the square splits into a band of 2 * near + 1 cells
+    // through the ant and the rest on either side, counted from the
+    // square's corner; at radius 1 every sector is one neighbour
+    int radius = g_sense_radius;
+    int near = radius / 3;
+    const int low[3] = { 0, radius - near, radius + near + 1 };
+    const int high[3] = { radius - near - 1, radius + near, 2 * radius };
+    
+    // The square is cut by chunk once (wrapping in a toroidal world, cells
+    // past a bounded world's edge hold none), and each sector summed over
+    // the chunks it overlaps
+    SpanRun columns[2 * PHEROMONE_SENSE_RADIUS_MAX + 1];
+    SpanRun rows[2 * PHEROMONE_SENSE_RADIUS_MAX + 1];
+    int column_count = split_span(x - radius, 2 * radius + 1, world->width, world->toroidal, columns);
+    int row_count = split_span(y - radius, 2 * radius + 1, world->height, world->toroidal, rows);
+    colony = PHEROMONE_CHANNEL_COLONY(world, colony);
+    
+    PheromoneSum totals[8] = { 0 };
+    for (int r = 0; r < row_count; r++) {
+        const SpanRun* row = &rows[r];
+        if (row->chunk < 0) continue;
+        for (int c = 0; c < column_count; c++) {
+            const SpanRun* column = &columns[c];
+            if (column->chunk < 0) continue;
+            const Chunk* chunk = get_chunk_at(world, column->chunk, row->chunk);
+            const PheromoneChannel* channel = (chunk != NULL) ? get_pheromone_channel(chunk, colony) : NULL;
+            if (channel == NULL || channel->sum_table == NULL ||
+                channel->sum_generation != world->pheromone_sum_generation) {
+                continue;
+            }
+            for (int dir = 0; dir < 8; dir++) {
+                int lx0, lx1, ly0, ly1;
+                if (!clip_run(column, low[dx[dir] + 1], high[dx[dir] + 1], &lx0, &lx1) ||
+                    !clip_run(row, low[dy[dir] + 1], high[dy[dir] + 1], &ly0, &ly1)) {
+                    continue;
+                }
+                totals[dir] += table_rect_sum(channel, type, lx0, ly0, lx1, ly1);
+            }
+        }
+    }
+    for (int dir = 0; dir < 8; dir++) {
+        sums[dir] = PHEROMONE_SUM_LEVEL(totals[dir]);
+    }
+}
+
 // Pheromone utilities
 void reset_pheromones(World* world) {
     if (world == NULL) return;
     
-    for (int y = 0; y < world->height; y++) {
-        for (int x = 0; x < world->width; x++) {
-            world->grid[y][x].pheromone_food = PHEROMONE_INITIAL;
-            world->grid[y][x].pheromone_home = PHEROMONE_INITIAL;
+    // Deposits still owed would only be cleared again
+    world->pheromone_block_ticks = 0;
+    clear_block_deposits(world);
+    discard_pheromone_deposits();
+    invalidate_pheromone_gradients(world);
+    
+    for (int c = 0; c < world->chunk_count; c++) {
+        Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            PheromoneChannel* channel = chunk->channels[k];
+            for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+                channel->pheromone_food[i] = PHEROMONE_INITIAL;
+                channel->pheromone_home[i] = PHEROMONE_INITIAL;
+            }
+            channel->pheromone_active = 0;
+            clear_pheromone_box(&channel->pheromone_box);
         }
     }
     
     print_info("All pheromones reset");
 }
 
-void normalize_pheromones(World* world) {
-    if (world == NULL) return;
-    
-    float max_food = 0.0f;
-    float max_home = 0.0f;
+// Statistics of the in-world cells of one channel's front planes
+static void reduce_channel(const World* world, const PheromoneChannel* channel, PheromoneFieldStats stats[2]) {
+#if !PHEROMONE_LAZY_EVAPORATION
+    (void)world;  // Stored levels are current
+#endif
+    TileRect cells;
+    if (!box_cells(channel, &cells)) return;
     
-    // Find maximum values
-    for (int y = 0; y < world->height; y++) {
-        for (int x = 0; x < world->width; x++) {
-            if (world->grid[y][x].pheromone_food > max_food) {
-                max_food = world->grid[y][x].pheromone_food;
-            }
-            if (world->grid[y][x].pheromone_home > max_home) {
-                max_home = world->grid[y][x].pheromone_home;
+    const PheromoneKernels* kernels = get_pheromone_kernels();
+    int x0 = reduced_column(cells.x0);
+    int count = cells.x1 - x0 + 1;
+    for (int type = PHEROMONE_TYPE_FOOD; type <= PHEROMONE_TYPE_HOME; type++) {
+        const PheromoneValue* plane = (type == PHEROMONE_TYPE_FOOD) ? channel->pheromone_food : channel->pheromone_home;
+        PheromoneReduction reduction;
+        memset(&reduction, 0, sizeof(reduction));
+        for (int ly = cells.y0; ly <= cells.y1; ly++) {
+            int start = CHUNK_PAD_INDEX(x0, ly);
+#if PHEROMONE_LAZY_EVAPORATION
+            float levels[CHUNK_SIZE];
+            for (int x = 0; x < count; x++) {
+                levels[x] = PHEROMONE_LEVEL(world, channel, plane, start + x);
             }
+#elif PHEROMONE_FIXED_POINT
+            float levels[CHUNK_SIZE];
+            kernels->unpack_row(plane + start, levels, count);
+#else
+            const float* levels = plane + start;
+#endif
+            kernels->reduce_row(levels, count, &reduction);
         }
+        add_pheromone_reduction(&reduction, &stats[type]);
+    }
+}
+
+static void reduce_band(void* context, int band, int band_count) {
+    PheromonePass* pass = (PheromonePass*)context;
+    int first, last;
+    band_range(pass, band, band_count, &first, &last);
+    
+    for (int i = first; i < last; i++) {
+        reduce_channel(pass->world, pass->channels[i], g_channel_stats[i]);
+    }
+}
+
+void reduce_pheromones(World* world, PheromoneStats* stats) {
+    if (world == NULL || stats == NULL) return;
+    
+    // Channels without pheromone are all zero and add nothing
+    PheromonePass pass;
+    get_pheromone_kernels();  // Picked here, before any worker asks
+    if (collect_pass_channels(world, 0, 0, &pass) && reserve_channel_stats(pass.count)) {
+        run_pass(reduce_band, &pass);
+    } else {
+        pass.count = 0;
+    }
+    sum_channel_stats(world, pass.count, stats);
+}
+
+void update_pheromone_stats(World* world) {
+    if (world == NULL) return;
+#if !PHEROMONE_LAZY_EVAPORATION
+    // Published by the update that wrote the planes, or by a blocked tick
+    // that left them as they were
+    if (world->pheromone_stats.generation == world->pheromone_generation) {
+        world->pheromone_stats.step = world->current_step;
+        return;
     }
+#endif
+    reduce_pheromones(world, &world->pheromone_stats);
+}
+
+float get_pheromone_coverage(const PheromoneStats* stats, int type) {
+    if (stats == NULL || stats->cells <= 0) return 0.0f;
+    return (float)(100.0 * stats->types[type].nonzero_cells / stats->cells);
+}
+
+// Scale of each type in the normalize pass, 0 to leave it alone
+static float g_normalize_max[2];
+
+static void normalize_band(void* context, int band, int band_count) {
+    PheromonePass* pass = (PheromonePass*)context;
+    int first, last;
+    band_range(pass, band, band_count, &first, &last);
     
-    // Normalize if maximum is greater than 0
-    if (max_food > 0.0f) {
-        for (int y = 0; y < world->height; y++) {
-            for (int x = 0; x < world->width; x++) {
-                world->grid[y][x].pheromone_food = 
-                    (world->grid[y][x].pheromone_food / max_food) * PHEROMONE_MAX;
+    // Halo cells only repeat values held by some chunk, and scaling them
+    // with the rest keeps them in sync
+    for (int i = first; i < last; i++) {
+        PheromoneChannel* channel = pass->channels[i];
+        for (int type = PHEROMONE_TYPE_FOOD; type <= PHEROMONE_TYPE_HOME; type++) {
+            float max = g_normalize_max[type];
+            if (max <= 0.0f) continue;
+            PheromoneValue* plane = (type == PHEROMONE_TYPE_FOOD) ? channel->pheromone_food : channel->pheromone_home;
+            for (int c = 0; c < CHUNK_PADDED_CELLS; c++) {
+                plane[c] = PHEROMONE_PACK((PHEROMONE_UNPACK(plane[c]) / max) * PHEROMONE_MAX);
             }
         }
     }
+}
+
+void normalize_pheromones(World* world) {
+    if (world == NULL) return;
     
-    if (max_home > 0.0f) {
-        for (int y = 0; y < world->height; y++) {
-            for (int x = 0; x < world->width; x++) {
-                world->grid[y][x].pheromone_home = 
-                    (world->grid[y][x].pheromone_home / max_home) * PHEROMONE_MAX;
-            }
+    flush_pheromone_block(world);
+    invalidate_pheromone_gradients(world);
+
+#if PHEROMONE_LAZY_EVAPORATION
+    // Scale the current levels, not the ones last written
+    for (int c = 0; c < world->chunk_count; c++) {
+        Chunk* chunk = world->chunk_list[c];
+        for (int k = 0; k < chunk->channel_count; k++) {
+            settle_pheromones(world, chunk->channels[k]);
         }
     }
+#endif
+    
+    // One reduction for the maximum of both types, then one scaling pass
+    PheromoneStats stats;
+    PheromonePass pass;
+    reduce_pheromones(world, &stats);
+    g_normalize_max[PHEROMONE_TYPE_FOOD] = stats.types[PHEROMONE_TYPE_FOOD].max;
+    g_normalize_max[PHEROMONE_TYPE_HOME] = stats.types[PHEROMONE_TYPE_HOME].max;
+    if (collect_pass_channels(world, 0, 0, &pass)) {
+        run_pass(normalize_band, &pass);
+    }
     
+    update_pheromone_stats(world);
     print_info("Pheromones normalized");
 }
 
@@ -1,25 +1,127 @@
 #ifndef PHEROMONES_H
 #define PHEROMONES_H
 
+#include "config.h"
 #include "data_structures.h"
+#include "world.h"
+
+// Channel that holds colony's pheromone: its own with private trails,
+// otherwise the shared one
+#define PHEROMONE_CHANNEL_COLONY(world, colony) ((world)->private_trails ? (colony) : PHEROMONE_SHARED)
 
 // Pheromone deposit and evaporation
 void deposit_pheromone(World* world, Ant* ant);
-void deposit_pheromone_at_position(World* world, int x, int y, int type, float amount);
+void deposit_pheromone_at_position(World* world, int x, int y, int colony, int type, float amount);
+void update_pheromones(World* world);    // Evaporate and diffuse in one pass
 void evaporate_pheromones(World* world);
 void diffuse_pheromones(World* world);
+// Runs the explicit update_pheromones against evaporate_pheromones and
+// diffuse_pheromones on a bounded and a toroidal world (--check-fused).
+// Float builds only. Returns the mismatches.
+int check_fused_pheromone_update(void);
+
+// Blocked pheromone update (--pheromone-block), off by default. With
+// ticks > 1, update_pheromones advances the planes every that many ticks,
+// that many ticks at once, applying the ants' deposits at the tick they
+// were made; the planes come out as the per-tick update leaves them, but in
+// between ants follow the trails as of the last block. Lazy evaporation
+// builds always use 1. Returns the count in use.
+int set_pheromone_block_ticks(int ticks);
+int get_pheromone_block_ticks(void);
+void flush_pheromone_block(World* world);  // Runs the ticks still owed now
+
+// Implicit pheromone diffusion (--pheromone-implicit), off by default. With
+// dt > 0, update_pheromones and diffuse_pheromones spread pheromone as far
+// as dt explicit ticks would, in one alternating-direction implicit step
+// that is stable for any dt; walls pass no pheromone. Update still
+// evaporates once. Turns off blocking and is turned off by it; lazy
+// evaporation builds always use 0. Returns the dt in use.
+int set_pheromone_implicit_dt(int dt);
+int get_pheromone_implicit_dt(void);
+
+// Walkable-only diffusion (--pheromone-walkable), off by default. When on,
+// the per-tick update diffuses between walkable cells only, with each
+// chunk's runs of walkable cells and neighbour weights kept until its
+// terrain changes; walls hold no pheromone and deposits on them are
+// dropped. Implicit updates, which stop at walls already, take precedence.
+// Turns off blocking and is turned off by it; lazy evaporation builds
+// always use 0. Returns the setting in use.
+int set_pheromone_walkable_only(int enabled);
+int get_pheromone_walkable_only(void);
+
+// Deferred deposits (--pheromone-deferred), off by default. When on,
+// deposit_pheromone only records the deposit, in the buffer of band 0;
+// merge_pheromone_deposits, run after the ant update, adds each cell's
+// recorded amounts up and to the planes at once, clamping once. An ant
+// update split into bands records through queue_pheromone_deposit with its
+// band, which touches nothing shared; band b must hold the b-th slice of
+// the ants in serial order for the result to match any other split.
+// Ants do not see this tick's deposits. Returns the setting in use.
+int set_pheromone_deferred_deposits(int enabled);
+int get_pheromone_deferred_deposits(void);
+void queue_pheromone_deposit(World* world, const Ant* ant, int band);
+void merge_pheromone_deposits(World* world);
+void discard_pheromone_deposits(void);    // Drops the queued deposits (reset, load, destroy)
+// Merges random deposits split into 1 to MAX_WORKER_THREADS bands, filled
+// in shuffled order, against serially summed ones (--check-deposits).
+// Returns the mismatches.
+int check_deferred_deposits(void);
+long long get_pheromone_traffic(void);     // Plane bytes the updates have read and written
+
+// Wide pheromone sensing (--sense-radius), radius 1 by default. Above 1,
+// build_pheromone_sum_tables keeps a summed-area table of every channel
+// holding pheromone, and following ants weigh 8 sectors of the square of
+// that radius instead of the 8 neighbours. Returns the radius in use.
+#define PHEROMONE_SUM_STRIDE (CHUNK_SIZE + 1)
+#define PHEROMONE_SUM_CELLS (PHEROMONE_SUM_STRIDE * PHEROMONE_SUM_STRIDE)
+int set_pheromone_sense_radius(int radius);
+int get_pheromone_sense_radius(void);
+void build_pheromone_sum_tables(World* world);  // After update_pheromones; nothing at radius 1
+// Pheromone of a type on colony's trail in the sector around (x, y) for
+// each direction (as dx / dy), as of the last table build
+void get_pheromone_sectors(const World* world, int x, int y, int colony, int type, float sums[8]);
 
 // Pheromone queries
-float get_pheromone_intensity(const World* world, int x, int y, int type);
+// Current level of cell i of a channel plane. Lazy evaporation builds apply
+// the evaporation owed since the cell was last written; elsewhere this
+// unpacks the stored value.
+#if PHEROMONE_LAZY_EVAPORATION
+#define PHEROMONE_LEVEL(world, channel, plane, i) lazy_pheromone_level((world), (channel), (plane), (i))
+float lazy_pheromone_level(const World* world, const PheromoneChannel* channel, const PheromoneValue* plane, int i);
+#else
+#define PHEROMONE_LEVEL(world, channel, plane, i) PHEROMONE_UNPACK((plane)[i])
+#endif
+void copy_pheromone_levels(const World* world, const PheromoneChannel* channel, float* food, float* home);
+void store_pheromone_levels(PheromoneChannel* channel, const float* food, const float* home);
+float get_pheromone_intensity(const World* world, int x, int y, int type);  // Sum of every channel
+float get_colony_pheromone_intensity(const World* world, int x, int y, int colony, int type);
 float get_max_pheromone_neighbor(const World* world, int x, int y, int type);
 
+// Direction (0-7, as dx / dy) of the neighbour of plane index local with the
+// most pheromone of a type in the channel, walkable or not; the first on
+// ties, PHEROMONE_GRADIENT_NONE if none holds any. Served from a per-channel
+// field while ticks are blocked; PHEROMONE_GRADIENT_UNKNOWN when there is
+// no field and the caller has to scan the neighbours itself.
+#define PHEROMONE_GRADIENT_NONE 8
+#define PHEROMONE_GRADIENT_UNKNOWN (-1)
+int get_pheromone_gradient(const World* world, PheromoneChannel* channel, int type, int local);
+void invalidate_pheromone_gradients(World* world);  // After writing planes other than by deposits
+
 // Pheromone type constants
 #define PHEROMONE_TYPE_FOOD 0
 #define PHEROMONE_TYPE_HOME 1
 
 // Pheromone utilities
 void reset_pheromones(World* world);
-void normalize_pheromones(World* world);
+void normalize_pheromones(World* world);  // Scales each type so its maximum is PHEROMONE_MAX
+
+// Field statistics: max, sum, coverage and a level histogram of both types
+// over every channel, in one vectorized pass split across the workers.
+// update_pheromone_stats publishes them in world->pheromone_stats once per
+// tick; blocked ticks that left the planes alone reuse the last result.
+void reduce_pheromones(World* world, PheromoneStats* stats);
+void update_pheromone_stats(World* world);
+float get_pheromone_coverage(const PheromoneStats* stats, int type);  // Percent of channel cells holding any
 float calculate_pheromone_strength(float base_strength, float distance);
 
 // Pheromone visualization helpers
@@ -0,0 +1,70 @@
+#include "profiler.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+
+// Accumulated time per section since the last reset
+static int g_profiler_enabled = 0;
+static uint64_t g_section_start_us[PROFILE_SECTION_COUNT];
+static uint64_t g_section_total_us[PROFILE_SECTION_COUNT];
+
+static const char* g_section_names[PROFILE_SECTION_COUNT] = {
+    "Ant update",
+    "Deposit merge",
+    "Pheromones",
+    "Sum tables",
+    "Ant index",
+    "Statistics",
+    "Food check"
+};
+
+// Profiler control
+void profiler_set_enabled(int enabled) {
+    g_profiler_enabled = enabled ? 1 : 0;
+}
+
+int profiler_is_enabled(void) {
+    return g_profiler_enabled;
+}
+
+void profiler_reset(void) {
+    memset(g_section_start_us, 0, sizeof(g_section_start_us));
+    memset(g_section_total_us, 0, sizeof(g_section_total_us));
+}
+
+// Section timing
+void profiler_begin(ProfileSection section) {
+    if (!g_profiler_enabled || section < 0 || section >= PROFILE_SECTION_COUNT) return;
+    g_section_start_us[section] = get_time_us();
+}
+
+void profiler_end(ProfileSection section) {
+    if (!g_profiler_enabled || section < 0 || section >= PROFILE_SECTION_COUNT) return;
+    g_section_total_us[section] += get_time_us() - g_section_start_us[section];
+}
+
+// Profiler queries
+uint64_t profiler_get_total_us(ProfileSection section) {
+    if (section < 0 || section >= PROFILE_SECTION_COUNT) return 0;
+    return g_section_total_us[section];
+}
+
+const char* profiler_section_name(ProfileSection section) {
+    if (section < 0 || section >= PROFILE_SECTION_COUNT) return "Unknown";
+    return g_section_names[section];
+}
+
+void profiler_print_report(int ticks) {
+    uint64_t total_us = 0;
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        total_us += g_section_total_us[i];
+    }
+    
+    printf("%-16s %12s %12s %8s\n", "Section", "Total ms", "ms/tick", "Share");
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+        double ms = g_section_total_us[i] / 1000.0;
+        double per_tick = (ticks > 0) ? ms / ticks : 0.0;
+        double share = (total_us > 0) ? 100.0 * g_section_total_us[i] / total_us : 0.0;
+        printf("%-16s %12.2f %12.3f %7.1f%%\n", g_section_names[i], ms, per_tick, share);
+    }
+}
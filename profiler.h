@@ -0,0 +1,32 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// Timed sections of one simulation tick
+typedef enum {
+    PROFILE_ANTS = 0,
+    PROFILE_DEPOSITS,
+    PROFILE_PHEROMONES,
+    PROFILE_SUM_TABLES,
+    PROFILE_ANT_INDEX,
+    PROFILE_STATISTICS,
+    PROFILE_FOOD_CHECK,
+    PROFILE_SECTION_COUNT
+} ProfileSection;
+
+// Profiler control
+void profiler_set_enabled(int enabled);
+int profiler_is_enabled(void);
+void profiler_reset(void);
+
+// Section timing (no-ops while the profiler is disabled)
+void profiler_begin(ProfileSection section);
+void profiler_end(ProfileSection section);
+
+// Profiler queries
+uint64_t profiler_get_total_us(ProfileSection section);
+const char* profiler_section_name(ProfileSection section);
+void profiler_print_report(int ticks);
+
+#endif // PROFILER_H
@@ -0,0 +1,40 @@
+#include "simulation.h"
+#include "ant_logic.h"
+#include "ant_index.h"
+#include "pheromones.h"
+#include "profiler.h"
+#include "world.h"
+
+void simulation_step(World* world) {
+    if (world == NULL) return;
+    
+    profiler_begin(PROFILE_ANTS);
+    update_all_ants(world);
+    profiler_end(PROFILE_ANTS);
+    
+    // Deposits the ants left in the deferred buffers, if any
+    profiler_begin(PROFILE_DEPOSITS);
+    merge_pheromone_deposits(world);
+    profiler_end(PROFILE_DEPOSITS);
+    
+    profiler_begin(PROFILE_PHEROMONES);
+    update_pheromones(world);
+    release_idle_chunks(world);
+    profiler_end(PROFILE_PHEROMONES);
+    
+    profiler_begin(PROFILE_SUM_TABLES);
+    build_pheromone_sum_tables(world);
+    profiler_end(PROFILE_SUM_TABLES);
+    
+    world->current_step++;
+    
+    // Index the ants where the tick left them, for statistics and rendering
+    profiler_begin(PROFILE_ANT_INDEX);
+    build_ant_index(world);
+    profiler_end(PROFILE_ANT_INDEX);
+    
+    profiler_begin(PROFILE_STATISTICS);
+    update_colony_statistics(world);
+    update_pheromone_stats(world);
+    profiler_end(PROFILE_STATISTICS);
+}
@@ -0,0 +1,11 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "data_structures.h"
+
+// Advance the world by one tick: ants, pheromones, ant index, colony
+// statistics.
+// Shared by the interactive loop and the headless benchmark.
+void simulation_step(World* world);
+
+#endif // SIMULATION_H
@@ -26,7 +26,14 @@ int random_int(int min, int max) {
         min = max;
         max = temp;
     }
-    return min + (rand() % (max - min + 1));
+    unsigned int range = (unsigned int)(max - min) + 1u;
+    unsigned int r = (unsigned int)rand();
+    if (range > (unsigned int)RAND_MAX) {
+        // MSVC's RAND_MAX is only 32767, so combine two draws for wide ranges
+        // such as coordinates on large worlds
+        r = r * ((unsigned int)RAND_MAX + 1u) + (unsigned int)rand();
+    }
+    return min + (int)(r % range);
 }
 
 float random_float(float min, float max) {
@@ -76,6 +83,19 @@ void* safe_calloc(size_t count, size_t size) {
     return ptr;
 }
 
+void* safe_realloc(void* ptr, size_t size) {
+    if (size == 0) {
+        print_error("Attempted to allocate 0 bytes");
+        return NULL;
+    }
+    
+    void* resized = realloc(ptr, size);
+    if (resized == NULL) {
+        print_error("Memory allocation failed");
+    }
+    return resized;
+}
+
 void safe_free(void* ptr) {
     if (ptr != NULL) {
         free(ptr);
@@ -160,6 +180,21 @@ uint64_t get_time_ms(void) {
     return (ui.QuadPart - 116444736000000000ULL) / 10000ULL;
 }
 
+uint64_t get_time_us(void) {
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    
+    // Split to avoid overflowing counter * 1000000 on long uptimes
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+    uint64_t freq = (uint64_t)frequency.QuadPart;
+    return (ticks / freq) * 1000000ULL + ((ticks % freq) * 1000000ULL) / freq;
+}
+
 // Math utilities
 float clamp_float(float value, float min, float max) {
     if (value < min) return min;
@@ -13,6 +13,7 @@ float random_probability(void);
 // Memory utilities
 void* safe_malloc(size_t size);
 void* safe_calloc(size_t count, size_t size);
+void* safe_realloc(void* ptr, size_t size);  // Leaves ptr intact on failure
 void safe_free(void* ptr);
 
 // String utilities
@@ -23,6 +24,7 @@ void trim_string(char* str);
 // Time utilities
 void sleep_ms(int milliseconds);
 uint64_t get_time_ms(void);
+uint64_t get_time_us(void);  // High-resolution monotonic clock
 
 // Math utilities
 float clamp_float(float value, float min, float max);
@@ -3,6 +3,8 @@
 #include "utils.h"
 #include "pheromones.h"
 #include "ant_logic.h"  // Needed for ant state constants
+#include "world.h"      // chunk planes and packed cell words
+#include "ant_index.h"  // ants per cell for the overlay
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -183,53 +185,71 @@ void show_cursor(void) {
 }
 
 // World rendering
-void render_world(const World* world) {
-    if (world == NULL) return;
-
-    set_color(COLOR_WHITE);
-
+// Draws the bordered map with ants overlaid (small worlds only)
+static void render_map(const World* world) {
     // Top border (uses Unicode/ASCII helpers if present in file)
     printf("%s", BX_TL());
     for (int x = 0; x < world->width; ++x) printf("%s", BX_H());
     printf("%s\n", BX_TR());
 
-    // --- Build temp grid for symbols only (colors applied at print time) ---
+    // --- Build temp grids for symbols and colors (applied at print time) ---
     const int W = world->width, H = world->height;
     char *grid = (char*)safe_malloc((size_t)W * (size_t)H);
-    if (!grid) return; // fail-safe
+    int *colors = (int*)safe_malloc((size_t)W * (size_t)H * sizeof(int));
+    if (!grid || !colors) { safe_free(grid); safe_free(colors); return; } // fail-safe
 
-    // 1) Terrain/pheromones baseline
+    // 1) Terrain/pheromones baseline, read straight from the packed chunk planes
     for (int y = 0; y < H; ++y) {
         for (int x = 0; x < W; ++x) {
-            Cell* cell = &world->grid[y][x];
+            const Chunk* chunk = get_chunk(world, x, y);
+            uint16_t bits = CELL_PACK(TERRAIN_EMPTY, -1);
+            float m = 0.0f;
+            if (chunk) {
+                int i = CHUNK_LOCAL(x, y);
+                float f = 0.0f, h = 0.0f;
+                for (int k = 0; k < chunk->channel_count; ++k) {  // Total over every colony's trail
+                    const PheromoneChannel* channel = chunk->channels[k];
+                    f += PHEROMONE_LEVEL(world, channel, channel->pheromone_food, i);
+                    h += PHEROMONE_LEVEL(world, channel, channel->pheromone_home, i);
+                }
+                bits = chunk->cell_bits[i];
+                m = (f > h) ? f : h;
+            }
+
             char symbol = ' ';
-            switch (cell->terrain) {
-                case TERRAIN_EMPTY: {
-                    float f = cell->pheromone_food;
-                    float h = cell->pheromone_home;
-                    float m = (f > h) ? f : h;
+            int color = COLOR_WHITE;
+            switch (CELL_TERRAIN(bits)) {
+                case TERRAIN_EMPTY:
                     symbol = (m > 0.0f) ? get_pheromone_symbol(m) : ' ';
-                } break;
-                case TERRAIN_WALL:  symbol = WALL_BLOCK(); break;
-                case TERRAIN_FOOD:  symbol = 'F'; break;
-                case TERRAIN_NEST:  symbol = 'N'; break;
-                case TERRAIN_WATER: symbol = '~'; break;
+                    color = (m > 0.0f) ? get_pheromone_color(m) : COLOR_BLACK;
+                    break;
+                case TERRAIN_WALL:  symbol = WALL_BLOCK(); color = COLOR_BLACK; break;
+                case TERRAIN_FOOD:  symbol = 'F'; color = COLOR_BRIGHT_GREEN; break;
+                case TERRAIN_NEST:  symbol = 'N'; color = get_colony_color(CELL_COLONY(bits)); break;
+                case TERRAIN_WATER: symbol = '~'; color = COLOR_BLUE; break;
             }
             grid[y*W + x] = symbol;
+            colors[y*W + x] = color;
         }
     }
 
-    // 2) Overlay ants
-    for (int c = 0; c < world->colony_count; ++c) {
-        Ant* ant = world->colonies[c].ants_head;
-        while (ant) {
-            if (!(ant->state & ANT_STATE_DEAD)) {
-                int x = ant->pos.x, y = ant->pos.y;
-                if (x >= 0 && x < W && y >= 0 && y < H) {
-                    grid[y*W + x] = (ant->food_carrying > 0) ? ANT_CARRY() : ANT_SEARCH();
-                }
+    // 2) Overlay ants from the ant index: a carrier wins the glyph, the
+    //    colony with the most ants on the cell wins the colour
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            const AntRef* ants;
+            int n = get_ants_at(world, x, y, &ants);
+            if (n == 0) continue;
+
+            int carrying = 0, best = ants[0].colony, best_run = 0, run = 0;
+            for (int i = 0; i < n; ++i) {
+                carrying |= (world->colonies[ants[i].colony].ants.food_carrying[ants[i].slot] > 0);
+                // Ants on a cell are in colony order, so colonies form runs
+                run = (i > 0 && ants[i].colony == ants[i-1].colony) ? run + 1 : 1;
+                if (run > best_run) { best_run = run; best = ants[i].colony; }
             }
-            ant = ant->next;
+            grid[y*W + x] = carrying ? ANT_CARRY() : ANT_SEARCH();
+            colors[y*W + x] = get_colony_color(best);
         }
     }
 
@@ -237,31 +257,8 @@ void render_world(const World* world) {
     for (int y = 0; y < H; ++y) {
         printf("%s", BX_V());
         for (int x = 0; x < W; ++x) {
-            Cell* cell = &world->grid[y][x];
-            char ch = grid[y*W + x];
-            int color = COLOR_WHITE;
-            // derive color similar to old path
-            switch (cell->terrain) {
-                case TERRAIN_EMPTY: {
-                    float f = cell->pheromone_food, h = cell->pheromone_home;
-                    float m = (f > h) ? f : h;
-                    color = (m > 0.0f) ? get_pheromone_color(m) : COLOR_BLACK;
-                } break;
-                case TERRAIN_WALL:  color = COLOR_BLACK; break;
-                case TERRAIN_FOOD:  color = COLOR_BRIGHT_GREEN; break;
-                case TERRAIN_NEST:  color = get_colony_color(cell->colony_id); break;
-                case TERRAIN_WATER: color = COLOR_BLUE; break;
-            }
-
-            // If an ant is present, color by colony
-            if (ch == ANT_SEARCH() || ch == ANT_CARRY()) {
-                // colony color based on nest pheromone dominance heuristic
-                // (optional; if you track ant per cell you can refine)
-                color = COLOR_BRIGHT_RED; // safe, visible default
-            }
-
-            set_color(color);
-            printf("%c", ch);
+            set_color(colors[y*W + x]);
+            printf("%c", grid[y*W + x]);
         }
         set_color(COLOR_WHITE);
         printf("%s\n", BX_V());
@@ -273,6 +270,21 @@ void render_world(const World* world) {
     printf("%s\n", BX_BR());
 
     safe_free(grid);
+    safe_free(colors);
+}
+
+void render_world(const World* world) {
+    if (world == NULL) return;
+
+    set_color(COLOR_WHITE);
+
+    if (world->large_world) {
+        // Large-world mode: the map cannot fit in a console, show status only
+        printf("LARGE WORLD %dx%d - map view disabled                \n",
+               world->width, world->height);
+    } else {
+        render_map(world);
+    }
 
     // Compact stats/legend/controls printed **below** the map (no positioning)
     set_color(COLOR_WHITE);
@@ -285,9 +297,14 @@ void render_world(const World* world) {
         set_color(get_colony_color(col->id));
         printf("Colony %d  ", col->id);
         set_color(COLOR_WHITE);
-        printf("Food: %-4d Ants: %-2d/%-2d Eff: %-6.2f            \n",
-               col->food_collected, col->active_ants, col->total_ants, col->efficiency_score);
+        printf("Food: %-4d Ants: %-2d/%-2d Carry: %-3d Terr: %-6d Eff: %-6.2f    \n",
+               col->food_collected, col->active_ants, col->total_ants,
+               col->carrying_ants, col->territory_size, col->efficiency_score);
     }
+    const PheromoneStats* pheromones = &world->pheromone_stats;
+    printf("Pheromone Food: max %-7.1f cover %5.1f%%  Home: max %-7.1f cover %5.1f%%    \n",
+           pheromones->types[PHEROMONE_TYPE_FOOD].max, get_pheromone_coverage(pheromones, PHEROMONE_TYPE_FOOD),
+           pheromones->types[PHEROMONE_TYPE_HOME].max, get_pheromone_coverage(pheromones, PHEROMONE_TYPE_HOME));
 
     printf("                                                        \n");
     printf("LEGEND  F=Food N=Nest %c/%c=Ant %c=Wall                \n",
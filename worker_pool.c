@@ -0,0 +1,154 @@
+#include "worker_pool.h"
+#include "config.h"
+#include "utils.h"
+#include <windows.h>
+
+// Pool state. Workers sleep on work_ready until generation changes, run
+// their band and count pending down; the caller waits on work_done.
+typedef struct WorkerPool {
+    HANDLE threads[MAX_WORKER_THREADS];
+    int started;               // Worker threads running (thread count - 1)
+    int thread_count;          // Configured count, 0 until first use
+    
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE work_ready;
+    CONDITION_VARIABLE work_done;
+    int lock_initialized;
+    
+    unsigned int generation;   // Bumped for every job
+    int shutting_down;
+    WorkerTask task;
+    void* context;
+    int band_count;
+    int pending;               // Bands not yet finished by the workers
+} WorkerPool;
+
+static WorkerPool g_pool;
+
+typedef struct WorkerStart {
+    int band;                  // Band this worker runs, 1..MAX_WORKER_THREADS-1
+    unsigned int generation;   // Last job before the worker started
+} WorkerStart;
+
+static WorkerStart g_worker_start[MAX_WORKER_THREADS];
+
+static DWORD WINAPI worker_main(LPVOID parameter) {
+    // The job that started the pool may be posted before this thread runs,
+    // so the generation to wait past is the one from when it was created
+    int band = ((WorkerStart*)parameter)->band;
+    unsigned int seen = ((WorkerStart*)parameter)->generation;
+    
+    EnterCriticalSection(&g_pool.lock);
+    for (;;) {
+        while (g_pool.generation == seen && !g_pool.shutting_down) {
+            SleepConditionVariableCS(&g_pool.work_ready, &g_pool.lock, INFINITE);
+        }
+        if (g_pool.shutting_down) break;
+        seen = g_pool.generation;
+        
+        // Workers past this job's band count sit it out
+        if (band >= g_pool.band_count) continue;
+        WorkerTask task = g_pool.task;
+        void* context = g_pool.context;
+        int band_count = g_pool.band_count;
+        LeaveCriticalSection(&g_pool.lock);
+        
+        task(context, band, band_count);
+        
+        EnterCriticalSection(&g_pool.lock);
+        if (--g_pool.pending == 0) {
+            WakeConditionVariable(&g_pool.work_done);
+        }
+    }
+    LeaveCriticalSection(&g_pool.lock);
+    return 0;
+}
+
+int get_processor_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return clamp_int((int)info.dwNumberOfProcessors, 1, MAX_WORKER_THREADS);
+}
+
+int get_worker_threads(void) {
+    if (g_pool.thread_count == 0) {
+        set_worker_threads(DEFAULT_WORKER_THREADS);
+    }
+    return g_pool.thread_count;
+}
+
+int set_worker_threads(int threads) {
+    shutdown_worker_pool();
+    g_pool.thread_count = (threads <= 0) ? get_processor_count() : clamp_int(threads, 1, MAX_WORKER_THREADS);
+    return g_pool.thread_count;
+}
+
+// Starts the worker threads for the configured count. Returns how many run;
+// if some fail to start the pool just has fewer of them.
+static int start_workers(void) {
+    if (!g_pool.lock_initialized) {
+        InitializeCriticalSection(&g_pool.lock);
+        InitializeConditionVariable(&g_pool.work_ready);
+        InitializeConditionVariable(&g_pool.work_done);
+        g_pool.lock_initialized = 1;
+    }
+    
+    g_pool.shutting_down = 0;
+    while (g_pool.started < g_pool.thread_count - 1) {
+        int band = g_pool.started + 1;
+        g_worker_start[band].band = band;
+        g_worker_start[band].generation = g_pool.generation;
+        HANDLE thread = CreateThread(NULL, 0, worker_main, &g_worker_start[band], 0, NULL);
+        if (thread == NULL) {
+            print_warning("Could not start worker thread %d, continuing with %d", band, band);
+            g_pool.thread_count = band;
+            break;
+        }
+        g_pool.threads[g_pool.started++] = thread;
+    }
+    return g_pool.started;
+}
+
+void shutdown_worker_pool(void) {
+    if (g_pool.started == 0) return;
+    
+    EnterCriticalSection(&g_pool.lock);
+    g_pool.shutting_down = 1;
+    WakeAllConditionVariable(&g_pool.work_ready);
+    LeaveCriticalSection(&g_pool.lock);
+    
+    for (int i = 0; i < g_pool.started; i++) {
+        WaitForSingleObject(g_pool.threads[i], INFINITE);
+        CloseHandle(g_pool.threads[i]);
+    }
+    g_pool.started = 0;
+}
+
+void run_worker_bands(WorkerTask task, void* context, int band_count) {
+    band_count = clamp_int(band_count, 1, get_worker_threads());
+    if (band_count > 1 && g_pool.started < g_pool.thread_count - 1) {
+        start_workers();
+        band_count = clamp_int(band_count, 1, g_pool.started + 1);
+    }
+    if (band_count == 1) {
+        task(context, 0, 1);
+        return;
+    }
+    
+    EnterCriticalSection(&g_pool.lock);
+    g_pool.task = task;
+    g_pool.context = context;
+    g_pool.band_count = band_count;
+    g_pool.pending = band_count - 1;
+    g_pool.generation++;
+    WakeAllConditionVariable(&g_pool.work_ready);
+    LeaveCriticalSection(&g_pool.lock);
+    
+    task(context, 0, band_count);
+    
+    EnterCriticalSection(&g_pool.lock);
+    while (g_pool.pending > 0) {
+        SleepConditionVariableCS(&g_pool.work_done, &g_pool.lock, INFINITE);
+    }
+    LeaveCriticalSection(&g_pool.lock);
+}
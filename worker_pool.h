@@ -0,0 +1,19 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+// Persistent worker threads for the parallel parts of a tick. A job is split
+// into bands numbered 0..band_count-1; band 0 runs on the calling thread and
+// the call returns once every band is done. Tasks must not depend on which
+// thread runs a band, so results are the same for any thread count.
+typedef void (*WorkerTask)(void* context, int band, int band_count);
+
+// Pool control
+int set_worker_threads(int threads);  // 0 = one per processor; returns the count in use
+int get_worker_threads(void);
+int get_processor_count(void);
+void shutdown_worker_pool(void);
+
+// Runs task for every band. band_count is clamped to 1..get_worker_threads().
+void run_worker_bands(WorkerTask task, void* context, int band_count);
+
+#endif // WORKER_POOL_H
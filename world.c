@@ -1,10 +1,374 @@
 #include "world.h"
 #include "config.h"
 #include "utils.h"
+#include "ant_logic.h"
+#include "ant_index.h"
+#include "pheromones.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+const int neighbor_offset[8] = {
+    CHUNK_OFFSET(0, -1), CHUNK_OFFSET(1, -1), CHUNK_OFFSET(1, 0), CHUNK_OFFSET(1, 1),
+    CHUNK_OFFSET(0, 1), CHUNK_OFFSET(-1, 1), CHUNK_OFFSET(-1, 0), CHUNK_OFFSET(-1, -1)
+};
+
+// Chunk allocation
+#define GRID_PLANE_ALIGNMENT 64  // Cache line, also enough for any vector width
+
+static size_t align_plane_size(size_t bytes) {
+    return (bytes + GRID_PLANE_ALIGNMENT - 1) & ~(size_t)(GRID_PLANE_ALIGNMENT - 1);
+}
+
+// Bytes of one chunk block: header plus its padded planes, each on a
+// cache line
+static size_t chunk_block_size(void) {
+    return align_plane_size(sizeof(Chunk)) +
+           3 * align_plane_size(CHUNK_PADDED_CELLS * sizeof(uint16_t)) +
+           align_plane_size(CHUNK_PADDED_CELLS * sizeof(uint8_t));
+}
+
+// Bytes of one pheromone channel block: header plus its padded front planes
+static size_t channel_block_size(void) {
+    return align_plane_size(sizeof(PheromoneChannel)) +
+           2 * align_plane_size(CHUNK_PADDED_CELLS * sizeof(PheromoneValue)) +
+           PHEROMONE_LAZY_EVAPORATION * align_plane_size(CHUNK_PADDED_CELLS * sizeof(int));
+}
+
+// Pheromone channels
+
+// Allocates an all-zero channel for colony in chunk. Its halo is left for
+// the caller to fill.
+static PheromoneChannel* allocate_channel(const World* world, Chunk* chunk, int colony) {
+    void* block = safe_malloc(channel_block_size() + GRID_PLANE_ALIGNMENT);
+    if (block == NULL) {
+        return NULL;
+    }
+    
+    uintptr_t base = ((uintptr_t)block + GRID_PLANE_ALIGNMENT - 1) &
+                     ~(uintptr_t)(GRID_PLANE_ALIGNMENT - 1);
+    size_t pheromone_plane = align_plane_size(CHUNK_PADDED_CELLS * sizeof(PheromoneValue));
+    
+    PheromoneChannel* channel = (PheromoneChannel*)base;
+    base += align_plane_size(sizeof(PheromoneChannel));
+    channel->chunk = chunk;
+    channel->colony = colony;
+    channel->block = block;
+    channel->pheromone_food = (PheromoneValue*)base;
+    channel->pheromone_home = (PheromoneValue*)(base + pheromone_plane);
+    channel->pheromone_step = NULL;
+#if PHEROMONE_LAZY_EVAPORATION
+    channel->pheromone_step = (int*)(base + 2 * pheromone_plane);
+    for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+        channel->pheromone_step[i] = world->current_step;
+    }
+#else
+    (void)world;
+#endif
+    channel->last_pheromone_step = -1;
+    
+    for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+        channel->pheromone_food[i] = PHEROMONE_INITIAL;
+        channel->pheromone_home[i] = PHEROMONE_INITIAL;
+    }
+    channel->back_food = NULL;
+    channel->back_home = NULL;
+    channel->back_block = NULL;
+    channel->pheromone_active = 0;
+    channel->halo_stale = 0;
+    clear_pheromone_box(&channel->pheromone_box);
+    clear_pheromone_box(&channel->back_box);
+    channel->gradient = NULL;
+    channel->gradient_generation[0] = channel->gradient_generation[1] = 0;
+    channel->gradient_reads[0] = channel->gradient_reads[1] = 0;
+    channel->sum_table = NULL;
+    clear_pheromone_box(&channel->sum_box);
+    channel->sum_generation = 0;
+    memset(channel->deposits, 0, sizeof(channel->deposits));
+    return channel;
+}
+
+static void free_channel(PheromoneChannel* channel) {
+    safe_free(channel->gradient);
+    safe_free(channel->sum_table);
+    safe_free(channel->deposits[0].deposits);
+    safe_free(channel->deposits[1].deposits);
+    safe_free(channel->back_block);
+    safe_free(channel->block);
+}
+
+// Frees every channel of a chunk
+static void release_chunk_channels(Chunk* chunk) {
+    for (int k = 0; k < chunk->channel_count; k++) {
+        free_channel(chunk->channels[k]);
+    }
+    safe_free(chunk->channels);
+    chunk->channels = NULL;
+    chunk->channel_count = 0;
+    chunk->channel_capacity = 0;
+}
+
+// Frees the channels of a chunk that no longer hold pheromone
+static void release_empty_channels(Chunk* chunk) {
+    int kept = 0;
+    for (int k = 0; k < chunk->channel_count; k++) {
+        PheromoneChannel* channel = chunk->channels[k];
+        if (channel->pheromone_active) {
+            chunk->channels[kept++] = channel;
+        } else {
+            free_channel(channel);
+        }
+    }
+    chunk->channel_count = kept;
+}
+
+// Position of colony's channel in the sorted channel list, or of the first
+// channel past it
+static int find_channel_slot(const Chunk* chunk, int colony) {
+    int low = 0;
+    int high = chunk->channel_count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (chunk->channels[mid]->colony < colony) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+PheromoneChannel* get_pheromone_channel(const Chunk* chunk, int colony) {
+    if (chunk == NULL) return NULL;
+    
+    int slot = find_channel_slot(chunk, colony);
+    if (slot < chunk->channel_count && chunk->channels[slot]->colony == colony) {
+        return chunk->channels[slot];
+    }
+    return NULL;
+}
+
+// Colony's channel in chunk, allocated on first touch with its halo filled
+// from the neighbours. Returns NULL if out of memory.
+PheromoneChannel* touch_pheromone_channel(World* world, Chunk* chunk, int colony) {
+    if (world == NULL || chunk == NULL) return NULL;
+    
+    int slot = find_channel_slot(chunk, colony);
+    if (slot < chunk->channel_count && chunk->channels[slot]->colony == colony) {
+        return chunk->channels[slot];
+    }
+    
+    if (chunk->channel_count == chunk->channel_capacity) {
+        int capacity = chunk->channel_capacity ? chunk->channel_capacity * 2 : 2;
+        PheromoneChannel** channels = (PheromoneChannel**)safe_realloc(chunk->channels,
+                                                                       capacity * sizeof(PheromoneChannel*));
+        if (channels == NULL) return NULL;
+        chunk->channels = channels;
+        chunk->channel_capacity = capacity;
+    }
+    
+    PheromoneChannel* channel = allocate_channel(world, chunk, colony);
+    if (channel == NULL) return NULL;
+    
+    memmove(chunk->channels + slot + 1, chunk->channels + slot,
+            (chunk->channel_count - slot) * sizeof(PheromoneChannel*));
+    chunk->channels[slot] = channel;
+    chunk->channel_count++;
+    channel->pheromone_active = refresh_channel_halo(world, channel);
+    return channel;
+}
+
+// Back planes for the pheromone update, allocated zeroed the first time a
+// channel is updated and kept for as long as the channel. Returns 0 if out
+// of memory.
+int reserve_pheromone_buffers(PheromoneChannel* channel) {
+    if (channel->back_block != NULL) return 1;
+    
+    size_t pheromone_plane = align_plane_size(CHUNK_PADDED_CELLS * sizeof(PheromoneValue));
+    void* block = safe_calloc(1, 2 * pheromone_plane + GRID_PLANE_ALIGNMENT);
+    if (block == NULL) return 0;
+    
+    uintptr_t base = ((uintptr_t)block + GRID_PLANE_ALIGNMENT - 1) &
+                     ~(uintptr_t)(GRID_PLANE_ALIGNMENT - 1);
+    channel->back_block = block;
+    channel->back_food = (PheromoneValue*)base;
+    channel->back_home = (PheromoneValue*)(base + pheromone_plane);
+    clear_pheromone_box(&channel->back_box);
+    return 1;
+}
+
+// Allocates an empty chunk, registers it in the directory and list and
+// fills its halo from the neighbours
+static Chunk* allocate_chunk(World* world, int cx, int cy) {
+    void* block = safe_malloc(chunk_block_size() + GRID_PLANE_ALIGNMENT);
+    if (block == NULL) {
+        return NULL;
+    }
+    
+    uintptr_t base = ((uintptr_t)block + GRID_PLANE_ALIGNMENT - 1) &
+                     ~(uintptr_t)(GRID_PLANE_ALIGNMENT - 1);
+    size_t word_plane = align_plane_size(CHUNK_PADDED_CELLS * sizeof(uint16_t));
+    
+    Chunk* chunk = (Chunk*)base;
+    base += align_plane_size(sizeof(Chunk));
+    chunk->block = block;
+    chunk->cx = cx;
+    chunk->cy = cy;
+    chunk->cols = (world->width - cx * CHUNK_SIZE < CHUNK_SIZE) ? world->width - cx * CHUNK_SIZE : CHUNK_SIZE;
+    chunk->rows = (world->height - cy * CHUNK_SIZE < CHUNK_SIZE) ? world->height - cy * CHUNK_SIZE : CHUNK_SIZE;
+    chunk->cell_bits = (uint16_t*)base;
+    chunk->food_amount = (uint16_t*)(base + word_plane);
+    chunk->territory = (int16_t*)(base + 2 * word_plane);
+    chunk->walk_mask = (uint8_t*)(base + 3 * word_plane);
+    
+    // Initialize all cells to empty; everything outside the world is wall
+    for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+        chunk->food_amount[i] = 0;
+        chunk->cell_bits[i] = CELL_PACK(TERRAIN_WALL, -1);
+        chunk->territory[i] = -1;
+    }
+    memset(chunk->walk_mask, 0, CHUNK_PADDED_CELLS);
+    chunk->walk_version = 0;
+    chunk->walkable = NULL;
+    for (int ly = 0; ly < chunk->rows; ly++) {
+        int row = CHUNK_PAD_INDEX(0, ly);
+        for (int i = row; i < row + chunk->cols; i++) {
+            chunk->cell_bits[i] = CELL_PACK(TERRAIN_EMPTY, -1);
+        }
+    }
+    chunk->content_cells = 0;
+    chunk->channels = NULL;
+    chunk->channel_count = 0;
+    chunk->channel_capacity = 0;
+    chunk->last_ant_step = -1;
+    chunk->idle_sweeps = 0;
+    chunk->food_sources = NULL;
+    chunk->food_source_count = 0;
+    chunk->food_source_capacity = 0;
+    chunk->food_total = 0;
+    
+    world->chunks[cy * world->chunks_x + cx] = chunk;
+    chunk->list_index = world->chunk_count;
+    world->chunk_list[world->chunk_count++] = chunk;
+    
+    refresh_chunk_halo(world, chunk);
+    rebuild_walk_masks(chunk);
+    return chunk;
+}
+
+// Frees an idle chunk. Its cells' territory claims are forgotten with it.
+static void release_chunk(World* world, Chunk* chunk) {
+    for (int ly = 0; ly < chunk->rows; ly++) {
+        int row = CHUNK_PAD_INDEX(0, ly);
+        for (int i = row; i < row + chunk->cols; i++) {
+            if (chunk->territory[i] >= 0) {
+                world->colonies[chunk->territory[i]].territory_size--;
+            }
+        }
+    }
+    
+    world->chunks[chunk->cy * world->chunks_x + chunk->cx] = NULL;
+    
+    // Swap the last chunk into the freed list slot
+    Chunk* last = world->chunk_list[world->chunk_count - 1];
+    world->chunk_list[chunk->list_index] = last;
+    last->list_index = chunk->list_index;
+    world->chunk_count--;
+    
+    release_chunk_channels(chunk);
+    safe_free(chunk->walkable);
+    safe_free(chunk->food_sources);
+    safe_free(chunk->block);
+}
+
+// Food registry
+static int add_food_source(World* world, Chunk* chunk, int local) {
+    if (chunk->food_source_count == chunk->food_source_capacity) {
+        int capacity = chunk->food_source_capacity ? chunk->food_source_capacity * 2 : 8;
+        uint16_t* sources = (uint16_t*)safe_realloc(chunk->food_sources, capacity * sizeof(uint16_t));
+        if (sources == NULL) return 0;
+        chunk->food_sources = sources;
+        chunk->food_source_capacity = capacity;
+    }
+    
+    chunk->food_sources[chunk->food_source_count++] = (uint16_t)local;
+    world->food_source_count++;
+    return 1;
+}
+
+static void remove_food_source(World* world, Chunk* chunk, int local) {
+    for (int s = 0; s < chunk->food_source_count; s++) {
+        if (chunk->food_sources[s] == local) {
+            chunk->food_sources[s] = chunk->food_sources[--chunk->food_source_count];
+            world->food_source_count--;
+            return;
+        }
+    }
+}
+
+// Walk mask of the cell at plane index i, read from the chunk's terrain
+// (the halo supplies the neighbours across the chunk edge)
+static uint8_t compute_walk_mask(const Chunk* chunk, int i) {
+    uint8_t mask = 0;
+    for (int dir = 0; dir < 8; dir++) {
+        if (TERRAIN_IS_WALKABLE(CELL_TERRAIN(chunk->cell_bits[i + neighbor_offset[dir]]))) {
+            mask |= (uint8_t)(1 << dir);
+        }
+    }
+    return mask;
+}
+
+// Recomputes the walk masks of the 8 cells around (x, y)
+static void update_neighbor_walk_masks(World* world, int x, int y) {
+    for (int dir = 0; dir < 8; dir++) {
+        int nx = x + dx[dir];
+        int ny = y + dy[dir];
+        if (!wrap_position(world, &nx, &ny)) continue;
+        
+        Chunk* chunk = get_chunk(world, nx, ny);
+        if (chunk != NULL) {
+            int i = CHUNK_LOCAL(nx, ny);
+            chunk->walk_mask[i] = compute_walk_mask(chunk, i);
+            chunk->walk_version++;
+        }
+    }
+}
+
+// Writes a cell's packed terrain, colony and food amount, keeping the
+// chunk's content count, the food registry, the halos mirroring the cell and
+// the walk masks around it in step. Changes between walkable kinds (food
+// running out, a nest placed) leave the masks alone. Food amounts beyond
+// CELL_MAX_FOOD are clamped, unknown colonies stored as none.
+static void write_cell(World* world, Chunk* chunk, int x, int y, TerrainType terrain,
+                       int colony_id, int food_amount) {
+    int local = CHUNK_LOCAL(x, y);
+    TerrainType previous = CELL_TERRAIN(chunk->cell_bits[local]);
+    food_amount = clamp_int(food_amount, 0, CELL_MAX_FOOD);
+    if (colony_id < 0 || colony_id >= CELL_MAX_COLONIES) colony_id = -1;
+    
+    if (previous != TERRAIN_EMPTY) chunk->content_cells--;
+    if (terrain != TERRAIN_EMPTY) chunk->content_cells++;
+    
+    if (previous == TERRAIN_FOOD) {
+        chunk->food_total -= chunk->food_amount[local];
+        world->food_remaining -= chunk->food_amount[local];
+        if (terrain != TERRAIN_FOOD) remove_food_source(world, chunk, local);
+    }
+    if (terrain == TERRAIN_FOOD) {
+        chunk->food_total += food_amount;
+        world->food_remaining += food_amount;
+        if (previous != TERRAIN_FOOD) add_food_source(world, chunk, local);
+    }
+    chunk->food_amount[local] = (uint16_t)food_amount;
+    chunk->cell_bits[local] = CELL_PACK(terrain, colony_id);
+    update_cell_halos(world, x, y);
+    
+    if (TERRAIN_IS_WALKABLE(previous) != TERRAIN_IS_WALKABLE(terrain)) {
+        update_neighbor_walk_masks(world, x, y);
+        chunk->walk_version++;  // The cell itself joins or leaves the walkable ones
+    }
+}
+
 // World creation and destruction
 World* create_world(int width, int height, int colony_count) {
     if (width <= 0 || height <= 0 || colony_count <= 0) {
@@ -17,6 +381,11 @@ World* create_world(int width, int height, int colony_count) {
         return NULL;
     }
     
+    if (colony_count > CELL_MAX_COLONIES) {
+        print_error("Colony count exceeds maximum allowed");
+        return NULL;
+    }
+    
     // Allocate world struct
     World* world = (World*)safe_malloc(sizeof(World));
     if (world == NULL) {
@@ -32,6 +401,22 @@ World* create_world(int width, int height, int colony_count) {
     world->paused = 0;
     world->render_delay_ms = RENDER_DELAY_MS;
     
+    // Large worlds are simulated headless: no map rendering, no per-step path
+    // history (it grows by one node per ant per tick), and a higher ant cap
+    world->large_world = (width > MAX_RENDER_WORLD_SIZE || height > MAX_RENDER_WORLD_SIZE);
+    world->max_ants_per_colony = world->large_world ? LARGE_WORLD_MAX_ANTS_PER_COLONY : MAX_ANTS_PER_COLONY;
+    world->record_paths = !world->large_world;
+    world->toroidal = 0;
+    world->private_trails = 0;
+    world->food_remaining = 0;
+    world->food_source_count = 0;
+    memset(&world->ant_index, 0, sizeof(AntIndex));
+    world->ant_index.step = -1;
+    world->pheromone_block_ticks = 0;
+    world->pheromone_generation = 1;
+    world->pheromone_sum_generation = 0;
+    memset(&world->pheromone_stats, 0, sizeof(PheromoneStats));
+    
     // Allocate colonies array
     world->colonies = (Colony*)safe_calloc(colony_count, sizeof(Colony));
     if (world->colonies == NULL) {
@@ -45,43 +430,25 @@ World* create_world(int width, int height, int colony_count) {
         world->colonies[i].food_collected = 0;
         world->colonies[i].total_ants = 0;
         world->colonies[i].active_ants = 0;
-        world->colonies[i].ants_head = NULL;
         world->colonies[i].efficiency_score = 0.0f;
         world->colonies[i].color = i + 1; // Different color for each colony
     }
     
-    // Allocate 2D grid
-    world->grid = (Cell**)safe_malloc(height * sizeof(Cell*));
-    if (world->grid == NULL) {
+    // Allocate the chunk directory; chunks themselves come on first touch
+    world->chunks_x = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    world->chunks_y = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    world->chunk_count = 0;
+    size_t directory = (size_t)world->chunks_x * (size_t)world->chunks_y;
+    world->chunks = (Chunk**)safe_calloc(directory, sizeof(Chunk*));
+    world->chunk_list = (Chunk**)safe_calloc(directory, sizeof(Chunk*));
+    if (world->chunks == NULL || world->chunk_list == NULL) {
+        safe_free(world->chunks);
+        safe_free(world->chunk_list);
         safe_free(world->colonies);
         safe_free(world);
         return NULL;
     }
     
-    // Allocate each row
-    for (int i = 0; i < height; i++) {
-        world->grid[i] = (Cell*)safe_calloc(width, sizeof(Cell));
-        if (world->grid[i] == NULL) {
-            // Clean up already allocated rows
-            for (int j = 0; j < i; j++) {
-                safe_free(world->grid[j]);
-            }
-            safe_free(world->grid);
-            safe_free(world->colonies);
-            safe_free(world);
-            return NULL;
-        }
-        
-        // Initialize all cells to empty
-        for (int j = 0; j < width; j++) {
-            world->grid[i][j].terrain = TERRAIN_EMPTY;
-            world->grid[i][j].pheromone_food = PHEROMONE_INITIAL;
-            world->grid[i][j].pheromone_home = PHEROMONE_INITIAL;
-            world->grid[i][j].food_amount = 0;
-            world->grid[i][j].colony_id = -1;
-        }
-    }
-    
     print_info("World created successfully");
     return world;
 }
@@ -89,24 +456,23 @@ World* create_world(int width, int height, int colony_count) {
 void destroy_world(World* world) {
     if (world == NULL) return;
     
+    discard_pheromone_deposits();
+    
     // Free all ants in all colonies
     for (int i = 0; i < world->colony_count; i++) {
-        Colony* colony = &world->colonies[i];
-        Ant* current = colony->ants_head;
-        while (current != NULL) {
-            Ant* next = current->next;
-            safe_free(current);
-            current = next;
-        }
+        free_ant_pool(&world->colonies[i].ants);
     }
     
-    // Free grid rows
-    if (world->grid != NULL) {
-        for (int i = 0; i < world->height; i++) {
-            safe_free(world->grid[i]);
-        }
-        safe_free(world->grid);
+    // Free chunks and the directory
+    for (int c = 0; c < world->chunk_count; c++) {
+        release_chunk_channels(world->chunk_list[c]);
+        safe_free(world->chunk_list[c]->walkable);
+        safe_free(world->chunk_list[c]->food_sources);
+        safe_free(world->chunk_list[c]->block);
     }
+    safe_free(world->chunks);
+    safe_free(world->chunk_list);
+    free_ant_index(&world->ant_index);
     
     // Free colonies array
     safe_free(world->colonies);
@@ -130,14 +496,17 @@ void place_colony(World* world, int colony_id, int x, int y) {
     }
     
     // Check if position is already occupied
-    if (world->grid[y][x].terrain != TERRAIN_EMPTY) {
+    if (get_terrain(world, x, y) != TERRAIN_EMPTY) {
         print_warning("Position already occupied, clearing first");
         clear_cell(world, x, y);
     }
     
+    Chunk* chunk = touch_chunk(world, x, y);
+    if (chunk == NULL) return;
+    int local = CHUNK_LOCAL(x, y);
+    
     // Place colony
-    world->grid[y][x].terrain = TERRAIN_NEST;
-    world->grid[y][x].colony_id = colony_id;
+    write_cell(world, chunk, x, y, TERRAIN_NEST, colony_id, chunk->food_amount[local]);
     
     // Update colony position
     world->colonies[colony_id].nest_pos.x = x;
@@ -146,6 +515,31 @@ void place_colony(World* world, int colony_id, int x, int y) {
     print_info("Colony %d placed at (%d, %d)", colony_id, x, y);
 }
 
+// Nests per row and rows of nests that fit COLONY_MIN_SPACING apart
+static int nests_across(int length) {
+    return (length / COLONY_MIN_SPACING > 1) ? length / COLONY_MIN_SPACING - 1 : 1;
+}
+
+// Colonies place_colonies_evenly can fit on a width x height map
+int get_colony_capacity(int width, int height) {
+    long long capacity = (long long)nests_across(width) * nests_across(height);
+    return (capacity < MAX_COLONIES) ? (int)capacity : MAX_COLONIES;
+}
+
+// Places every colony's nest in evenly spaced rows, as many to a row as fit
+// COLONY_MIN_SPACING apart, so a few colonies share the middle row
+void place_colonies_evenly(World* world) {
+    if (world == NULL) return;
+    
+    int per_row = clamp_int(nests_across(world->width), 1, world->colony_count);
+    int rows = (world->colony_count + per_row - 1) / per_row;
+    for (int i = 0; i < world->colony_count; i++) {
+        int x = (world->width / (per_row + 1)) * (i % per_row + 1);
+        int y = (world->height / (rows + 1)) * (i / per_row + 1);
+        place_colony(world, i, x, y);
+    }
+}
+
 void place_food(World* world, int x, int y, int amount) {
     if (world == NULL || amount <= 0) {
         print_error("Invalid food placement parameters");
@@ -158,16 +552,19 @@ void place_food(World* world, int x, int y, int amount) {
     }
     
     // Check if position is already occupied
-    if (world->grid[y][x].terrain != TERRAIN_EMPTY) {
+    if (get_terrain(world, x, y) != TERRAIN_EMPTY) {
         print_warning("Position already occupied, clearing first");
         clear_cell(world, x, y);
     }
     
+    Chunk* chunk = touch_chunk(world, x, y);
+    if (chunk == NULL) return;
+    
     // Place food
-    world->grid[y][x].terrain = TERRAIN_FOOD;
-    world->grid[y][x].food_amount = amount;
+    int local = CHUNK_LOCAL(x, y);
+    write_cell(world, chunk, x, y, TERRAIN_FOOD, CELL_COLONY(chunk->cell_bits[local]), amount);
     
-    print_info("Food placed at (%d, %d) with amount %d", x, y, amount);
+    LOG_WORLD_INFO("Food placed at (%d, %d) with amount %d", x, y, amount);
 }
 
 void place_obstacle(World* world, int x, int y) {
@@ -182,27 +579,57 @@ void place_obstacle(World* world, int x, int y) {
     }
     
     // Check if position is already occupied
-    if (world->grid[y][x].terrain != TERRAIN_EMPTY) {
+    if (get_terrain(world, x, y) != TERRAIN_EMPTY) {
         print_warning("Position already occupied, clearing first");
         clear_cell(world, x, y);
     }
     
+    Chunk* chunk = touch_chunk(world, x, y);
+    if (chunk == NULL) return;
+    
     // Place obstacle
-    world->grid[y][x].terrain = TERRAIN_WALL;
+    int local = CHUNK_LOCAL(x, y);
+    write_cell(world, chunk, x, y, TERRAIN_WALL, CELL_COLONY(chunk->cell_bits[local]), chunk->food_amount[local]);
     
-    print_info("Obstacle placed at (%d, %d)", x, y);
+    LOG_WORLD_INFO("Obstacle placed at (%d, %d)", x, y);
 }
 
 void clear_cell(World* world, int x, int y) {
-    if (world == NULL || !is_valid_position(world, x, y)) {
+    // Untouched chunks are already empty
+    Chunk* chunk = get_chunk(world, x, y);
+    if (chunk == NULL) {
         return;
     }
     
-    world->grid[y][x].terrain = TERRAIN_EMPTY;
-    world->grid[y][x].pheromone_food = PHEROMONE_INITIAL;
-    world->grid[y][x].pheromone_home = PHEROMONE_INITIAL;
-    world->grid[y][x].food_amount = 0;
-    world->grid[y][x].colony_id = -1;
+    int local = CHUNK_LOCAL(x, y);
+    for (int k = 0; k < chunk->channel_count; k++) {
+        chunk->channels[k]->pheromone_food[local] = PHEROMONE_INITIAL;
+        chunk->channels[k]->pheromone_home[local] = PHEROMONE_INITIAL;
+    }
+    invalidate_pheromone_gradients(world);
+    write_cell(world, chunk, x, y, TERRAIN_EMPTY, -1, 0);
+}
+
+int take_food(World* world, int x, int y) {
+    Chunk* chunk = get_chunk(world, x, y);
+    if (chunk == NULL) {
+        return 0;
+    }
+    
+    int local = CHUNK_LOCAL(x, y);
+    if (CELL_TERRAIN(chunk->cell_bits[local]) != TERRAIN_FOOD || chunk->food_amount[local] == 0) {
+        return 0;
+    }
+    
+    chunk->food_amount[local]--;
+    chunk->food_total--;
+    world->food_remaining--;
+    
+    // If food depleted, clear the cell
+    if (chunk->food_amount[local] == 0) {
+        write_cell(world, chunk, x, y, TERRAIN_EMPTY, CELL_COLONY(chunk->cell_bits[local]), 0);
+    }
+    return 1;
 }
 
 // World queries
@@ -214,13 +641,685 @@ int is_valid_position(const World* world, int x, int y) {
 int is_walkable(const World* world, int x, int y) {
     if (!is_valid_position(world, x, y)) return 0;
     
-    TerrainType terrain = world->grid[y][x].terrain;
-    return (terrain == TERRAIN_EMPTY || terrain == TERRAIN_FOOD || terrain == TERRAIN_NEST);
+    TerrainType terrain = get_terrain(world, x, y);
+    return TERRAIN_IS_WALKABLE(terrain);
+}
+
+// Wraps (x, y) onto the world in a toroidal world; returns whether the
+// resulting position is on the grid
+int wrap_position(const World* world, int* x, int* y) {
+    if (world == NULL || x == NULL || y == NULL) return 0;
+    
+    if (world->toroidal) {
+        *x = ((*x % world->width) + world->width) % world->width;
+        *y = ((*y % world->height) + world->height) % world->height;
+    }
+    return is_valid_position(world, *x, *y);
+}
+
+// Out-of-bounds positions read as wall, untouched chunks as empty
+TerrainType get_terrain(const World* world, int x, int y) {
+    if (!is_valid_position(world, x, y)) return TERRAIN_WALL;
+    
+    Chunk* chunk = get_chunk(world, x, y);
+    if (chunk == NULL) return TERRAIN_EMPTY;
+    return CELL_TERRAIN(chunk->cell_bits[CHUNK_LOCAL(x, y)]);
+}
+
+int get_cell(const World* world, int x, int y, Cell* out) {
+    if (out == NULL || !is_valid_position(world, x, y)) return 0;
+    
+    Chunk* chunk = get_chunk(world, x, y);
+    if (chunk == NULL) {
+        out->terrain = TERRAIN_EMPTY;
+        out->pheromone_food = PHEROMONE_INITIAL;
+        out->pheromone_home = PHEROMONE_INITIAL;
+        out->food_amount = 0;
+        out->colony_id = -1;
+        out->has_colony = 0;
+        out->has_food = 0;
+        return 1;
+    }
+    
+    // Pheromone is the total over every channel
+    int local = CHUNK_LOCAL(x, y);
+    out->terrain = CELL_TERRAIN(chunk->cell_bits[local]);
+    out->pheromone_food = PHEROMONE_INITIAL;
+    out->pheromone_home = PHEROMONE_INITIAL;
+    for (int k = 0; k < chunk->channel_count; k++) {
+        const PheromoneChannel* channel = chunk->channels[k];
+        out->pheromone_food += PHEROMONE_LEVEL(world, channel, channel->pheromone_food, local);
+        out->pheromone_home += PHEROMONE_LEVEL(world, channel, channel->pheromone_home, local);
+    }
+    out->food_amount = chunk->food_amount[local];
+    out->colony_id = CELL_COLONY(chunk->cell_bits[local]);
+    out->has_colony = (out->terrain == TERRAIN_NEST);
+    out->has_food = (out->terrain == TERRAIN_FOOD && out->food_amount > 0);
+    return 1;
+}
+
+// Overwrites a whole cell, used by the loaders. A cell's pheromone is the
+// shared trail, so worlds with private trails keep theirs. An empty cell in
+// an untouched chunk is left untouched. Returns 1 on success.
+int set_cell(World* world, int x, int y, const Cell* cell) {
+    if (cell == NULL || !is_valid_position(world, x, y)) return 0;
+    
+    int pheromone = !world->private_trails && (cell->pheromone_food != 0.0f || cell->pheromone_home != 0.0f);
+    Chunk* chunk = get_chunk(world, x, y);
+    if (chunk == NULL) {
+        if (cell->terrain == TERRAIN_EMPTY && cell->food_amount == 0 && !pheromone) {
+            return 1;
+        }
+        chunk = touch_chunk(world, x, y);
+        if (chunk == NULL) return 0;
+    }
+    
+    if (!world->private_trails &&
+        !set_cell_pheromone(world, x, y, PHEROMONE_SHARED, cell->pheromone_food, cell->pheromone_home)) {
+        return 0;
+    }
+    write_cell(world, chunk, x, y, cell->terrain, cell->colony_id, cell->food_amount);
+    return 1;
+}
+
+// Overwrites the levels of one cell in colony's channel (PHEROMONE_SHARED
+// for the shared one) and the halos mirroring it. Returns 1 on success.
+int set_cell_pheromone(World* world, int x, int y, int colony, float food, float home) {
+    if (!is_valid_position(world, x, y)) return 0;
+    
+    int pheromone = (food != 0.0f || home != 0.0f);
+    Chunk* chunk = pheromone ? touch_chunk(world, x, y) : get_chunk(world, x, y);
+    PheromoneChannel* channel = pheromone ? touch_pheromone_channel(world, chunk, colony)
+                                          : get_pheromone_channel(chunk, colony);
+    if (channel == NULL) return !pheromone;
+    
+    int local = CHUNK_LOCAL(x, y);
+    channel->pheromone_food[local] = PHEROMONE_PACK(food);
+    channel->pheromone_home[local] = PHEROMONE_PACK(home);
+    if (food > 0.0f || home > 0.0f) {
+        channel->pheromone_active = 1;
+    }
+    if (pheromone) {
+        widen_pheromone_box(channel, x & CHUNK_MASK, y & CHUNK_MASK);
+    }
+    stamp_pheromone(channel, local, world->current_step);
+    update_channel_halos(world, channel, x, y);
+    invalidate_pheromone_gradients(world);
+    return 1;
+}
+
+// Read from the food registry, O(1)
+long long count_remaining_food(const World* world) {
+    if (world == NULL) return 0;
+    return world->food_remaining;
+}
+
+// World position of a chunk's food source
+static Position food_source_position(const Chunk* chunk, int source) {
+    int index = chunk->food_sources[source];
+    Position pos;
+    pos.x = chunk->cx * CHUNK_SIZE + index % CHUNK_STRIDE - 1;
+    pos.y = chunk->cy * CHUNK_SIZE + index / CHUNK_STRIDE - 1;
+    return pos;
 }
 
-Cell* get_cell(const World* world, int x, int y) {
+// Squared distance from (x, y) to the nearest cell of chunk (cx, cy)
+static long long chunk_distance_sq(int x, int y, int cx, int cy) {
+    int left = cx * CHUNK_SIZE;
+    int top = cy * CHUNK_SIZE;
+    long long gap_x = (x < left) ? left - x : (x >= left + CHUNK_SIZE ? x - (left + CHUNK_SIZE - 1) : 0);
+    long long gap_y = (y < top) ? top - y : (y >= top + CHUNK_SIZE ? y - (top + CHUNK_SIZE - 1) : 0);
+    return gap_x * gap_x + gap_y * gap_y;
+}
+
+// Finds the food source closest to (x, y) by straight-line distance within
+// max_radius cells (negative for no limit). Chunks are searched in rings
+// around the start, stopping once no unsearched ring can hold anything
+// closer. Distances do not wrap in a toroidal world. Returns 1 and fills
+// out when a source was found.
+int find_nearest_food(const World* world, int x, int y, int max_radius, Position* out) {
+    if (world == NULL || out == NULL || world->food_source_count == 0) return 0;
+    
+    int start_cx = CHUNK_COORD(clamp_int(x, 0, world->width - 1));
+    int start_cy = CHUNK_COORD(clamp_int(y, 0, world->height - 1));
+    int max_ring = world->chunks_x > world->chunks_y ? world->chunks_x : world->chunks_y;
+    long long limit_sq = max_radius < 0 ? -1 : (long long)max_radius * max_radius;
+    long long best_sq = -1;
+    
+    for (int ring = 0; ring <= max_ring; ring++) {
+        // Every cell of ring r is at least (r - 1) chunks away
+        if (ring > 0) {
+            long long reach = (long long)(ring - 1) * CHUNK_SIZE + 1;
+            if (best_sq >= 0 && reach * reach > best_sq) break;
+            if (limit_sq >= 0 && reach * reach > limit_sq) break;
+        }
+        
+        for (int cy = start_cy - ring; cy <= start_cy + ring; cy++) {
+            // Interior rows only have the two side chunks
+            int step = (cy == start_cy - ring || cy == start_cy + ring) ? 1 : 2 * ring;
+            for (int cx = start_cx - ring; cx <= start_cx + ring; cx += step) {
+                const Chunk* chunk = get_chunk_at(world, cx, cy);
+                if (chunk == NULL || chunk->food_source_count == 0) continue;
+                
+                long long gap_sq = chunk_distance_sq(x, y, cx, cy);
+                if (best_sq >= 0 && gap_sq >= best_sq) continue;
+                if (limit_sq >= 0 && gap_sq > limit_sq) continue;
+                
+                for (int s = 0; s < chunk->food_source_count; s++) {
+                    Position pos = food_source_position(chunk, s);
+                    long long ddx = pos.x - x;
+                    long long ddy = pos.y - y;
+                    long long dist_sq = ddx * ddx + ddy * ddy;
+                    if (limit_sq >= 0 && dist_sq > limit_sq) continue;
+                    if (best_sq < 0 || dist_sq < best_sq) {
+                        best_sq = dist_sq;
+                        *out = pos;
+                    }
+                }
+            }
+        }
+    }
+    return best_sq >= 0;
+}
+
+// Collects up to max_results food sources within radius cells of (x, y),
+// in no particular order. Distances do not wrap in a toroidal world.
+// Returns the number of sources in range, which may exceed max_results.
+int find_food_in_radius(const World* world, int x, int y, int radius, Position* out, int max_results) {
+    if (world == NULL || radius < 0 || world->food_source_count == 0) return 0;
+    
+    long long radius_sq = (long long)radius * radius;
+    int first_cx = CHUNK_COORD(clamp_int(x - radius, 0, world->width - 1));
+    int last_cx = CHUNK_COORD(clamp_int(x + radius, 0, world->width - 1));
+    int first_cy = CHUNK_COORD(clamp_int(y - radius, 0, world->height - 1));
+    int last_cy = CHUNK_COORD(clamp_int(y + radius, 0, world->height - 1));
+    int found = 0;
+    
+    for (int cy = first_cy; cy <= last_cy; cy++) {
+        for (int cx = first_cx; cx <= last_cx; cx++) {
+            const Chunk* chunk = get_chunk_at(world, cx, cy);
+            if (chunk == NULL || chunk->food_source_count == 0) continue;
+            if (chunk_distance_sq(x, y, cx, cy) > radius_sq) continue;
+            
+            for (int s = 0; s < chunk->food_source_count; s++) {
+                Position pos = food_source_position(chunk, s);
+                long long ddx = pos.x - x;
+                long long ddy = pos.y - y;
+                if (ddx * ddx + ddy * ddy > radius_sq) continue;
+                if (out != NULL && found < max_results) out[found] = pos;
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+size_t get_world_memory_usage(const World* world) {
+    if (world == NULL) return 0;
+    
+    size_t directory = (size_t)world->chunks_x * (size_t)world->chunks_y;
+    size_t bytes = sizeof(World) + world->colony_count * sizeof(Colony);
+    bytes += 2 * directory * sizeof(Chunk*);
+    bytes += (size_t)world->chunk_count * (chunk_block_size() + GRID_PLANE_ALIGNMENT);
+    
+    size_t back_block = 2 * align_plane_size(CHUNK_PADDED_CELLS * sizeof(PheromoneValue)) + GRID_PLANE_ALIGNMENT;
+    for (int c = 0; c < world->chunk_count; c++) {
+        const Chunk* chunk = world->chunk_list[c];
+        bytes += (size_t)chunk->channel_capacity * sizeof(PheromoneChannel*);
+        if (chunk->walkable != NULL) {
+            const WalkableCells* walkable = chunk->walkable;
+            bytes += sizeof(WalkableCells) + 2 * CHUNK_PADDED_CELLS * sizeof(float) +
+                     (size_t)walkable->run_start[CHUNK_SIZE] * 2 * sizeof(uint16_t);
+        }
+        for (int k = 0; k < chunk->channel_count; k++) {
+            bytes += channel_block_size() + GRID_PLANE_ALIGNMENT;
+            const PheromoneChannel* channel = chunk->channels[k];
+            if (channel->back_block != NULL) bytes += back_block;
+            if (channel->gradient != NULL) bytes += 2 * CHUNK_PADDED_CELLS;
+            if (channel->sum_table != NULL) bytes += 2 * PHEROMONE_SUM_CELLS * sizeof(PheromoneSum);
+            bytes += (size_t)(channel->deposits[0].capacity + channel->deposits[1].capacity) *
+                     sizeof(PheromoneDeposit);
+        }
+    }
+    
+    for (int i = 0; i < world->colony_count; i++) {
+        bytes += get_ant_pool_memory_usage(&world->colonies[i].ants);
+    }
+    return bytes;
+}
+
+// Chunk directory
+Chunk* get_chunk_at(const World* world, int cx, int cy) {
+    if (world == NULL || cx < 0 || cx >= world->chunks_x || cy < 0 || cy >= world->chunks_y) {
+        return NULL;
+    }
+    return world->chunks[cy * world->chunks_x + cx];
+}
+
+Chunk* get_chunk(const World* world, int x, int y) {
+    if (!is_valid_position(world, x, y)) return NULL;
+    return world->chunks[CHUNK_COORD(y) * world->chunks_x + CHUNK_COORD(x)];
+}
+
+Chunk* touch_chunk_at(World* world, int cx, int cy) {
+    if (world == NULL || cx < 0 || cx >= world->chunks_x || cy < 0 || cy >= world->chunks_y) {
+        return NULL;
+    }
+    
+    Chunk* chunk = world->chunks[cy * world->chunks_x + cx];
+    if (chunk == NULL) {
+        chunk = allocate_chunk(world, cx, cy);
+    }
+    return chunk;
+}
+
+Chunk* touch_chunk(World* world, int x, int y) {
     if (!is_valid_position(world, x, y)) return NULL;
-    return &world->grid[y][x];
+    return touch_chunk_at(world, CHUNK_COORD(x), CHUNK_COORD(y));
+}
+
+// Neighbour chunk lookups that wrap around in a toroidal world
+Chunk* get_neighbor_chunk(const World* world, int cx, int cy) {
+    if (world->toroidal) {
+        cx = (cx + world->chunks_x) % world->chunks_x;
+        cy = (cy + world->chunks_y) % world->chunks_y;
+    }
+    return get_chunk_at(world, cx, cy);
+}
+
+Chunk* touch_neighbor_chunk(World* world, int cx, int cy) {
+    if (world->toroidal) {
+        cx = (cx + world->chunks_x) % world->chunks_x;
+        cy = (cy + world->chunks_y) % world->chunks_y;
+    }
+    return touch_chunk_at(world, cx, cy);
+}
+
+// Recomputes every walk mask of a chunk from its terrain and halo
+void rebuild_walk_masks(Chunk* chunk) {
+    if (chunk == NULL) return;
+    
+    for (int ly = 0; ly < chunk->rows; ly++) {
+        int row = CHUNK_PAD_INDEX(0, ly);
+        for (int i = row; i < row + chunk->cols; i++) {
+            chunk->walk_mask[i] = compute_walk_mask(chunk, i);
+        }
+    }
+    chunk->walk_version++;
+}
+
+// Recomputes the content count, food registry entries, pheromone flag and
+// walk masks after a chunk's planes were written directly (bulk loads). The
+// halo must already be up to date.
+void update_chunk_summary(World* world, Chunk* chunk) {
+    if (world == NULL || chunk == NULL) return;
+    
+    rebuild_walk_masks(chunk);
+    
+    world->food_remaining -= chunk->food_total;
+    world->food_source_count -= chunk->food_source_count;
+    chunk->food_total = 0;
+    chunk->food_source_count = 0;
+    chunk->content_cells = 0;
+    for (int ly = 0; ly < chunk->rows; ly++) {
+        int row = CHUNK_PAD_INDEX(0, ly);
+        for (int i = row; i < row + chunk->cols; i++) {
+            TerrainType terrain = CELL_TERRAIN(chunk->cell_bits[i]);
+            if (terrain != TERRAIN_EMPTY) chunk->content_cells++;
+            if (terrain == TERRAIN_FOOD) {
+                add_food_source(world, chunk, i);
+                chunk->food_total += chunk->food_amount[i];
+            }
+        }
+    }
+    world->food_remaining += chunk->food_total;
+    
+    for (int k = 0; k < chunk->channel_count; k++) {
+        PheromoneChannel* channel = chunk->channels[k];
+        channel->pheromone_active = 0;
+        clear_pheromone_box(&channel->pheromone_box);
+        for (int ly = -1; ly <= CHUNK_SIZE; ly++) {
+            for (int lx = -1; lx <= CHUNK_SIZE; lx++) {
+                int i = CHUNK_PAD_INDEX(lx, ly);
+                if (channel->pheromone_food[i] > 0.0f || channel->pheromone_home[i] > 0.0f) {
+                    channel->pheromone_active = 1;
+                }
+                if (channel->pheromone_food[i] != 0.0f || channel->pheromone_home[i] != 0.0f) {
+                    widen_pheromone_box(channel, lx, ly);
+                }
+            }
+        }
+        
+        // Directly written pheromone counts as written now
+        if (channel->pheromone_active && channel->last_pheromone_step < world->current_step) {
+            channel->last_pheromone_step = world->current_step;
+        }
+    }
+}
+
+// Records that cell i's pheromone was last written at step. Only lazy
+// evaporation builds keep the steps; elsewhere this does nothing.
+void stamp_pheromone(PheromoneChannel* channel, int i, int step) {
+#if PHEROMONE_LAZY_EVAPORATION
+    channel->pheromone_step[i] = step;
+    if (step > channel->last_pheromone_step) {
+        channel->last_pheromone_step = step;
+    }
+#else
+    (void)channel;
+    (void)i;
+    (void)step;
+#endif
+}
+
+// Empties a pheromone box
+void clear_pheromone_box(PheromoneBox* box) {
+    box->x0 = box->y0 = CHUNK_SIZE;
+    box->x1 = box->y1 = -1;
+}
+
+// Grows the channel's front pheromone box to cover local cell (lx, ly), which
+// may be in the halo. Call whenever a non-zero level is written outside the
+// pheromone update.
+void widen_pheromone_box(PheromoneChannel* channel, int lx, int ly) {
+    PheromoneBox* box = &channel->pheromone_box;
+    if (lx < box->x0) box->x0 = (int16_t)lx;
+    if (lx > box->x1) box->x1 = (int16_t)lx;
+    if (ly < box->y0) box->y0 = (int16_t)ly;
+    if (ly > box->y1) box->y1 = (int16_t)ly;
+}
+
+// Whether the box of a chunk's channel reaches its edge on the side of
+// direction (dx, dy), where the neighbour that way mirrors it
+static int box_reaches_edge(const Chunk* chunk, const PheromoneBox* box, int dx, int dy) {
+    if (box->x0 > box->x1) return 0;
+    if (dx < 0 && box->x0 > 0) return 0;
+    if (dx > 0 && box->x1 < chunk->cols - 1) return 0;
+    if (dy < 0 && box->y0 > 0) return 0;
+    if (dy > 0 && box->y1 < chunk->rows - 1) return 0;
+    return 1;
+}
+
+// Whether the neighbour of a channel's chunk in direction (nx, ny) mirrors
+// any of its pheromone: the box reaches that edge, and for a diagonal
+// neighbour the corner cell holds some
+int channel_reaches_neighbor(const PheromoneChannel* channel, int nx, int ny) {
+    const Chunk* chunk = channel->chunk;
+    if (!box_reaches_edge(chunk, &channel->pheromone_box, nx, ny)) return 0;
+    if (nx == 0 || ny == 0) return 1;
+    
+    int corner = CHUNK_PAD_INDEX((nx < 0) ? 0 : chunk->cols - 1, (ny < 0) ? 0 : chunk->rows - 1);
+    return channel->pheromone_food[corner] != 0 || channel->pheromone_home[corner] != 0;
+}
+
+// Gives the chunk a channel for every colony whose pheromone may reach its
+// halo, by the same test the pheromone update uses
+static void attach_neighbor_channels(World* world, Chunk* chunk) {
+    for (int ny = -1; ny <= 1; ny++) {
+        for (int nx = -1; nx <= 1; nx++) {
+            if (nx == 0 && ny == 0) continue;
+            const Chunk* near = get_neighbor_chunk(world, chunk->cx + nx, chunk->cy + ny);
+            if (near == NULL) continue;
+            
+            for (int k = 0; k < near->channel_count; k++) {
+                const PheromoneChannel* channel = near->channels[k];
+                if (channel_reaches_neighbor(channel, -nx, -ny)) {
+                    touch_pheromone_channel(world, chunk, channel->colony);
+                }
+            }
+        }
+    }
+}
+
+// Rewrites the chunk's halo ring from the cells it mirrors: the edge cells
+// of the neighbouring chunks, the opposite world edge in a toroidal world,
+// or wall with zero pheromone past the world edge. For a chunk cut short by
+// the world edge the ring sits just outside its in-world cells. Channels
+// are added for the colonies whose pheromone the ring picks up.
+void refresh_chunk_halo(World* world, Chunk* chunk) {
+    if (world == NULL || chunk == NULL) return;
+    
+    int origin_x = chunk->cx * CHUNK_SIZE;
+    int origin_y = chunk->cy * CHUNK_SIZE;
+    
+    for (int ly = -1; ly <= chunk->rows; ly++) {
+        // Rows between the top and bottom ring only have the two side cells
+        int step = (ly == -1 || ly == chunk->rows) ? 1 : chunk->cols + 1;
+        for (int lx = -1; lx <= chunk->cols; lx += step) {
+            int x = origin_x + lx;
+            int y = origin_y + ly;
+            uint16_t bits = CELL_PACK(TERRAIN_WALL, -1);
+            
+            if (wrap_position(world, &x, &y)) {
+                Chunk* source = get_chunk(world, x, y);
+                bits = (source != NULL) ? source->cell_bits[CHUNK_LOCAL(x, y)] : CELL_PACK(TERRAIN_EMPTY, -1);
+            }
+            chunk->cell_bits[CHUNK_PAD_INDEX(lx, ly)] = bits;
+        }
+    }
+    
+    attach_neighbor_channels(world, chunk);
+    for (int k = 0; k < chunk->channel_count; k++) {
+        if (refresh_channel_halo(world, chunk->channels[k])) {
+            chunk->channels[k]->pheromone_active = 1;
+        }
+    }
+}
+
+// The pheromone part of the above for one channel, mirroring the same
+// colony's channels of the neighbours. Returns whether any halo cell holds
+// pheromone.
+int refresh_channel_halo(World* world, PheromoneChannel* channel) {
+    if (world == NULL || channel == NULL) return 0;
+    
+    const Chunk* chunk = channel->chunk;
+    int origin_x = chunk->cx * CHUNK_SIZE;
+    int origin_y = chunk->cy * CHUNK_SIZE;
+    int any_pheromone = 0;
+    
+    // Consecutive ring cells mostly share a source chunk
+    const Chunk* source = NULL;
+    const PheromoneChannel* mirrored = NULL;
+    
+    for (int ly = -1; ly <= chunk->rows; ly++) {
+        int step = (ly == -1 || ly == chunk->rows) ? 1 : chunk->cols + 1;
+        for (int lx = -1; lx <= chunk->cols; lx += step) {
+            int x = origin_x + lx;
+            int y = origin_y + ly;
+            PheromoneValue food = 0;
+            PheromoneValue home = 0;
+            int written = world->current_step;
+            
+            if (wrap_position(world, &x, &y)) {
+                const Chunk* near = get_chunk(world, x, y);
+                if (near != source) {
+                    source = near;
+                    mirrored = get_pheromone_channel(near, channel->colony);
+                }
+                if (mirrored != NULL) {
+                    int i = CHUNK_LOCAL(x, y);
+                    food = mirrored->pheromone_food[i];
+                    home = mirrored->pheromone_home[i];
+                    if (mirrored->pheromone_step != NULL) written = mirrored->pheromone_step[i];
+                }
+            }
+            
+            int slot = CHUNK_PAD_INDEX(lx, ly);
+            channel->pheromone_food[slot] = food;
+            channel->pheromone_home[slot] = home;
+            if (food != 0.0f || home != 0.0f) {
+                stamp_pheromone(channel, slot, written);
+                widen_pheromone_box(channel, lx, ly);
+                any_pheromone = 1;
+            }
+        }
+    }
+    return any_pheromone;
+}
+
+// A halo slot that mirrors some cell
+typedef struct HaloImage {
+    Chunk* chunk;
+    int hx;                  // Chunk-local position in the ring
+    int hy;
+} HaloImage;
+
+#define MAX_HALO_IMAGES 16   // 4 images of a corner cell, each in up to 4 rings
+
+// Finds every halo slot that mirrors cell (x, y). Only cells on the edge of
+// their chunk are mirrored anywhere. Returns the number found.
+static int find_halo_images(const World* world, const Chunk* source, int x, int y, HaloImage* found) {
+    int lx = x & CHUNK_MASK;
+    int ly = y & CHUNK_MASK;
+    if (lx != 0 && ly != 0 && lx != source->cols - 1 && ly != source->rows - 1) return 0;
+    
+    // The cell itself, plus its images past the opposite edges when wrapping
+    int images_x[3] = {x}, images_y[3] = {y};
+    int count_x = 1, count_y = 1;
+    if (world->toroidal) {
+        if (x == 0) images_x[count_x++] = world->width;
+        if (x == world->width - 1) images_x[count_x++] = -1;
+        if (y == 0) images_y[count_y++] = world->height;
+        if (y == world->height - 1) images_y[count_y++] = -1;
+    }
+    
+    int count = 0;
+    for (int iy = 0; iy < count_y; iy++) {
+        for (int ix = 0; ix < count_x; ix++) {
+            int image_x = images_x[ix];
+            int image_y = images_y[iy];
+            
+            // Chunks whose ring can contain the image
+            int first_cx = CHUNK_COORD(clamp_int(image_x - 1, 0, world->width - 1));
+            int last_cx = CHUNK_COORD(clamp_int(image_x + 1, 0, world->width - 1));
+            int first_cy = CHUNK_COORD(clamp_int(image_y - 1, 0, world->height - 1));
+            int last_cy = CHUNK_COORD(clamp_int(image_y + 1, 0, world->height - 1));
+            
+            for (int cy = first_cy; cy <= last_cy; cy++) {
+                for (int cx = first_cx; cx <= last_cx; cx++) {
+                    Chunk* chunk = get_chunk_at(world, cx, cy);
+                    if (chunk == NULL) continue;
+                    
+                    int hx = image_x - cx * CHUNK_SIZE;
+                    int hy = image_y - cy * CHUNK_SIZE;
+                    if (hx < -1 || hx > chunk->cols || hy < -1 || hy > chunk->rows) continue;
+                    if (hx >= 0 && hx < chunk->cols && hy >= 0 && hy < chunk->rows) continue;
+                    
+                    found[count].chunk = chunk;
+                    found[count].hx = hx;
+                    found[count].hy = hy;
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// Copies cell local of a channel into the same colony's channel at each
+// image, adding the channel where the level is non-zero
+static void copy_channel_images(World* world, const PheromoneChannel* source, int local,
+                                const HaloImage* images, int count) {
+    PheromoneValue food = source->pheromone_food[local];
+    PheromoneValue home = source->pheromone_home[local];
+    int written = (source->pheromone_step != NULL) ? source->pheromone_step[local] : world->current_step;
+    int pheromone = (food != 0.0f || home != 0.0f);
+    
+    for (int n = 0; n < count; n++) {
+        PheromoneChannel* channel = pheromone ? touch_pheromone_channel(world, images[n].chunk, source->colony)
+                                              : get_pheromone_channel(images[n].chunk, source->colony);
+        if (channel == NULL) continue;
+        
+        int slot = CHUNK_PAD_INDEX(images[n].hx, images[n].hy);
+        channel->pheromone_food[slot] = food;
+        channel->pheromone_home[slot] = home;
+        stamp_pheromone(channel, slot, written);
+        if (pheromone) {
+            channel->pheromone_active = 1;
+            widen_pheromone_box(channel, images[n].hx, images[n].hy);
+        }
+    }
+}
+
+// Copies cell (x, y), terrain and every channel, into every halo slot that
+// mirrors it. Call after writing a cell.
+void update_cell_halos(World* world, int x, int y) {
+    Chunk* source = get_chunk(world, x, y);
+    if (source == NULL) return;
+    
+    HaloImage images[MAX_HALO_IMAGES];
+    int count = find_halo_images(world, source, x, y, images);
+    if (count == 0) return;
+    
+    int local = CHUNK_LOCAL(x, y);
+    for (int n = 0; n < count; n++) {
+        images[n].chunk->cell_bits[CHUNK_PAD_INDEX(images[n].hx, images[n].hy)] = source->cell_bits[local];
+    }
+    for (int k = 0; k < source->channel_count; k++) {
+        copy_channel_images(world, source->channels[k], local, images, count);
+    }
+}
+
+// The same for one channel's levels only, after a deposit
+void update_channel_halos(World* world, const PheromoneChannel* channel, int x, int y) {
+    HaloImage images[MAX_HALO_IMAGES];
+    int count = find_halo_images(world, channel->chunk, x, y, images);
+    copy_channel_images(world, channel, CHUNK_LOCAL(x, y), images, count);
+}
+
+// Switches edge wrapping on or off and rebuilds every halo to match
+void set_world_toroidal(World* world, int toroidal) {
+    if (world == NULL) return;
+    
+    world->toroidal = toroidal ? 1 : 0;
+    for (int c = 0; c < world->chunk_count; c++) {
+        Chunk* chunk = world->chunk_list[c];
+        refresh_chunk_halo(world, chunk);
+        rebuild_walk_masks(chunk);
+    }
+}
+
+// Frees chunks that have held no terrain, no pheromone and no ant for
+// CHUNK_RELEASE_DELAY consecutive calls, and the pheromone channels of
+// every chunk that no longer hold any. Called once per step after the
+// pheromone update.
+void release_idle_chunks(World* world) {
+    if (world == NULL) return;
+    
+    int c = 0;
+    while (c < world->chunk_count) {
+        Chunk* chunk = world->chunk_list[c];
+        release_empty_channels(chunk);
+        if (chunk->content_cells > 0 || chunk->channel_count > 0 ||
+            chunk->last_ant_step == world->current_step) {
+            chunk->idle_sweeps = 0;
+            c++;
+            continue;
+        }
+        
+        if (++chunk->idle_sweeps < CHUNK_RELEASE_DELAY) {
+            c++;
+            continue;
+        }
+        
+        // The last chunk moves into slot c, so c is revisited
+        release_chunk(world, chunk);
+    }
+}
+
+// Forgets every territory claim, as on a simulation reset
+void clear_territory(World* world) {
+    if (world == NULL) return;
+    
+    for (int c = 0; c < world->chunk_count; c++) {
+        Chunk* chunk = world->chunk_list[c];
+        for (int i = 0; i < CHUNK_PADDED_CELLS; i++) {
+            chunk->territory[i] = -1;
+        }
+    }
+    for (int i = 0; i < world->colony_count; i++) {
+        world->colonies[i].territory_size = 0;
+    }
 }
 
 // World initialization
@@ -230,33 +1329,34 @@ void initialize_world_random(World* world) {
     print_info("Initializing world with random obstacles...");
     
     // Add some random obstacles - ensure at least minimum for small worlds
-    int total_cells = world->width * world->height;
-    int obstacle_count = (total_cells + 19) / 20; // Ceiling division for 5%
+    long long total_cells = (long long)world->width * world->height;
+    long long obstacle_count = (total_cells + 19) / 20; // Ceiling division for 5%
     
     // Ensure minimum obstacles for gameplay
     if (obstacle_count < MIN_OBSTACLES_COUNT) obstacle_count = MIN_OBSTACLES_COUNT;
     if (obstacle_count > total_cells / 4) obstacle_count = total_cells / 4; // Max 25%
     
-    for (int i = 0; i < obstacle_count; i++) {
+    for (long long i = 0; i < obstacle_count; i++) {
         int x = random_int(0, world->width - 1);
         int y = random_int(0, world->height - 1);
         
         // Don't place obstacles on edges or where colonies will be
         if (x > 0 && x < world->width - 1 && y > 0 && y < world->height - 1) {
-            if (world->grid[y][x].terrain == TERRAIN_EMPTY) {
+            if (get_terrain(world, x, y) == TERRAIN_EMPTY) {
                 place_obstacle(world, x, y);
             }
         }
     }
     
-    // Add some random food sources
-    int food_count = random_int(3, 8);
+    // Add some random food sources, one batch per FOOD_SOURCE_AREA cells
+    long long food_batches = (total_cells + FOOD_SOURCE_AREA - 1) / FOOD_SOURCE_AREA;
+    long long food_count = random_int(3, 8) * food_batches;
     
-    for (int i = 0; i < food_count; i++) {
+    for (long long i = 0; i < food_count; i++) {
         int x = random_int(0, world->width - 1);
         int y = random_int(0, world->height - 1);
         
-        if (world->grid[y][x].terrain == TERRAIN_EMPTY) {
+        if (get_terrain(world, x, y) == TERRAIN_EMPTY) {
             int amount = random_int(20, 100);
             place_food(world, x, y, amount);
         }
@@ -327,6 +1427,8 @@ void spawn_initial_ants(World* world) {
                   i, INITIAL_ANTS_PER_COLONY, 
                   colony->nest_pos.x, colony->nest_pos.y);
     }
+    
+    build_ant_index(world);
 }
 
 void update_colony_statistics(World* world) {
@@ -335,17 +1437,10 @@ void update_colony_statistics(World* world) {
     for (int i = 0; i < world->colony_count; i++) {
         Colony* colony = &world->colonies[i];
         
-        // Count active ants
-        int active_count = 0;
-        Ant* current = colony->ants_head;
-        while (current != NULL) {
-            if (!(current->state & ANT_STATE_DEAD)) {
-                active_count++;
-            }
-            current = current->next;
-        }
-        
-        colony->active_ants = active_count;
+        // Ant counts and territory are kept by the events themselves; only
+        // the derived figures are computed here
+        colony->total_distance_traveled = (float)(colony->straight_moves +
+                                                  colony->diagonal_moves * 1.41421356);
         
         // Calculate efficiency score
         if (colony->total_ants > 0) {
@@ -2,6 +2,48 @@
 #define WORLD_H
 
 #include "data_structures.h"
+#include "config.h"
+#include <stddef.h>
+
+// Chunk planes are CHUNK_STRIDE wide: the CHUNK_SIZE cells plus a halo cell
+// on each side. CHUNK_PAD_INDEX takes chunk-local coordinates in -1..CHUNK_SIZE.
+#define CHUNK_STRIDE (CHUNK_SIZE + 2)
+#define CHUNK_PADDED_CELLS (CHUNK_STRIDE * CHUNK_STRIDE)
+#define CHUNK_PAD_INDEX(lx, ly) (((ly) + 1) * CHUNK_STRIDE + (lx) + 1)
+
+// Chunk coordinate of a cell coordinate, a cell's plane index inside its
+// chunk, and the plane offset of a neighbour at (dx, dy)
+#define CHUNK_COORD(v) ((v) >> CHUNK_SHIFT)
+#define CHUNK_LOCAL(x, y) CHUNK_PAD_INDEX((x) & CHUNK_MASK, (y) & CHUNK_MASK)
+#define CHUNK_OFFSET(dx, dy) ((dy) * CHUNK_STRIDE + (dx))
+
+// Plane offsets of the 8 directions, in the order of the dx/dy tables
+extern const int neighbor_offset[8];
+
+// Packed cell word: the terrain in the low CELL_TERRAIN_BITS bits, the
+// owning colony of a nest plus one above them (0 = no colony)
+#define CELL_TERRAIN_BITS 3
+#define CELL_PACK(terrain, colony) ((uint16_t)((terrain) | (((colony) + 1) << CELL_TERRAIN_BITS)))
+#define CELL_TERRAIN(bits) ((TerrainType)((bits) & ((1 << CELL_TERRAIN_BITS) - 1)))
+#define CELL_COLONY(bits) ((int)((bits) >> CELL_TERRAIN_BITS) - 1)
+#define CELL_MAX_COLONIES ((1 << (16 - CELL_TERRAIN_BITS)) - 1)
+#define CELL_MAX_FOOD 65535     // Food amounts are stored in 16 bits
+
+// Stored pheromone levels. Fixed-point builds keep 16-bit multiples of
+// 1/PHEROMONE_FIXED_SCALE: PHEROMONE_PACK clamps a level to 0..PHEROMONE_MAX
+// and rounds it to nearest, PHEROMONE_UNPACK gives the level back. Float
+// builds store levels as they are.
+#if PHEROMONE_FIXED_POINT
+#include <math.h>
+#define PHEROMONE_PACK(level) \
+    ((PheromoneValue)(fminf(fmaxf((level), 0.0f), PHEROMONE_MAX) * PHEROMONE_FIXED_SCALE + 0.5f))
+#define PHEROMONE_UNPACK(value) ((float)(value) * (1.0f / PHEROMONE_FIXED_SCALE))
+#else
+#define PHEROMONE_PACK(level) (level)
+#define PHEROMONE_UNPACK(value) (value)
+#endif
+
+#define TERRAIN_IS_WALKABLE(t) ((t) == TERRAIN_EMPTY || (t) == TERRAIN_FOOD || (t) == TERRAIN_NEST)
 
 // World creation and destruction
 World* create_world(int width, int height, int colony_count);
@@ -9,14 +51,51 @@ void destroy_world(World* world);
 
 // World manipulation
 void place_colony(World* world, int colony_id, int x, int y);
+void place_colonies_evenly(World* world);
+int get_colony_capacity(int width, int height);
 void place_food(World* world, int x, int y, int amount);
 void place_obstacle(World* world, int x, int y);
 void clear_cell(World* world, int x, int y);
+int take_food(World* world, int x, int y);
 
 // World queries
 int is_valid_position(const World* world, int x, int y);
 int is_walkable(const World* world, int x, int y);
-Cell* get_cell(const World* world, int x, int y);
+int wrap_position(const World* world, int* x, int* y);
+int get_cell(const World* world, int x, int y, Cell* out);
+int set_cell(World* world, int x, int y, const Cell* cell);
+int set_cell_pheromone(World* world, int x, int y, int colony, float food, float home);
+TerrainType get_terrain(const World* world, int x, int y);
+long long count_remaining_food(const World* world);
+int find_nearest_food(const World* world, int x, int y, int max_radius, Position* out);
+int find_food_in_radius(const World* world, int x, int y, int radius, Position* out, int max_results);
+size_t get_world_memory_usage(const World* world);
+
+// Chunk directory
+Chunk* get_chunk(const World* world, int x, int y);     // NULL if untouched
+Chunk* get_chunk_at(const World* world, int cx, int cy);
+Chunk* touch_chunk(World* world, int x, int y);          // Allocates on first touch
+Chunk* touch_chunk_at(World* world, int cx, int cy);
+Chunk* get_neighbor_chunk(const World* world, int cx, int cy);  // Wraps in a toroidal world
+Chunk* touch_neighbor_chunk(World* world, int cx, int cy);
+void update_chunk_summary(World* world, Chunk* chunk);
+void rebuild_walk_masks(Chunk* chunk);
+void refresh_chunk_halo(World* world, Chunk* chunk);
+void update_cell_halos(World* world, int x, int y);
+
+// Pheromone channels
+PheromoneChannel* get_pheromone_channel(const Chunk* chunk, int colony);   // NULL if none
+PheromoneChannel* touch_pheromone_channel(World* world, Chunk* chunk, int colony);
+int reserve_pheromone_buffers(PheromoneChannel* channel);
+void stamp_pheromone(PheromoneChannel* channel, int i, int step);
+void clear_pheromone_box(PheromoneBox* box);
+void widen_pheromone_box(PheromoneChannel* channel, int lx, int ly);
+int refresh_channel_halo(World* world, PheromoneChannel* channel);
+void update_channel_halos(World* world, const PheromoneChannel* channel, int x, int y);
+int channel_reaches_neighbor(const PheromoneChannel* channel, int nx, int ny);
+void set_world_toroidal(World* world, int toroidal);
+void release_idle_chunks(World* world);
+void clear_territory(World* world);
 
 // World initialization
 void initialize_world_random(World* world);